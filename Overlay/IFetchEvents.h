@@ -54,6 +54,14 @@ public:
     virtual std::string getTreeName()   const = 0;
     virtual std::string getBranchName() const = 0;
 
+    /// Retrieve the storage format of the files ("object", "columnar" or "snapshot")
+    virtual std::string getFormat()     const {return "object";}
+
+    /// Access to the bins by index, for looking ahead to neighbouring bins
+    virtual int getNumBins()            const {return 0;}
+    virtual int getCurrentBinIndex()    const {return -1;}
+    virtual std::vector<std::string> getFilesByIndex(int) const {return std::vector<std::string>();}
+
 private:
     friend class XmlFetchEvents;
 
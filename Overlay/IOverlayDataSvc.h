@@ -21,6 +21,10 @@ Aims to provide the abstract interface to the Overlay Data service
 */
 
 class EventOverlay;
+class OverlayColumns;
+class OverlayEventView;
+class OverlaySnapshot;
+class OverlayReadCuts;
 
 //static const InterfaceID IID_IOverlayDataSvc("IOverlayDataSvc", 1 , 0);
 
@@ -31,16 +35,55 @@ public:
     // Retrieve interface ID
 //    static const InterfaceID& interfaceID() { return IID_IOverlayDataSvc; }
 	/// InterfaceID
-	DeclareInterfaceID(IOverlayDataSvc, 1, 0);
+	DeclareInterfaceID(IOverlayDataSvc, 1, 7);
 
     /** @brief Get pointer to a Root DigiEvent object
     */
     virtual EventOverlay* getRootEventOverlay() = 0;
 
+    /** @brief Get pointer to the Tkr, Cal and Acd columns if the input is a columnar library, 
+               otherwise zero
+    */
+    virtual const OverlayColumns* getOverlayColumns() = 0;
+
+    /** @brief Get pointer to the Tkr, Cal and Acd records if the input is a snapshot library, 
+               otherwise zero
+    */
+    virtual const OverlaySnapshot* getOverlaySnapshot() = 0;
+
+    /** @brief Get the structure of arrays view of the Tkr, Cal and Acd data of the current input 
+               event (read cuts applied), zero if there is no input event
+    */
+    virtual const OverlayEventView* getOverlayEventView() = 0;
+
+    /** @brief Declare the subsystems and cuts of a consumer of the input, called at initialize
+    */
+    virtual void declareReadCuts(const OverlayReadCuts& cuts) = 0;
+
+    /** @brief Get the combined cuts the converters apply when building the TDS objects
+    */
+    virtual const OverlayReadCuts& getReadCuts() const = 0;
+
+    /** @brief Counter incremented at the start of each event, lets clients know when objects 
+               they found in the service are gone
+    */
+    virtual unsigned long getEventGeneration() const = 0;
+
+    /** @brief With ReuseOverlayTree set, prepare the overlay section of the TDS built in an earlier
+               event for the current one in place (input: refilled from the new input event, 
+               output: emptied). Returns failure if the caller must set the root as usual
+    */
+    virtual StatusCode refillOverlayTree() = 0;
+
     /** @brief select an event and copy the contents to the output tree
     */
     virtual StatusCode selectNextEvent() = 0;
 
+    /** @brief start reading the next event in the background (if supported), 
+               getRootEventOverlay will wait for it to complete
+    */
+    virtual StatusCode prefetchEvent() = 0;
+
     /** @brief Register a path with an output data service
     */
     virtual StatusCode registerOutputPath(const std::string& path) = 0;
@@ -0,0 +1,115 @@
+/** @file OverlayColumns.h
+
+    @brief declaration of the OverlayColumns class, the columnar layout of overlay libraries
+
+$Header$
+
+*/
+
+#ifndef OverlayColumns_h
+#define OverlayColumns_h
+
+#include <vector>
+
+/** @class OverlayColumns
+    @brief Flat, per subsystem, columns holding the Tkr, Cal and Acd overlay data of one event
+
+    In a columnar overlay library each of these columns is stored in its own branch of the tree,
+    alongside the usual EventOverlay branch which then carries only the event level, Gem, Pt and
+    diagnostic information (its Tkr, Cal and Acd collections are empty). Each subsystem has one 
+    row per overlay object, the Tkr strips of row i are tkrStrips[tkrStripOffset[i]] to 
+    tkrStrips[tkrStripOffset[i+1]-1].
+
+    Libraries in this format are selected by the format="columnar" attribute of the <file> 
+    element in the input xml catalog, and written by OverlayDataSvc with OutputFormat "columnar".
+*/
+class OverlayColumns
+{
+public:
+    OverlayColumns() {}
+    ~OverlayColumns() {}
+
+    /// Empty all columns
+    void clear()
+    {
+        tkrTowerX.clear(); tkrTowerY.clear(); tkrBilayer.clear(); tkrView.clear();
+        tkrToT0.clear(); tkrToT1.clear(); tkrLastC0Strip.clear(); tkrStripOffset.clear(); tkrStrips.clear();
+
+        calTower.clear(); calLayer.clear(); calColumn.clear(); calEnergy.clear();
+        calPosX.clear(); calPosY.clear(); calPosZ.clear(); calStatus.clear();
+
+        acdVolId.clear(); acdVolIdSize.clear(); acdEnergy.clear(); 
+        acdPosX.clear(); acdPosY.clear(); acdPosZ.clear(); acdStatus.clear();
+    }
+
+    /// Number of rows for each subsystem
+    unsigned int numTkr() const {return tkrBilayer.size();}
+    unsigned int numCal() const {return calEnergy.size();}
+    unsigned int numAcd() const {return acdEnergy.size();}
+
+    /**@brief Call visitor(branchName, column) for every column, used to set up the branches
+
+       The visitor must provide a templated operator()(const char*, std::vector<T>&)
+    */
+    template <class Visitor> void visit(Visitor& visitor)
+    {
+        visitor("TkrTowerX",      tkrTowerX);
+        visitor("TkrTowerY",      tkrTowerY);
+        visitor("TkrBilayer",     tkrBilayer);
+        visitor("TkrView",        tkrView);
+        visitor("TkrToT0",        tkrToT0);
+        visitor("TkrToT1",        tkrToT1);
+        visitor("TkrLastC0Strip", tkrLastC0Strip);
+        visitor("TkrStripOffset", tkrStripOffset);
+        visitor("TkrStrips",      tkrStrips);
+
+        visitor("CalTower",       calTower);
+        visitor("CalLayer",       calLayer);
+        visitor("CalColumn",      calColumn);
+        visitor("CalEnergy",      calEnergy);
+        visitor("CalPosX",        calPosX);
+        visitor("CalPosY",        calPosY);
+        visitor("CalPosZ",        calPosZ);
+        visitor("CalStatus",      calStatus);
+
+        visitor("AcdVolId",       acdVolId);
+        visitor("AcdVolIdSize",   acdVolIdSize);
+        visitor("AcdEnergy",      acdEnergy);
+        visitor("AcdPosX",        acdPosX);
+        visitor("AcdPosY",        acdPosY);
+        visitor("AcdPosZ",        acdPosZ);
+        visitor("AcdStatus",      acdStatus);
+    }
+
+    // Tracker: one row per TkrOverlay
+    std::vector<short>              tkrTowerX;
+    std::vector<short>              tkrTowerY;
+    std::vector<short>              tkrBilayer;
+    std::vector<short>              tkrView;         ///< 0 = X, 1 = Y
+    std::vector<short>              tkrToT0;
+    std::vector<short>              tkrToT1;
+    std::vector<short>              tkrLastC0Strip;
+    std::vector<unsigned int>       tkrStripOffset;  ///< numTkr() + 1 entries
+    std::vector<unsigned short>     tkrStrips;
+
+    // Calorimeter: one row per CalOverlay
+    std::vector<short>              calTower;
+    std::vector<short>              calLayer;
+    std::vector<short>              calColumn;
+    std::vector<float>              calEnergy;
+    std::vector<float>              calPosX;
+    std::vector<float>              calPosY;
+    std::vector<float>              calPosZ;
+    std::vector<unsigned int>       calStatus;
+
+    // ACD: one row per AcdOverlay, the AcdId is derived from the volume identifier
+    std::vector<unsigned long long> acdVolId;
+    std::vector<unsigned short>     acdVolIdSize;
+    std::vector<float>              acdEnergy;
+    std::vector<float>              acdPosX;
+    std::vector<float>              acdPosY;
+    std::vector<float>              acdPosZ;
+    std::vector<unsigned int>       acdStatus;
+};
+
+#endif
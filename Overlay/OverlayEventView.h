@@ -0,0 +1,89 @@
+/** @file OverlayEventView.h
+
+    @brief declaration of the OverlayEventView class, a structure of arrays view of an overlay event
+
+$Header$
+
+*/
+
+#ifndef OverlayEventView_h
+#define OverlayEventView_h
+
+#include <vector>
+
+/** @class OverlayEventView
+    @brief Contiguous, per subsystem, arrays holding the Tkr, Cal and Acd overlay data of the
+           current input event, for the merge kernels
+
+    The view is filled by the overlay data service straight from its input (an EventOverlay, the
+    columns of a columnar library or the records of a snapshot library) with the declared read cuts
+    applied, the first time it is asked for in an event. A merge algorithm streaming through the
+    view never touches the TDS collections, which are then not built at all. The values are those
+    the TDS objects would have: positions and energies as doubles, the idents fields as shorts.
+
+    Each subsystem has one row per overlay object, the Tkr strips of row i are
+    tkrStrips[tkrStripOffset[i]] to tkrStrips[tkrStripOffset[i+1]-1]. The arrays keep their memory
+    from one event to the next.
+*/
+class OverlayEventView
+{
+public:
+    OverlayEventView() {clear();}
+    ~OverlayEventView() {}
+
+    /// Empty all arrays
+    void clear()
+    {
+        tkrTowerX.clear(); tkrTowerY.clear(); tkrBilayer.clear(); tkrView.clear();
+        tkrToT0.clear(); tkrToT1.clear(); tkrLastC0Strip.clear(); tkrStripOffset.clear(); tkrStrips.clear();
+
+        calTower.clear(); calLayer.clear(); calColumn.clear(); calEnergy.clear();
+        calPosX.clear(); calPosY.clear(); calPosZ.clear(); calStatus.clear();
+
+        acdVolId.clear(); acdVolIdSize.clear(); acdLayer.clear(); acdFace.clear(); acdRow.clear();
+        acdColumn.clear(); acdEnergy.clear(); acdPosX.clear(); acdPosY.clear(); acdPosZ.clear(); acdStatus.clear();
+
+        tkrStripOffset.push_back(0);
+    }
+
+    /// Number of rows for each subsystem
+    unsigned int numTkr() const {return tkrBilayer.size();}
+    unsigned int numCal() const {return calEnergy.size();}
+    unsigned int numAcd() const {return acdEnergy.size();}
+
+    // Tracker: one row per TkrOverlay
+    std::vector<short>              tkrTowerX;
+    std::vector<short>              tkrTowerY;
+    std::vector<short>              tkrBilayer;
+    std::vector<short>              tkrView;         ///< 0 = X, 1 = Y
+    std::vector<short>              tkrToT0;
+    std::vector<short>              tkrToT1;
+    std::vector<short>              tkrLastC0Strip;
+    std::vector<unsigned int>       tkrStripOffset;  ///< numTkr() + 1 entries
+    std::vector<unsigned short>     tkrStrips;
+
+    // Calorimeter: one row per CalOverlay
+    std::vector<short>              calTower;
+    std::vector<short>              calLayer;
+    std::vector<short>              calColumn;
+    std::vector<double>             calEnergy;
+    std::vector<double>             calPosX;
+    std::vector<double>             calPosY;
+    std::vector<double>             calPosZ;
+    std::vector<unsigned int>       calStatus;
+
+    // ACD: one row per AcdOverlay, with the volume identifier and the AcdId fields
+    std::vector<unsigned long long> acdVolId;
+    std::vector<unsigned short>     acdVolIdSize;
+    std::vector<short>              acdLayer;
+    std::vector<short>              acdFace;
+    std::vector<short>              acdRow;
+    std::vector<short>              acdColumn;
+    std::vector<double>             acdEnergy;
+    std::vector<double>             acdPosX;
+    std::vector<double>             acdPosY;
+    std::vector<double>             acdPosZ;
+    std::vector<unsigned int>       acdStatus;
+};
+
+#endif
@@ -0,0 +1,138 @@
+/** @file OverlayReadCuts.h
+
+    @brief declaration of the OverlayReadCuts class, selections applied while building the overlay TDS
+
+$Header$
+
+*/
+
+#ifndef OverlayReadCuts_h
+#define OverlayReadCuts_h
+
+#include <sstream>
+#include <string>
+
+/** @class OverlayReadCuts
+    @brief Subsystems and cuts declared by the consumers of an overlay input
+
+    Each merge algorithm declares at initialize, through IOverlayDataSvc::declareReadCuts, which
+    subsystems it uses and which objects it would drop anyway. The data service combines the
+    declarations into the loosest selection satisfying all of them, and the converters apply it
+    while reading so rejected objects are never built. Until something is declared everything
+    is accepted.
+
+    The energy thresholds follow the convention of the merge algorithms: a value above zero
+    rejects objects with a smaller energy, zero or below disables the cut.
+*/
+class OverlayReadCuts
+{
+public:
+    enum Subsystem {Tkr = 1, Cal = 2, Acd = 4};
+
+    OverlayReadCuts() : m_declared(false),
+                        m_subsystems(0),
+                        m_calEnergyThreshold(-1.),
+                        m_acdEnergyThreshold(-1.),
+                        m_acdTilesOnly(false)
+    {}
+
+    ~OverlayReadCuts() {}
+
+    /// Used by consumers to build their declaration
+    void needSubsystem(Subsystem subsystem)  {m_declared = true; m_subsystems |= subsystem;}
+    void setCalEnergyThreshold(double value) {m_calEnergyThreshold = value;}
+    void setAcdEnergyThreshold(double value) {m_acdEnergyThreshold = value;}
+    void setAcdTilesOnly(bool tilesOnly)     {m_acdTilesOnly = tilesOnly;}
+
+    /// Combine with another declaration, keeping whatever either of them needs
+    void combine(const OverlayReadCuts& other)
+    {
+        if (!other.m_declared) return;
+
+        if (!m_declared)
+        {
+            *this = other;
+            return;
+        }
+
+        // Cuts of a subsystem are only relaxed by a declaration which uses that subsystem
+        if (other.needs(Cal))
+        {
+            if (!needs(Cal)) m_calEnergyThreshold = other.m_calEnergyThreshold;
+            else             m_calEnergyThreshold = loosest(m_calEnergyThreshold, other.m_calEnergyThreshold);
+        }
+
+        if (other.needs(Acd))
+        {
+            if (!needs(Acd))
+            {
+                m_acdEnergyThreshold = other.m_acdEnergyThreshold;
+                m_acdTilesOnly       = other.m_acdTilesOnly;
+            }
+            else
+            {
+                m_acdEnergyThreshold = loosest(m_acdEnergyThreshold, other.m_acdEnergyThreshold);
+                m_acdTilesOnly       = m_acdTilesOnly && other.m_acdTilesOnly;
+            }
+        }
+
+        m_subsystems |= other.m_subsystems;
+    }
+
+    /// Used by the converters
+    bool needs(Subsystem subsystem) const {return !m_declared || (m_subsystems & subsystem) != 0;}
+
+    bool acceptCal(double energy) const
+    {
+        return !(m_calEnergyThreshold > 0. && energy < m_calEnergyThreshold);
+    }
+
+    bool acceptAcd(bool isTile, double energy) const
+    {
+        if (m_acdTilesOnly && !isTile) return false;
+
+        return !(m_acdEnergyThreshold > 0. && energy < m_acdEnergyThreshold);
+    }
+
+    /// For the log
+    std::string describe() const
+    {
+        if (!m_declared) return "none declared, everything accepted";
+
+        std::stringstream text;
+
+        text << "subsystems";
+        if (needs(Tkr)) text << " Tkr";
+        if (needs(Cal)) text << " Cal";
+        if (needs(Acd)) text << " Acd";
+
+        if (needs(Cal) && m_calEnergyThreshold > 0.) text << ", Cal energy >= " << m_calEnergyThreshold;
+        if (needs(Acd) && m_acdEnergyThreshold > 0.) text << ", Acd energy >= " << m_acdEnergyThreshold;
+        if (needs(Acd) && m_acdTilesOnly)            text << ", Acd tiles only";
+
+        return text.str();
+    }
+
+    /// Accessors
+    bool   isDeclared()            const {return m_declared;}
+    double getCalEnergyThreshold() const {return m_calEnergyThreshold;}
+    double getAcdEnergyThreshold() const {return m_acdEnergyThreshold;}
+    bool   getAcdTilesOnly()       const {return m_acdTilesOnly;}
+
+private:
+    /// A threshold at or below zero means no cut, which is looser than any cut
+    static double loosest(double first, double second)
+    {
+        if (first <= 0. || second <= 0.) return -1.;
+
+        return first < second ? first : second;
+    }
+
+    bool         m_declared;
+    unsigned int m_subsystems;
+    double       m_calEnergyThreshold;
+    double       m_acdEnergyThreshold;
+    bool         m_acdTilesOnly;
+};
+
+#endif
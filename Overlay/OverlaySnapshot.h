@@ -0,0 +1,195 @@
+/** @file OverlaySnapshot.h
+
+    @brief declaration of the OverlaySnapshot class, the TDS native serialization of overlay libraries
+
+$Header$
+
+*/
+
+#ifndef OverlaySnapshot_h
+#define OverlaySnapshot_h
+
+#include <cstring>
+#include <vector>
+
+/** @class OverlaySnapshot
+    @brief View of the Tkr, Cal and Acd overlay data of one event, serialized in the layout of the
+           TDS overlay classes
+
+    In a snapshot overlay library the Tkr, Cal and Acd collections of each event are stored as one
+    block of bytes in the "OverlaySnapshot" branch of the tree, alongside the usual EventOverlay
+    branch which then carries only the event level, Gem, Pt and diagnostic information (as for a
+    columnar library). The block holds fixed size records with the TDS values (the idents fields,
+    the positions as doubles and the status words as found in the TDS), so the TDS objects are
+    built directly from the records, without ROOT overlay objects or type conversions.
+
+    The block is laid out as a Header, the CalRecords, the AcdRecords, the TkrRecords and then the
+    strips of all the Tkr records in row order. The records are in the native layout of the machine
+    which wrote them, the header keeps the byte order and the record sizes so that a library written
+    with a different layout is refused rather than misread. Records are value initialized before
+    they are filled so their padding is written as zeros.
+
+    Libraries in this format are selected by the format="snapshot" attribute of the <file> element
+    in the input xml catalog, and written by OverlayDataSvc with OutputFormat "snapshot".
+*/
+class OverlaySnapshot
+{
+public:
+    enum {FormatVersion = 2};
+
+    /// Written in the writer's byte order, reads back as 0x04030201 on a machine of the other order
+    enum {ByteOrderTag = 0x01020304};
+
+    /// Kept a multiple of 8 bytes so the records which follow it are aligned
+    struct Header
+    {
+        unsigned int version;
+        unsigned int byteOrder;
+        unsigned int headerSize;
+        unsigned int numTkr;
+        unsigned int numStrips;
+        unsigned int numCal;
+        unsigned int numAcd;
+        unsigned int tkrRecordSize;
+        unsigned int calRecordSize;
+        unsigned int acdRecordSize;
+    };
+
+    /// One Event::TkrOverlay, its strips follow those of the previous record
+    struct TkrRecord
+    {
+        short          towerX;
+        short          towerY;
+        short          bilayer;
+        short          view;          ///< 0 = X, 1 = Y
+        short          tot[2];
+        short          lastC0Strip;
+        unsigned short numStrips;
+    };
+
+    /// One Event::CalOverlay
+    struct CalRecord
+    {
+        double         position[3];
+        double         energy;
+        unsigned int   status;
+        short          tower;
+        short          layer;
+        short          column;
+    };
+
+    /// One Event::AcdOverlay
+    struct AcdRecord
+    {
+        unsigned long long volId;
+        double             position[3];
+        double             energy;
+        unsigned int       status;
+        unsigned short     volIdSize;
+        short              layer;
+        short              face;
+        short              row;
+        short              column;
+    };
+
+    OverlaySnapshot() : m_header(0), m_tkr(0), m_strips(0), m_cal(0), m_acd(0) {}
+    ~OverlaySnapshot() {}
+
+    /// Point the view at a serialized event, returns false (and an empty view) if the buffer
+    /// does not hold a snapshot of this version and layout
+    bool attach(const std::vector<char>& buffer)
+    {
+        *this = OverlaySnapshot();
+
+        if (buffer.size() < sizeof(Header)) return false;
+
+        const Header* header = reinterpret_cast<const Header*>(&buffer[0]);
+
+        if (header->version       != FormatVersion     ||
+            header->byteOrder     != ByteOrderTag      ||
+            header->headerSize    != sizeof(Header)    ||
+            header->tkrRecordSize != sizeof(TkrRecord) ||
+            header->calRecordSize != sizeof(CalRecord) ||
+            header->acdRecordSize != sizeof(AcdRecord)) return false;
+
+        if (buffer.size() != packedSize(header->numTkr, header->numStrips, header->numCal, header->numAcd)) return false;
+
+        const char* next = &buffer[0] + sizeof(Header);
+
+        m_cal    = reinterpret_cast<const CalRecord*>(next);
+        next    += header->numCal * sizeof(CalRecord);
+        m_acd    = reinterpret_cast<const AcdRecord*>(next);
+        next    += header->numAcd * sizeof(AcdRecord);
+        m_tkr    = reinterpret_cast<const TkrRecord*>(next);
+        next    += header->numTkr * sizeof(TkrRecord);
+        m_strips = reinterpret_cast<const unsigned short*>(next);
+        m_header = header;
+
+        return true;
+    }
+
+    /// Serialize the records of one event into the buffer
+    static void pack(std::vector<char>&                 buffer,
+                     const std::vector<TkrRecord>&      tkr,
+                     const std::vector<unsigned short>& strips,
+                     const std::vector<CalRecord>&      cal,
+                     const std::vector<AcdRecord>&      acd)
+    {
+        Header header = Header();
+
+        header.version       = FormatVersion;
+        header.byteOrder     = ByteOrderTag;
+        header.headerSize    = sizeof(Header);
+        header.numTkr        = tkr.size();
+        header.numStrips     = strips.size();
+        header.numCal        = cal.size();
+        header.numAcd        = acd.size();
+        header.tkrRecordSize = sizeof(TkrRecord);
+        header.calRecordSize = sizeof(CalRecord);
+        header.acdRecordSize = sizeof(AcdRecord);
+
+        buffer.resize(packedSize(header.numTkr, header.numStrips, header.numCal, header.numAcd));
+
+        char* next = &buffer[0];
+
+        next = append(next, &header, sizeof(Header));
+        next = append(next, cal.empty()    ? 0 : &cal[0],    cal.size()    * sizeof(CalRecord));
+        next = append(next, acd.empty()    ? 0 : &acd[0],    acd.size()    * sizeof(AcdRecord));
+        next = append(next, tkr.empty()    ? 0 : &tkr[0],    tkr.size()    * sizeof(TkrRecord));
+        next = append(next, strips.empty() ? 0 : &strips[0], strips.size() * sizeof(unsigned short));
+    }
+
+    /// Number of records for each subsystem
+    unsigned int numTkr() const {return m_header ? m_header->numTkr : 0;}
+    unsigned int numCal() const {return m_header ? m_header->numCal : 0;}
+    unsigned int numAcd() const {return m_header ? m_header->numAcd : 0;}
+
+    const TkrRecord&      tkr(unsigned int row) const {return m_tkr[row];}
+    const CalRecord&      cal(unsigned int row) const {return m_cal[row];}
+    const AcdRecord&      acd(unsigned int row) const {return m_acd[row];}
+
+    /// The strips of all Tkr records, those of a record follow the strips of the records before it
+    const unsigned short* strips()              const {return m_strips;}
+
+private:
+    static size_t packedSize(unsigned int numTkr, unsigned int numStrips, unsigned int numCal, unsigned int numAcd)
+    {
+        return sizeof(Header) + numCal * sizeof(CalRecord) + numAcd * sizeof(AcdRecord)
+                              + numTkr * sizeof(TkrRecord) + numStrips * sizeof(unsigned short);
+    }
+
+    static char* append(char* next, const void* data, size_t numBytes)
+    {
+        if (numBytes > 0) std::memcpy(next, data, numBytes);
+
+        return next + numBytes;
+    }
+
+    const Header*         m_header;
+    const TkrRecord*      m_tkr;
+    const unsigned short* m_strips;
+    const CalRecord*      m_cal;
+    const AcdRecord*      m_acd;
+};
+
+#endif
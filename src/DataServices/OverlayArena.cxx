@@ -0,0 +1,104 @@
+/**  @file OverlayArena.cxx
+@brief implementation of class OverlayArena
+
+$Header$
+*/
+
+#include "OverlayArena.h"
+
+#include <cstdlib>
+
+OverlayArena::OverlayArena(size_t chunkSize) :
+                           m_chunkSize(chunkSize),
+                           m_next(0),
+                           m_end(0),
+                           m_bytesInUse(0),
+                           m_highWaterMark(0),
+                           m_numResets(0)
+{
+}
+
+OverlayArena::~OverlayArena()
+{
+    for(std::vector<Chunk>::iterator chunkItr = m_chunks.begin(); chunkItr != m_chunks.end(); chunkItr++)
+        std::free(chunkItr->begin);
+}
+
+OverlayArena& OverlayArena::eventArena()
+{
+    static OverlayArena arena;
+
+    return arena;
+}
+
+void* OverlayArena::allocate(size_t numBytes, size_t alignment)
+{
+    if (numBytes == 0) numBytes = 1;
+
+    size_t pad = m_next ? (alignment - reinterpret_cast<size_t>(m_next) % alignment) % alignment : 0;
+
+    if (!m_next || pad + numBytes > static_cast<size_t>(m_end - m_next))
+    {
+        addChunk(numBytes + alignment);
+
+        pad = (alignment - reinterpret_cast<size_t>(m_next) % alignment) % alignment;
+    }
+
+    void* memory = m_next + pad;
+
+    m_next       += pad + numBytes;
+    m_bytesInUse += pad + numBytes;
+
+    return memory;
+}
+
+void OverlayArena::reset()
+{
+    if (m_bytesInUse > m_highWaterMark) m_highWaterMark = m_bytesInUse;
+
+    // Several chunks were needed, replace them by a single one big enough for all of them
+    if (m_chunks.size() > 1)
+    {
+        size_t totalSize = 0;
+
+        for(std::vector<Chunk>::iterator chunkItr = m_chunks.begin(); chunkItr != m_chunks.end(); chunkItr++)
+        {
+            totalSize += chunkItr->size;
+            std::free(chunkItr->begin);
+        }
+
+        m_chunks.clear();
+
+        if (totalSize > m_chunkSize) m_chunkSize = totalSize;
+
+        addChunk(m_chunkSize);
+    }
+
+    if (!m_chunks.empty())
+    {
+        m_next = m_chunks.front().begin;
+        m_end  = m_next + m_chunks.front().size;
+    }
+
+    m_bytesInUse = 0;
+    m_numResets++;
+
+    return;
+}
+
+void OverlayArena::addChunk(size_t numBytes)
+{
+    Chunk chunk;
+
+    chunk.size  = numBytes > m_chunkSize ? numBytes : m_chunkSize;
+    chunk.begin = static_cast<char*>(std::malloc(chunk.size));
+
+    if (!chunk.begin) throw std::bad_alloc();
+
+    m_chunks.push_back(chunk);
+
+    m_next = chunk.begin;
+    m_end  = chunk.begin + chunk.size;
+
+    return;
+}
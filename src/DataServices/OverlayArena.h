@@ -0,0 +1,123 @@
+/** @file OverlayArena.h
+
+    @brief declaration of the OverlayArena class and an STL allocator drawing from it
+
+$Header$
+
+*/
+
+#ifndef OverlayArena_h
+#define OverlayArena_h
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+/** @class OverlayArena
+    @brief Bump allocator for memory which lives no longer than the current event
+
+    Memory is handed out from large chunks and is never returned individually, it is all
+    recovered at once by reset(). When an event needed more than one chunk the chunks are
+    replaced at reset by a single chunk big enough for that event, so after the first few
+    events a job works out of one block of memory which is never given back to the heap.
+
+    The arena returned by eventArena() is reset at BeginEvent by OverlayDataSvc. Objects
+    placed in it must be destroyed by their user (or be trivially destructible) before the
+    end of the event. Objects handed to the TDS must NOT be placed here, the ObjectVector
+    containing them will delete them.
+*/
+class OverlayArena
+{
+public:
+    /// Constructor, chunkSize is the size of the first chunk in bytes
+    OverlayArena(size_t chunkSize = 64 * 1024);
+
+    ~OverlayArena();
+
+    /// The arena for the current event, shared by the overlay components
+    static OverlayArena& eventArena();
+
+    /// Get memory for numBytes bytes with the given alignment (a power of two)
+    void* allocate(size_t numBytes, size_t alignment = sizeof(double));
+
+    /// Recover all memory handed out since the last reset
+    void reset();
+
+    /// Statistics
+    size_t getBytesInUse()    const {return m_bytesInUse;}
+    size_t getHighWaterMark() const {return m_highWaterMark;}
+    size_t getNumChunks()     const {return m_chunks.size();}
+    size_t getNumResets()     const {return m_numResets;}
+
+private:
+    struct Chunk
+    {
+        char*  begin;
+        size_t size;
+    };
+
+    /// Start a new chunk able to hold at least numBytes
+    void addChunk(size_t numBytes);
+
+    /// Disallow copying
+    OverlayArena(const OverlayArena&);
+    OverlayArena& operator=(const OverlayArena&);
+
+    std::vector<Chunk> m_chunks;
+    size_t             m_chunkSize;
+    char*              m_next;
+    char*              m_end;
+    size_t             m_bytesInUse;
+    size_t             m_highWaterMark;
+    size_t             m_numResets;
+};
+
+/** @class OverlayArenaAllocator
+    @brief STL allocator drawing from an OverlayArena, for containers local to one event
+
+    deallocate does nothing, the memory is recovered when the arena is reset.
+*/
+template <class T> class OverlayArenaAllocator
+{
+public:
+    typedef T              value_type;
+    typedef T*             pointer;
+    typedef const T*       const_pointer;
+    typedef T&             reference;
+    typedef const T&       const_reference;
+    typedef size_t         size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template <class U> struct rebind {typedef OverlayArenaAllocator<U> other;};
+
+    OverlayArenaAllocator() : m_arena(&OverlayArena::eventArena()) {}
+    explicit OverlayArenaAllocator(OverlayArena& arena) : m_arena(&arena) {}
+    template <class U> OverlayArenaAllocator(const OverlayArenaAllocator<U>& other) : m_arena(other.getArena()) {}
+
+    pointer       address(reference x)       const {return &x;}
+    const_pointer address(const_reference x) const {return &x;}
+
+    pointer allocate(size_type n, const void* = 0)
+    {
+        return static_cast<pointer>(m_arena->allocate(n * sizeof(T), __alignof__(T)));
+    }
+    void deallocate(pointer, size_type) {}
+
+    size_type max_size() const {return size_type(-1) / sizeof(T);}
+
+    void construct(pointer p, const T& val) {new(static_cast<void*>(p)) T(val);}
+    void destroy(pointer p)                 {p->~T();}
+
+    OverlayArena* getArena() const {return m_arena;}
+
+private:
+    OverlayArena* m_arena;
+};
+
+template <class T, class U>
+inline bool operator==(const OverlayArenaAllocator<T>& a, const OverlayArenaAllocator<U>& b) {return a.getArena() == b.getArena();}
+
+template <class T, class U>
+inline bool operator!=(const OverlayArenaAllocator<T>& a, const OverlayArenaAllocator<U>& b) {return a.getArena() != b.getArena();}
+
+#endif
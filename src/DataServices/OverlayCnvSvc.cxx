@@ -32,6 +32,9 @@
 #include "OverlayEvent/SrcOverlay.h"
 #include "OverlayEvent/TkrOverlay.h"
 
+#include "Overlay/IOverlayDataSvc.h"
+#include "../cnv/OverlayTdsFill.h"
+
 #include <map>
 #include <vector>
 
@@ -93,12 +96,30 @@ private:
     typedef std::map<const CLID,  IGlastCnv*>                CLIDToCnvMap;
     typedef std::map<const CLID,  std::vector<CLID> >        SubCLIDMap;
 
+    /// The daughter addresses registered for one (data service, class id) pair, built once
+    /// and re-registered each event
+    struct AddressTemplates
+    {
+        IDataManagerSvc*                                   addrReg;
+        IOverlayDataSvc*                                   overlaySvc;
+        std::vector<std::pair<std::string, IOpaqueAddress*> > addresses;
+    };
+
+    typedef std::map<std::pair<DataSvc*, CLID>, AddressTemplates> AddressTemplateMap;
+
+    /// Create the daughter addresses for the given data service and class id
+    AddressTemplates& getAddressTemplates(DataSvc* dataSvc, const CLID& clID);
+
     CLIDvector          m_clidVector;
 
     PathToCnvMap        m_pathToCnvMap;
     SubPathMap          m_subPathMap;
     CLIDToCnvMap        m_clidToCnvMap;
     SubCLIDMap          m_subClidMap;
+    AddressTemplateMap  m_addressTemplateMap;
+
+    /// Build all daughter objects in one pass when their parent is loaded, rather than on first access
+    bool                m_bulkConvert;
 };
 
 #include "GlastSvc/EventSelector/IGlastCnv.h"
@@ -115,6 +136,8 @@ OverlayCnvSvc::OverlayCnvSvc(const std::string& name, ISvcLocator* svc)
     m_clidToCnvMap.clear();
     m_subClidMap.clear();
 
+    declareProperty("BulkConvert", m_bulkConvert = false);
+
     // Hardwired list of Class ID's 
     m_clidVector.push_back(Event::EventOverlay::classID());
     m_clidVector.push_back(ObjectVector<Event::AcdOverlay>::classID());
@@ -184,6 +207,16 @@ StatusCode OverlayCnvSvc::finalize()
 
     log << MSG::DEBUG << "Finalizing" << endreq;
 
+    // Drop our reference to the address templates
+    for(AddressTemplateMap::iterator tmpItr = m_addressTemplateMap.begin(); tmpItr != m_addressTemplateMap.end(); tmpItr++)
+    {
+        std::vector<std::pair<std::string, IOpaqueAddress*> >& addresses = tmpItr->second.addresses;
+
+        for(size_t idx = 0; idx < addresses.size(); idx++) addresses[idx].second->release();
+    }
+
+    m_addressTemplateMap.clear();
+
     return StatusCode::SUCCESS;
 }
 
@@ -214,58 +247,110 @@ StatusCode OverlayCnvSvc::updateServiceState(IOpaqueAddress* pAddress)
         // If caste failed then simply return as if nothing has happened
         if (!dataSvc) return status;
 
-        // Now recover the root path name
-        std::string rootPath = dataSvc->rootName();
-        
-        // From the data service, recover the address manager
-//        SmartIF<IDataManagerSvc> iaddrReg(IID_IDataManagerSvc, dataProvider());
-//        SmartIF<IDataManagerSvc> iaddrReg(IID_IDataManagerSvc, registry->dataSvc());
-        SmartIF<IDataManagerSvc> iaddrReg(registry->dataSvc());
+        // The daughter addresses are built the first time through, after that they only need 
+        // to be registered again (the store releases them at the end of each event)
+        AddressTemplates& templates = getAddressTemplates(dataSvc, clID);
+
+        std::vector<std::pair<std::string, IOpaqueAddress*> >& addresses = templates.addresses;
 
-        // Find the list of related converters
-        SubCLIDMap::iterator clidIter = m_subClidMap.find(clID);
+        // In bulk mode the input event is converted now, in one go, the parent object is 
+        // already in the store so the daughters can be registered directly
+        EventOverlay*          overlayRoot = 0;
+        const OverlayColumns*  columns     = 0;
+        const OverlaySnapshot* snapshot    = 0;
+
+        if (m_bulkConvert && templates.overlaySvc && !addresses.empty())
+        {
+            overlayRoot = templates.overlaySvc->getRootEventOverlay();
+            columns     = overlayRoot ? templates.overlaySvc->getOverlayColumns()  : 0;
+            snapshot    = overlayRoot ? templates.overlaySvc->getOverlaySnapshot() : 0;
+        }
 
-        // Check to be sure something was found
-        if (clidIter != m_subClidMap.end())
+        for(size_t idx = 0; idx < addresses.size(); idx++)
         {
-            // Loop over the list of daughter converters and activate them
-            for(std::vector<CLID>::iterator subIter = clidIter->second.begin(); subIter != clidIter->second.end(); subIter++)
+            if (overlayRoot)
             {
-                // Now look up the pointer to the converter
-                CLIDToCnvMap::iterator cnvIter  = m_clidToCnvMap.find(*subIter);
-                IGlastCnv*             glastCnv = cnvIter->second;
+                DataObject* object = OverlayTdsFill::create(addresses[idx].second->clID(), *overlayRoot, columns, snapshot,
+                                                            templates.overlaySvc->getReadCuts());
 
-                if (glastCnv)
+                if (object)
                 {
-                    // Avoid self reference, though this should not happen here
-                    if (glastCnv->objType() == clID) continue;
+                    if (dataSvc->registerObject(addresses[idx].first, object).isSuccess()) continue;
 
-                    IOpaqueAddress*   newAddr  = 0;
-                    unsigned long     ipars[2] = {0, 0};
-                    const std::string spars[2] = {rootPath + glastCnv->getPath(), ""}; 
-                    
-                    StatusCode ir = addressCreator()->createAddress(EXCEL_StorageType, 
-                                                                    glastCnv->objType(), 
-                                                                    spars, 
-                                                                    ipars,
-                                                                    newAddr);
-                    if (ir.isSuccess())
-                    {
-                        ir = iaddrReg->registerAddress(rootPath + glastCnv->getPath(), newAddr);
-//                        ir = dataSvc->registerAddress(rootPath + glastCnv->getPath(), newAddr);
-                        if ( !ir.isSuccess() )    
-                        {
-                            newAddr->release();
-                            status = ir;
-                        }
-                    }
+                    delete object;
                 }
             }
+
+            // Otherwise the object is converted when first accessed
+            StatusCode ir = templates.addrReg->registerAddress(addresses[idx].first, addresses[idx].second);
+
+            if ( !ir.isSuccess() ) status = ir;
         }
     }
     return status;
 }
 
+OverlayCnvSvc::AddressTemplates& OverlayCnvSvc::getAddressTemplates(DataSvc* dataSvc, const CLID& clID)
+{
+    std::pair<DataSvc*, CLID>    key(dataSvc, clID);
+    AddressTemplateMap::iterator tmpItr = m_addressTemplateMap.find(key);
+
+    if (tmpItr != m_addressTemplateMap.end()) return tmpItr->second;
+
+    AddressTemplates& templates = m_addressTemplateMap[key];
+
+    // Now recover the root path name
+    std::string rootPath = dataSvc->rootName();
+        
+    // From the data service, recover the address manager
+    SmartIF<IDataManagerSvc> iaddrReg(dataSvc);
+
+    templates.addrReg = iaddrReg;
+
+    // Only an overlay input service can supply objects for bulk conversion
+    SmartIF<IOverlayDataSvc> overlaySvc(dataSvc);
+
+    templates.overlaySvc = overlaySvc;
+
+    // Find the list of related converters
+    SubCLIDMap::iterator clidIter = m_subClidMap.find(clID);
+
+    // Check to be sure something was found
+    if (clidIter == m_subClidMap.end()) return templates;
+
+    // Loop over the list of daughter converters and create their addresses
+    for(std::vector<CLID>::iterator subIter = clidIter->second.begin(); subIter != clidIter->second.end(); subIter++)
+    {
+        // Now look up the pointer to the converter
+        CLIDToCnvMap::iterator cnvIter  = m_clidToCnvMap.find(*subIter);
+        IGlastCnv*             glastCnv = cnvIter->second;
+
+        if (glastCnv)
+        {
+            // Avoid self reference, though this should not happen here
+            if (glastCnv->objType() == clID) continue;
+
+            IOpaqueAddress*   newAddr  = 0;
+            unsigned long     ipars[2] = {0, 0};
+            const std::string spars[2] = {rootPath + glastCnv->getPath(), ""}; 
+                    
+            StatusCode ir = addressCreator()->createAddress(EXCEL_StorageType, 
+                                                            glastCnv->objType(), 
+                                                            spars, 
+                                                            ipars,
+                                                            newAddr);
+            if (ir.isSuccess())
+            {
+                // Our reference keeps the address alive when the store releases it
+                newAddr->addRef();
+                templates.addresses.push_back(std::make_pair(spars[0], newAddr));
+            }
+        }
+    }
+
+    return templates;
+}
+
 StatusCode OverlayCnvSvc::queryInterface(const InterfaceID& riid, void** ppvInterface)  
 {
     // Return the results of querying the interface
@@ -0,0 +1,221 @@
+/**  @file OverlayColumnIo.cxx
+@brief implementation of classes OverlayColumnWriter and OverlayColumnReader
+
+$Header$
+*/
+
+#include "OverlayColumnIo.h"
+
+#include "RootIo/IRootIoSvc.h"
+#include "overlayRootData/EventOverlay.h"
+#include "RootConvert/Utilities/Toolkit.h"
+
+#include "TChain.h"
+
+#include <stdexcept>
+
+namespace
+{
+    // ROOT class names of the column types
+    template <class T> struct ColumnClass {};
+    template <> struct ColumnClass<short>              {static const char* name() {return "vector<short>";}};
+    template <> struct ColumnClass<unsigned short>     {static const char* name() {return "vector<unsigned short>";}};
+    template <> struct ColumnClass<unsigned int>       {static const char* name() {return "vector<unsigned int>";}};
+    template <> struct ColumnClass<float>              {static const char* name() {return "vector<float>";}};
+    template <> struct ColumnClass<unsigned long long> {static const char* name() {return "vector<ULong64_t>";}};
+
+    // Visitor to create the output branches
+    class BranchMaker
+    {
+    public:
+        BranchMaker(IRootIoSvc* rootIoSvc, const std::string& type, int bufSize, std::vector<void*>& columnPtrs) :
+            m_rootIoSvc(rootIoSvc), m_type(type), m_bufSize(bufSize), m_columnPtrs(columnPtrs) {}
+
+        template <class T> void operator()(const char* name, std::vector<T>& column)
+        {
+            m_columnPtrs.push_back(&column);
+            m_rootIoSvc->setupBranch(m_type, name, ColumnClass<T>::name(), &m_columnPtrs.back(), m_bufSize, 0);
+        }
+
+    private:
+        IRootIoSvc*         m_rootIoSvc;
+        std::string         m_type;
+        int                 m_bufSize;
+        std::vector<void*>& m_columnPtrs;
+    };
+
+    // Visitor to set the input branch addresses
+    class AddressSetter
+    {
+    public:
+        AddressSetter(TChain* chain, std::vector<void*>& columnPtrs) : m_chain(chain), m_columnPtrs(columnPtrs) {}
+
+        template <class T> void operator()(const char* name, std::vector<T>& column)
+        {
+            m_columnPtrs.push_back(&column);
+            m_chain->SetBranchAddress(name, (std::vector<T>**)&m_columnPtrs.back());
+        }
+
+    private:
+        TChain*             m_chain;
+        std::vector<void*>& m_columnPtrs;
+    };
+
+    // The number of columns, so the pointers can be reserved and will not move
+    class ColumnCounter
+    {
+    public:
+        ColumnCounter() : m_count(0) {}
+        template <class T> void operator()(const char*, std::vector<T>&) {m_count++;}
+        int m_count;
+    };
+}
+
+void OverlayColumnWriter::setupBranches(IRootIoSvc* rootIoSvc, const std::string& type, int bufSize)
+{
+    ColumnCounter counter;
+    m_columns.visit(counter);
+
+    m_columnPtrs.clear();
+    m_columnPtrs.reserve(counter.m_count);
+
+    BranchMaker maker(rootIoSvc, type, bufSize, m_columnPtrs);
+    m_columns.visit(maker);
+}
+
+void OverlayColumnWriter::fill(EventOverlay& eventOverlay)
+{
+    m_columns.clear();
+
+    // Tracker
+    TObjArray* tkrOverlayCol = const_cast<TObjArray*>(eventOverlay.getTkrOverlayCol());
+
+    m_columns.tkrStripOffset.push_back(0);
+
+    if (tkrOverlayCol)
+    {
+        TIter       tkrIter(tkrOverlayCol);
+        TkrOverlay* tkrOverlay = 0;
+
+        while((tkrOverlay = (TkrOverlay*)tkrIter.Next()) != 0)
+        {
+            TowerId tower = tkrOverlay->getTower();
+
+            m_columns.tkrTowerX.push_back(tower.ix());
+            m_columns.tkrTowerY.push_back(tower.iy());
+            m_columns.tkrBilayer.push_back(tkrOverlay->getBilayer());
+            m_columns.tkrView.push_back(tkrOverlay->getView() == GlastAxis::X ? 0 : 1);
+            m_columns.tkrToT0.push_back(tkrOverlay->getToT(0));
+            m_columns.tkrToT1.push_back(tkrOverlay->getToT(1));
+            m_columns.tkrLastC0Strip.push_back(tkrOverlay->getLastController0Strip());
+
+            for(unsigned int iHit = 0; iHit < tkrOverlay->getNumHits(); iHit++)
+            {
+                m_columns.tkrStrips.push_back(tkrOverlay->getHit(iHit));
+            }
+
+            m_columns.tkrStripOffset.push_back(m_columns.tkrStrips.size());
+        }
+
+        tkrOverlayCol->Delete();
+    }
+
+    // Calorimeter
+    TObjArray* calOverlayCol = const_cast<TObjArray*>(eventOverlay.getCalOverlayCol());
+
+    if (calOverlayCol)
+    {
+        TIter       calIter(calOverlayCol);
+        CalOverlay* calOverlay = 0;
+
+        while((calOverlay = (CalOverlay*)calIter.Next()) != 0)
+        {
+            CalXtalId       xtalId   = calOverlay->getPackedId();
+            const TVector3& position = calOverlay->getPosition();
+
+            m_columns.calTower.push_back(xtalId.getTower());
+            m_columns.calLayer.push_back(xtalId.getLayer());
+            m_columns.calColumn.push_back(xtalId.getColumn());
+            m_columns.calEnergy.push_back(calOverlay->getEnergy());
+            m_columns.calPosX.push_back(position.X());
+            m_columns.calPosY.push_back(position.Y());
+            m_columns.calPosZ.push_back(position.Z());
+            m_columns.calStatus.push_back(calOverlay->getStatus());
+        }
+
+        calOverlayCol->Delete();
+    }
+
+    // ACD
+    TObjArray* acdOverlayCol = const_cast<TObjArray*>(eventOverlay.getAcdOverlayCol());
+
+    if (acdOverlayCol)
+    {
+        TIter       acdIter(acdOverlayCol);
+        AcdOverlay* acdOverlay = 0;
+
+        while((acdOverlay = (AcdOverlay*)acdIter.Next()) != 0)
+        {
+            VolumeIdentifier         volIdRoot = acdOverlay->getVolId();
+            idents::VolumeIdentifier volIdTds  = RootPersistence::convert(volIdRoot);
+            const TVector3&          position  = acdOverlay->getPosition();
+
+            m_columns.acdVolId.push_back(volIdTds.getValue());
+            m_columns.acdVolIdSize.push_back(volIdTds.size());
+            m_columns.acdEnergy.push_back(acdOverlay->getEnergyDep());
+            m_columns.acdPosX.push_back(position.X());
+            m_columns.acdPosY.push_back(position.Y());
+            m_columns.acdPosZ.push_back(position.Z());
+            m_columns.acdStatus.push_back(acdOverlay->getStatus());
+        }
+
+        acdOverlayCol->Delete();
+    }
+}
+
+OverlayColumnReader::OverlayColumnReader(const std::string&              treeName, 
+                                         const std::string&              branchName, 
+                                         const std::vector<std::string>& fileList) :
+                                         m_chain(0), m_eventOverlay(0)
+{
+    m_chain = new TChain(treeName.c_str());
+
+    for(std::vector<std::string>::const_iterator fileItr = fileList.begin(); fileItr != fileList.end(); fileItr++)
+    {
+        if (m_chain->Add(fileItr->c_str(), 0) == 0)
+        {
+            delete m_chain;
+            throw std::runtime_error("OverlayColumnReader: cannot open " + *fileItr);
+        }
+    }
+
+    m_chain->SetBranchAddress(branchName.c_str(), &m_eventOverlay);
+
+    ColumnCounter counter;
+    m_columns.visit(counter);
+
+    m_columnPtrs.reserve(counter.m_count);
+
+    AddressSetter setter(m_chain, m_columnPtrs);
+    m_columns.visit(setter);
+}
+
+OverlayColumnReader::~OverlayColumnReader()
+{
+    m_chain->ResetBranchAddresses();
+
+    delete m_chain;
+    delete m_eventOverlay;
+}
+
+long long OverlayColumnReader::getEntries() const
+{
+    return m_chain->GetEntries();
+}
+
+EventOverlay* OverlayColumnReader::read(long long entry)
+{
+    if (m_chain->GetEntry(entry) <= 0) return 0;
+
+    return m_eventOverlay;
+}
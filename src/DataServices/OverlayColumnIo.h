@@ -0,0 +1,72 @@
+/** @file OverlayColumnIo.h
+
+    @brief declaration of the OverlayColumnWriter and OverlayColumnReader classes
+
+$Header$
+
+*/
+
+#ifndef OverlayColumnIo_h
+#define OverlayColumnIo_h
+
+#include "Overlay/OverlayColumns.h"
+
+#include <string>
+#include <vector>
+
+class EventOverlay;
+class IRootIoSvc;
+class TChain;
+
+/** @class OverlayColumnWriter
+    @brief Writes the Tkr, Cal and Acd overlay data of each event as columns (see OverlayColumns)
+*/
+class OverlayColumnWriter
+{
+public:
+    OverlayColumnWriter() {}
+    ~OverlayColumnWriter() {}
+
+    /// Add a branch for each column to the given RootIoSvc output tree
+    void setupBranches(IRootIoSvc* rootIoSvc, const std::string& type, int bufSize);
+
+    /// Move the Tkr, Cal and Acd collections of the EventOverlay into the columns, ready to fill the tree
+    void fill(EventOverlay& eventOverlay);
+
+private:
+    OverlayColumns     m_columns;
+
+    /// The branches need the address of a pointer to each column
+    std::vector<void*> m_columnPtrs;
+};
+
+/** @class OverlayColumnReader
+    @brief Reads a columnar overlay library, both the EventOverlay branch and the columns
+*/
+class OverlayColumnReader
+{
+public:
+    /// Opens the library, throws std::runtime_error if this fails
+    OverlayColumnReader(const std::string&              treeName, 
+                        const std::string&              branchName, 
+                        const std::vector<std::string>& fileList);
+
+    ~OverlayColumnReader();
+
+    long long getEntries() const;
+
+    /// Read the given entry, returns zero on error
+    EventOverlay* read(long long entry);
+
+    const OverlayColumns* getColumns() const {return &m_columns;}
+
+    TChain* getChain() const {return m_chain;}
+
+private:
+    TChain*            m_chain;
+    EventOverlay*      m_eventOverlay;
+    OverlayColumns     m_columns;
+    std::vector<void*> m_columnPtrs;
+};
+
+#endif
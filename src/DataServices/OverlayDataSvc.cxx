@@ -24,27 +24,64 @@
 #include "GaudiKernel/IOpaqueAddress.h"
 #include "GaudiKernel/IIncidentSvc.h"
 #include "GaudiKernel/IIncidentListener.h"
+#include "GaudiKernel/IDataStoreAgent.h"
+#include "GaudiKernel/IRegistry.h"
 #include "GaudiKernel/IToolSvc.h"
 #include "GaudiKernel/MsgStream.h"
+#include "GaudiKernel/SmartDataPtr.h"
 #include "GaudiKernel/DataSvc.h"
 #include "GaudiKernel/ConversionSvc.h"
 
 #include "OverlayEvent/OverlayEventModel.h"
+#include "Event/TopLevel/EventModel.h"
+#include "Event/TopLevel/Event.h"
 
 #include "RootIo/IRootIoSvc.h"
 #include "OverlayEvent/OverlayEventModel.h"
 #include "overlayRootData/EventOverlay.h"
 #include "facilities/Util.h"
 
-#include "CLHEP/Random/RandFlat.h"
-
 #include "../InputControl/XmlFetchEvents.h"
+#include "../InputControl/OverlayProvenance.h"
+#include "../InputControl/OverlayBinSampler.h"
+#include "../InputControl/OverlayPreselection.h"
+#include "../cnv/OverlayTdsFill.h"
+#include "OverlayIoPool.h"
+#include "OverlayStageCache.h"
+#include "OverlayReadCache.h"
+#include "OverlayPageCacheHints.h"
+#include "OverlayColumnIo.h"
+#include "OverlaySnapshotIo.h"
+#include "OverlayObjectReader.h"
+#include "OverlayArena.h"
+#include "Overlay/OverlayColumns.h"
+#include "Overlay/OverlayEventView.h"
+#include "Overlay/OverlayReadCuts.h"
 #include "Overlay/IOverlayDataSvc.h"
 #include "Overlay/IBackgroundBinTool.h"
 #include "Overlay/IFetchEvents.h"
 
 #include "enums/TriggerBits.h"
 
+#include <algorithm>
+#include <stdexcept>
+
+class OverlayDataSvc;
+
+/** @class OverlayReadJob
+    @brief Reads the next input event for an OverlayDataSvc on an I/O pool thread
+*/
+class OverlayReadJob : public OverlayIoPool::Job
+{
+public:
+    OverlayReadJob(OverlayDataSvc* dataSvc) : m_dataSvc(dataSvc) {}
+
+    virtual void run();
+
+private:
+    OverlayDataSvc* m_dataSvc;
+};
+
 /** @class OverlayDataSvc OverlayDataSvc.h
  * 
  *   A OverlayDataSvc is the base class for event services
@@ -57,6 +94,7 @@ class OverlayDataSvc  : public extends3<DataSvc, IOverlayDataSvc, IIncidentListe
 private:
     //friend class SvcFactory<OverlayDataSvc>;
     friend class Factory<OverlayDataSvc,IService* (std::string,ISvcLocator *)>;
+    friend class OverlayReadJob;
 
 public:
     virtual StatusCode initialize();
@@ -66,9 +104,33 @@ public:
     /// Get pointer to a Root DigiEvent object
     virtual EventOverlay* getRootEventOverlay();
 
+    /// Get pointer to the Tkr, Cal and Acd columns of a columnar input
+    virtual const OverlayColumns* getOverlayColumns();
+
+    /// Get pointer to the Tkr, Cal and Acd records of a snapshot input
+    virtual const OverlaySnapshot* getOverlaySnapshot();
+
+    /// Get the structure of arrays view of the current input event
+    virtual const OverlayEventView* getOverlayEventView();
+
+    /// Add the subsystems and cuts of a consumer to those applied by the converters
+    virtual void declareReadCuts(const OverlayReadCuts& cuts);
+
+    /// Combined cuts applied by the converters
+    virtual const OverlayReadCuts& getReadCuts() const;
+
+    /// Counter incremented at each BeginEvent
+    virtual unsigned long getEventGeneration() const {return m_eventGeneration;}
+
+    /// Reuse the overlay section of the TDS from the previous event
+    virtual StatusCode refillOverlayTree();
+
     /// Select the next event
     virtual StatusCode selectNextEvent();
 
+    /// Start reading the next event on the I/O pool
+    virtual StatusCode prefetchEvent();
+
     /// Register an output path with us
     virtual StatusCode registerOutputPath(const std::string&);
 
@@ -95,6 +157,48 @@ private:
     */
     void setNewInputBin(double val);
 
+    /**@brief Determine the input bin for this event, opening new input files if necessary
+    */
+    StatusCode selectInputBin();
+
+    /**@brief Read the next event from the current input bin, may be run on an I/O pool thread
+    */
+    void readNextEvent();
+
+    /**@brief Check and record the result of readNextEvent
+    */
+    StatusCode finishRead();
+
+    /**@brief Move the read cache to the current input
+    */
+    void activateReadCache();
+
+    /**@brief Return the files of the bins neighbouring the current bin
+    */
+    std::vector<std::string> getNeighbourBinFiles();
+
+    /**@brief Open a new set of input files with RootIoSvc, returns the "type" name used to identify them
+    */
+    std::string prepareInput(const std::string&              treeName, 
+                             const std::string&              branchName, 
+                             const std::string&              format,
+                             const std::vector<std::string>& fileList);
+
+    /**@brief Read an entry of the given input, from RootIoSvc or its column or snapshot reader
+    */
+    EventOverlay* readEntry(const std::string& type, long long entry);
+
+    /**@brief In replay mode, serve the next event listed in the provenance file
+    */
+    StatusCode replayNextEvent();
+
+    /**@brief In replay mode, read the next block of listed entries ordered by file and entry
+    */
+    StatusCode loadReplayBlock();
+
+    /// Record the input entry used for the current event to the provenance file
+    void recordProvenance(long long entry);
+
     /// access the RootIoSvc to get the CompositeEventList ptr
     IRootIoSvc *                       m_rootIoSvc;
 
@@ -106,9 +210,8 @@ private:
     // end of the job
     std::map<std::string, std::string> m_inputFileMap;
 
-    // We keep track of the current index and the number of events in the given input file
-    std::map<std::string, long long>   m_inputIndexMap;
-	std::map<std::string, long long>   m_inputEntriesMap;
+    // Each input file (bin) has a sampler to select the next event and keep track of reuse
+    std::map<std::string, OverlayBinSampler*> m_samplerMap;
     
     std::string                        m_curFileType;
 
@@ -117,6 +220,38 @@ private:
     EventOverlay                       m_myOverlay;
     EventOverlay*                      m_myOverlayPtr;
 
+    /// Object inputs are read by the service itself rather than through RootIoSvc, which is
+    /// then never used from an I/O pool thread
+    std::map<std::string, OverlayObjectReader*> m_objectReaderMap;
+
+    /// Columnar inputs are read directly too
+    std::map<std::string, OverlayColumnReader*> m_columnReaderMap;
+
+    /// Columns of the current event, zero unless it came from a columnar input
+    const OverlayColumns*              m_columns;
+
+    /// Snapshot inputs are also read directly
+    std::map<std::string, OverlaySnapshotReader*> m_snapshotReaderMap;
+
+    /// Records of the current event, zero unless it came from a snapshot input
+    const OverlaySnapshot*             m_snapshot;
+
+    /// View of the current input event and the event generation it was filled for
+    OverlayEventView                   m_eventView;
+    unsigned long                      m_eventViewGeneration;
+
+    /// Subsystems and cuts declared by the merge algorithms, applied by the converters
+    OverlayReadCuts                    m_readCuts;
+
+    /// Apply the declared cuts while reading (otherwise every object is built), logged as they are declared
+    bool                               m_applyReadCuts;
+
+    /// Incremented at each BeginEvent, see OverlayTdsHandle
+    unsigned long                      m_eventGeneration;
+
+    /// Keep the overlay section of the TDS from one event to the next, see refillOverlayTree
+    bool                               m_reuseOverlayTree;
+
     //***** INPUT SPECIFIC VARIABLES HERE *****
     // flag to signal that we need to read the current event
     IFetchEvents*                      m_fetch;       ///< abstract guy that processes the xml file
@@ -139,6 +274,116 @@ private:
 	/// Use this mask to reject overlay events which might "trigger" 
 	unsigned int                       m_triggerRejectMask;
 
+    /// How to select events within a bin, "Sequential" or "Permutation"
+    StringProperty                     m_samplingMode;
+
+    OverlayBinSampler::Mode            m_samplerMode;
+
+    /// Library preselection on the PtOverlay quality fields
+    std::vector<int>                   m_preselectDataQual;
+    std::vector<int>                   m_preselectLatMode;
+    double                             m_preselectMinLivetimeFrac;
+    StringProperty                     m_preselectBranches;
+    StringProperty                     m_preselectCacheDir;
+
+    OverlayPreselection*               m_preselection;
+
+    //***** PROVENANCE AND REPLAY VARIABLES HERE *****
+
+    /// If set, record the input entry used for each event in this file
+    StringProperty                     m_provenanceFile;
+
+    /// If set, replay the input entries recorded in this provenance file
+    StringProperty                     m_replayFile;
+
+    /// Number of replay entries to read (and cache) at a time
+    int                                m_replayBlockSize;
+
+    OverlayProvenanceWriter*           m_provWriter;
+    OverlayProvenanceReader*           m_replayReader;
+
+    /// Relates a RootIoSvc "type" name to its library index in the provenance file
+    std::map<std::string, int>         m_libraryMap;
+
+    /// Replay mode: RootIoSvc "type" name for each library in the replay file
+    std::vector<std::string>           m_replayTypes;
+
+    /// Replay mode: copies of the events in the current block
+    std::vector<EventOverlay*>         m_replayBlock;
+    size_t                             m_replayBlockStart;
+    size_t                             m_replayCursor;
+
+    //***** CONCURRENT READ VARIABLES HERE *****
+
+    /// Number of threads in the (shared) I/O pool, zero to read on demand in the event loop
+    int                                m_ioThreads;
+
+    OverlayIoPool*                     m_ioPool;
+    OverlayReadJob*                    m_readJob;
+
+    /// Set while a read submitted to the I/O pool is outstanding
+    bool                               m_readPending;
+
+    /// The entry read for the current event
+    long long                          m_readIndex;
+
+    //***** READ CACHE VARIABLES HERE *****
+
+    /// Size of the ROOT read cache in bytes, zero to leave caching as set up by RootIoSvc
+    int                                m_readCacheSize;
+
+    /// Number of entries used to learn which branches to cache
+    int                                m_readCacheLearnEntries;
+
+    /// Branches to cache, if empty these are learned
+    std::vector<std::string>           m_readCacheBranches;
+
+    /// Decompress baskets in parallel, with up to this many threads (for the whole job, see initialize)
+    bool                               m_parallelUnzip;
+    int                                m_unzipThreads;
+
+    /// Read cache for each input, only the current input's cache is active
+    std::map<std::string, OverlayReadCache*> m_readCacheMap;
+    OverlayReadCache*                  m_activeReadCache;
+
+    //***** LOCAL STAGING VARIABLES HERE *****
+
+    /// Local directory to stage input files to, empty to read them in place
+    StringProperty                     m_stageCacheDir;
+
+    /// Maximum size of the staging cache in GB
+    double                             m_stageCacheMaxGB;
+
+    /// Hard link into the staging cache rather than copy where possible
+    bool                               m_stageUseLinks;
+
+    OverlayStageCache*                 m_stageCache;
+
+    //***** PAGE CACHE HINT VARIABLES HERE *****
+
+    /// Give the kernel readahead/release hints for the input files
+    bool                               m_pageCacheHints;
+
+    /// Maximum MB advised as needed per bin change
+    double                             m_pageCacheWillNeedMB;
+
+    /// Inputs not current for this long are released from the page cache
+    double                             m_pageCacheIdleSeconds;
+
+    OverlayPageCacheHints*             m_pageHints;
+
+    /// The files actually read for each input (after any staging)
+    std::map<std::string, std::vector<std::string> > m_inputListMap;
+
+    /// Number of bins either side of the current bin which are staged or read ahead
+    int                                m_neighbourBins;
+
+    /// Replay mode: relates a simulated run/event to its position in the replay file
+    std::map<std::pair<unsigned int, unsigned int>, size_t> m_replayIndexMap;
+
+    /// Needed to retrieve the simulated run and event numbers
+    IDataProviderSvc*                  m_eventDataSvc;
+
     //***** OUTPUT SPECIFIC VARIABLES HERE *****
 
     /// List of objects to store (from converters
@@ -156,6 +401,11 @@ private:
     int                                m_compressionLevel;
     /// Flag to specify whether event is to be written at end of event
     bool                               m_saveEvent;
+    /// Output format, "object", "columnar" or "snapshot"
+    StringProperty                     m_outputFormat;
+
+    OverlayColumnWriter*               m_columnWriter;
+    OverlaySnapshotWriter*             m_snapshotWriter;
 
     IConversionSvc*                    m_cnvSvc;
     std::string                        m_persistencySvcName;
@@ -177,7 +427,13 @@ DECLARE_SERVICE_FACTORY(OverlayDataSvc);
 //: DataSvc(name,svc) , m_cnvSvc(0),
 OverlayDataSvc::OverlayDataSvc(const std::string& name,ISvcLocator* svc) 
 : base_class(name,svc) , m_cnvSvc(0),
-               m_rootIoSvc(0), m_curFileType(""), m_eventOverlay(0), m_myOverlayPtr(&m_myOverlay), m_needToReadEvent(true)
+               m_rootIoSvc(0), m_curFileType(""), m_eventOverlay(0), m_myOverlayPtr(&m_myOverlay), m_columns(0), m_snapshot(0),
+               m_eventViewGeneration(0), m_eventGeneration(0),
+               m_fetch(0), m_binTool(0), m_needToReadEvent(true), m_samplerMode(OverlayBinSampler::Sequential),
+               m_preselection(0), m_provWriter(0), m_replayReader(0),
+               m_replayBlockStart(0), m_replayCursor(0), m_ioPool(0), m_readJob(0), m_readPending(false), 
+               m_readIndex(0), m_activeReadCache(0), m_stageCache(0), m_pageHints(0), m_eventDataSvc(0),
+               m_columnWriter(0), m_snapshotWriter(0)
 {
     //Declare the additional interface
 //    declareInterface<IOverlayDataSvc>(this);
@@ -201,18 +457,65 @@ OverlayDataSvc::OverlayDataSvc(const std::string& name,ISvcLocator* svc)
     // ROOT default compression
     declareProperty("compressionLevel",   m_compressionLevel   = 1);
     declareProperty("treeName",           m_treeName           = "Overlay");
+    declareProperty("OutputFormat",       m_outputFormat       = "object");
 
 	// This will allow the user to select out events which might have set one or more trigger bits
 	declareProperty("triggerRejectMask",  m_triggerRejectMask  = 0);
 
+    // Let the converters apply the cuts declared by the merge algorithms, so rejected objects are never built.
+    // Opt in: any other consumer of the overlay TDS then only sees what the merge algorithms kept
+    declareProperty("ApplyReadCuts",      m_applyReadCuts      = false);
+
+    // Refill the overlay section of the TDS in place each event rather than rebuilding it
+    declareProperty("ReuseOverlayTree",   m_reuseOverlayTree   = false);
+
+    // Sequential reads from a random start or random draws without replacement
+    declareProperty("SamplingMode",       m_samplingMode       = "Sequential");
+
+    // Restrict the input to library entries with acceptable PtOverlay quality fields
+    declareProperty("PreselectDataQual",        m_preselectDataQual);
+    declareProperty("PreselectLatMode",         m_preselectLatMode);
+    declareProperty("PreselectMinLivetimeFrac", m_preselectMinLivetimeFrac = 0.);
+    declareProperty("PreselectBranches",        m_preselectBranches        = "*m_ptOverlay*");
+    declareProperty("PreselectCacheDir",        m_preselectCacheDir        = "");
+
+    // Provenance recording and replay of the input entries used
+    declareProperty("ProvenanceFile",     m_provenanceFile     = "");
+    declareProperty("ReplayFile",         m_replayFile         = "");
+    declareProperty("ReplayBlockSize",    m_replayBlockSize    = 1000);
+
+    // Read inputs concurrently on a pool of this many threads (see DoMergeAlg PrefetchServices)
+    declareProperty("IoThreads",          m_ioThreads          = 0);
+
+    // ROOT read cache
+    declareProperty("ReadCacheSize",         m_readCacheSize         = 0);
+    declareProperty("ReadCacheLearnEntries", m_readCacheLearnEntries = 10);
+    declareProperty("ReadCacheBranches",     m_readCacheBranches);
+
+    // Parallel decompression of the input baskets
+    declareProperty("ParallelUnzip",         m_parallelUnzip         = false);
+    declareProperty("UnzipThreads",          m_unzipThreads          = 4);
+
+    // Stage input files to local disk
+    declareProperty("StageCacheDir",      m_stageCacheDir      = "");
+    declareProperty("StageCacheMaxGB",    m_stageCacheMaxGB    = 20.);
+    declareProperty("StageUseLinks",      m_stageUseLinks      = true);
+
+    // Page cache hints for the input files
+    declareProperty("PageCacheHints",       m_pageCacheHints       = false);
+    declareProperty("PageCacheWillNeedMB",  m_pageCacheWillNeedMB  = 512.);
+    declareProperty("PageCacheIdleSeconds", m_pageCacheIdleSeconds = 600.);
+
+    // Bins either side of the current one to stage or read ahead
+    declareProperty("NeighbourBins",      m_neighbourBins      = 1);
+
 	// Make sure the mask is one or more of the allowed bits
 	m_triggerRejectMask &= enums::b_ACDH+enums::b_HI_CAL+enums::b_LO_CAL+enums::b_Track+enums::b_ROI;
 
     m_objectList.clear();
 
     m_inputFileMap.clear();
-    m_inputIndexMap.clear();
-	m_inputEntriesMap.clear();
+    m_samplerMap.clear();
     m_clidToPathMap.clear();
 
     return;
@@ -266,8 +569,96 @@ StatusCode OverlayDataSvc::initialize()
     // Do the following if we have been configured for input
     if (m_configureForInput)
     {
-        // Now set up the input binning tool
-        if( !m_overlay.value().empty())
+        if (!OverlayBinSampler::modeFromName(m_samplingMode.value(), m_samplerMode))
+        {
+            log << MSG::ERROR << "Unknown SamplingMode " << m_samplingMode.value() << endreq;
+            return StatusCode::FAILURE;
+        }
+
+        // Set up local staging of the input files if requested
+        if (!m_stageCacheDir.value().empty())
+        {
+#ifndef WIN32
+            std::string stageDir = m_stageCacheDir.value();
+
+            facilities::Util::expandEnvVar(&stageDir);
+
+            m_stageCache = new OverlayStageCache(stageDir, m_stageCacheMaxGB * 1.e9, m_stageUseLinks);
+
+            log << MSG::INFO << "Staging input files to " << stageDir << endreq;
+#else
+            log << MSG::WARNING << "Staging of input files is not supported on this platform" << endreq;
+#endif
+        }
+
+        if (m_pageCacheHints)
+        {
+            m_pageHints = new OverlayPageCacheHints(m_pageCacheWillNeedMB * 1.e6, m_pageCacheIdleSeconds);
+        }
+
+        // Set up the library preselection, if any
+        std::string cacheDir = m_preselectCacheDir.value();
+
+        facilities::Util::expandEnvVar(&cacheDir);
+
+        m_preselection = new OverlayPreselection(m_preselectDataQual, 
+                                                 m_preselectLatMode, 
+                                                 m_preselectMinLivetimeFrac,
+                                                 m_preselectBranches.value(),
+                                                 cacheDir);
+
+        if (m_preselection->isActive())
+        {
+            log << MSG::INFO << "Preselecting library entries with " << m_preselection->describe() << endreq;
+        }
+        else
+        {
+            delete m_preselection;
+            m_preselection = 0;
+        }
+
+        // Set up for concurrent reading if requested
+        if (m_applyReadCuts)
+        {
+            log << MSG::INFO << "Read cuts declared by the merge algorithms will be applied to the overlay TDS" << endreq;
+        }
+
+        if (m_ioThreads > 0 && !OverlayIoPool::isAvailable())
+        {
+            log << MSG::WARNING << "This ROOT version cannot read from more than one thread, IoThreads ignored" << endreq;
+
+            m_ioThreads = 0;
+        }
+
+        // The decompression pool is ROOT's and is shared by the whole job, the first service to ask
+        // sets its size
+        if (m_parallelUnzip)
+        {
+            int unzipThreads = OverlayIoPool::acquireImplicitMT(m_unzipThreads);
+
+            if (unzipThreads == 0)
+            {
+                log << MSG::WARNING << "This ROOT version has no implicit multi-threading, UnzipThreads ignored and "
+                    << "baskets are decompressed by a read cache helper thread" << endreq;
+            }
+            else if (unzipThreads != m_unzipThreads)
+            {
+                log << MSG::WARNING << "UnzipThreads " << m_unzipThreads << " conflicts with the " << unzipThreads 
+                    << " threads already set for this job, using " << unzipThreads << endreq;
+            }
+            else log << MSG::INFO << "Decompressing input baskets on " << unzipThreads << " threads" << endreq;
+        }
+
+        if (m_ioThreads > 0)
+        {
+            m_ioPool  = OverlayIoPool::acquire(m_ioThreads);
+            m_readJob = new OverlayReadJob(this);
+
+            log << MSG::INFO << "Reading input on an I/O pool of " << m_ioThreads << " threads" << endreq;
+        }
+
+        // Now set up the input binning tool (not needed when replaying)
+        if( !m_overlay.value().empty() && m_replayFile.value().empty())
         {
             // Start with input xml file name
             std::string xmlFile = m_inputXmlFilePath.value() + "/" + m_inputXmlFileName.value() + ".xml";
@@ -297,6 +688,24 @@ StatusCode OverlayDataSvc::initialize()
         m_rootIoSvc->prepareRootOutput("OverlayOut", m_outputFileName, m_treeName, m_compressionLevel, "GLAST Digitization Data");
         m_eventOverlay = new EventOverlay();
         m_rootIoSvc->setupBranch("OverlayOut", "EventOverlay", "EventOverlay", &m_eventOverlay, m_bufSize, m_splitMode);
+
+        // Columnar output stores the Tkr, Cal and Acd collections in their own branches
+        if (m_outputFormat.value() == "columnar")
+        {
+            m_columnWriter = new OverlayColumnWriter();
+            m_columnWriter->setupBranches(m_rootIoSvc, "OverlayOut", m_bufSize);
+        }
+        // Snapshot output stores them, as found in the TDS, in one extra branch
+        else if (m_outputFormat.value() == "snapshot")
+        {
+            m_snapshotWriter = new OverlaySnapshotWriter();
+            m_snapshotWriter->setupBranch(m_rootIoSvc, "OverlayOut", m_bufSize);
+        }
+        else if (m_outputFormat.value() != "object")
+        {
+            log << MSG::ERROR << "Unknown OutputFormat: " << m_outputFormat.value() << endreq;
+            return StatusCode::FAILURE;
+        }
     }
 
     // use the incident service to register begin, end events
@@ -331,6 +740,72 @@ StatusCode OverlayDataSvc::initialize()
         m_rootName = m_rootName + nameEnding;
     }
 
+    // Provenance and replay both need the simulated run and event numbers
+    if (m_configureForInput && (!m_provenanceFile.value().empty() || !m_replayFile.value().empty()))
+    {
+        if (service("EventDataSvc", m_eventDataSvc, true).isFailure())
+        {
+            log << MSG::ERROR << "failed to get the EventDataSvc" << endreq;
+            return StatusCode::FAILURE;
+        }
+
+        if (!m_provenanceFile.value().empty())
+        {
+            std::string provFile = m_provenanceFile.value();
+
+            facilities::Util::expandEnvVar(&provFile);
+
+            m_provWriter = new OverlayProvenanceWriter(provFile);
+
+            if (!m_provWriter->isOpen())
+            {
+                log << MSG::ERROR << "Could not open provenance file " << provFile << endreq;
+                return StatusCode::FAILURE;
+            }
+
+            log << MSG::INFO << "Recording overlay provenance to " << provFile << endreq;
+        }
+
+        if (!m_replayFile.value().empty())
+        {
+            std::string replayFile = m_replayFile.value();
+
+            facilities::Util::expandEnvVar(&replayFile);
+
+            try
+            {
+                m_replayReader = new OverlayProvenanceReader(replayFile);
+            }
+            catch(std::exception& ex)
+            {
+                log << MSG::ERROR << ex.what() << endreq;
+                return StatusCode::FAILURE;
+            }
+
+            // Open all the libraries referenced by the replay file
+            const std::vector<OverlayProvenanceReader::Library>& libraries = m_replayReader->libraries();
+
+            for(std::vector<OverlayProvenanceReader::Library>::const_iterator libItr = libraries.begin(); 
+                libItr != libraries.end(); libItr++)
+            {
+                m_replayTypes.push_back(prepareInput(libItr->treeName, libItr->branchName, libItr->format, libItr->fileList));
+            }
+
+            // Keep track of where each simulated event is in case the events are not processed in the same order
+            const std::vector<OverlayProvenanceReader::Record>& records = m_replayReader->records();
+
+            for(size_t idx = 0; idx < records.size(); idx++)
+            {
+                m_replayIndexMap[std::make_pair(records[idx].run, records[idx].event)] = idx;
+            }
+
+            if (m_replayBlockSize < 1) m_replayBlockSize = 1;
+
+            log << MSG::INFO << "Replaying " << records.size() << " overlay events from " 
+                << libraries.size() << " libraries listed in " << replayFile << endreq;
+        }
+    }
+
     return status;
 }
 /// Service reinitialisation
@@ -348,19 +823,129 @@ StatusCode OverlayDataSvc::finalize()
     // Do the following if configured for input
     if (m_configureForInput)
     {
-        // Loop through any open files and close them
+        MsgStream log(msgSvc(), name());
+
+        // Make sure no read is outstanding before closing up shop
+        if (m_readPending) m_ioPool->wait(m_readJob);
+
+        m_readPending = false;
+
+        delete m_readJob;
+        m_readJob = 0;
+
+        if (m_ioPool) OverlayIoPool::release();
+        m_ioPool = 0;
+
+        // Loop through any open files, report on their usage and close them
         for(std::map<std::string,std::string>::iterator fileMapItr = m_inputFileMap.begin();
             fileMapItr != m_inputFileMap.end(); fileMapItr++)
         {
-            m_rootIoSvc->closeInput(fileMapItr->second);
+            std::map<std::string, OverlayBinSampler*>::iterator samplerItr = m_samplerMap.find(fileMapItr->second);
+
+            if (samplerItr != m_samplerMap.end())
+            {
+                OverlayBinSampler* sampler = samplerItr->second;
+
+                log << MSG::INFO << "Input " << fileMapItr->first << ": "
+                    << sampler->getNumEntries()  << " entries, "
+                    << sampler->getNumDraws()    << " draws ("
+                    << sampler->getNumRejected() << " rejected), "
+                    << sampler->getNumUsed()     << " distinct entries used, "
+                    << sampler->getNumPasses()   << " complete passes, max uses of one entry "
+                    << sampler->getMaxUses()     << endreq;
+
+                delete sampler;
+            }
+
+            std::map<std::string, OverlayReadCache*>::iterator cacheItr = m_readCacheMap.find(fileMapItr->second);
+
+            if (cacheItr != m_readCacheMap.end())
+            {
+                OverlayReadCache* readCache = cacheItr->second;
+
+                if (readCache == m_activeReadCache) readCache->deactivate();
+
+                double numReads = readCache->getNumReads() > 0 ? readCache->getNumReads() : 1.;
+
+                log << MSG::INFO << "Input " << fileMapItr->first << ": read cache efficiency "
+                    << readCache->getEfficiency() << ", "
+                    << readCache->getReadCalls() / numReads << " read calls and "
+                    << readCache->getBytesRead() / numReads << " bytes per event, "
+                    << readCache->getNumResets() << " resets on wrap" << endreq;
+
+                delete readCache;
+            }
+
+            std::map<std::string, OverlayObjectReader*>::iterator   objectItr   = m_objectReaderMap.find(fileMapItr->second);
+            std::map<std::string, OverlayColumnReader*>::iterator   readerItr   = m_columnReaderMap.find(fileMapItr->second);
+            std::map<std::string, OverlaySnapshotReader*>::iterator snapshotItr = m_snapshotReaderMap.find(fileMapItr->second);
+
+            if      (objectItr   != m_objectReaderMap.end())   delete objectItr->second;
+            else if (readerItr   != m_columnReaderMap.end())   delete readerItr->second;
+            else if (snapshotItr != m_snapshotReaderMap.end()) delete snapshotItr->second;
+        }
+
+        m_objectReaderMap.clear();
+
+        m_columnReaderMap.clear();
+        m_columns = 0;
+
+        m_snapshotReaderMap.clear();
+        m_snapshot = 0;
+
+        m_samplerMap.clear();
+        m_readCacheMap.clear();
+        m_activeReadCache = 0;
+
+        // Only now that our chains are gone
+        if (m_parallelUnzip) OverlayIoPool::releaseImplicitMT();
+
+        if (m_stageCache)
+        {
+            log << MSG::INFO << "Staging cache: " << m_stageCache->getNumStaged() << " files staged, " 
+                << m_stageCache->getNumHits() << " already present, " 
+                << m_stageCache->getNumFailed() << " read in place" << endreq;
         }
 
+        delete m_stageCache;
+        m_stageCache = 0;
+
+        if (m_pageHints)
+        {
+            log << MSG::INFO << "Page cache hints: " << m_pageHints->getNumWillNeed() << " files read ahead, "
+                << m_pageHints->getNumDontNeed() << " files released" << endreq;
+        }
+
+        delete m_pageHints;
+        m_pageHints = 0;
+
         delete m_fetch;
+        delete m_preselection;
+
+        // Clean up after provenance/replay
+        for(std::vector<EventOverlay*>::iterator blockItr = m_replayBlock.begin(); blockItr != m_replayBlock.end(); blockItr++)
+        {
+            delete *blockItr;
+        }
+
+        m_replayBlock.clear();
+
+        delete m_provWriter;
+        delete m_replayReader;
+
+        m_provWriter   = 0;
+        m_replayReader = 0;
     }
     // Otherwise, do the output finalization
     else 
     {
         m_rootIoSvc->closeFile("OverlayOut");
+
+        delete m_columnWriter;
+        m_columnWriter = 0;
+
+        delete m_snapshotWriter;
+        m_snapshotWriter = 0;
     }
 
     DataSvc::finalize();
@@ -377,101 +962,353 @@ EventOverlay* OverlayDataSvc::getRootEventOverlay()
     return m_eventOverlay;
 }
 
-StatusCode OverlayDataSvc::selectNextEvent()
+const OverlayColumns* OverlayDataSvc::getOverlayColumns()
 {
-    MsgStream log(msgSvc(), name());
+    if (m_needToReadEvent && m_configureForInput) selectNextEvent();
 
-    if (m_configureForInput)
-    {
-        // Get the desired bin
-        double x = m_binTool->value();
+    return m_columns;
+}
 
-        // First check that the returned value is within range
-        if( !m_fetch->isValid(x) )
-        {
-            log << MSG::ERROR 
-                << "selectEvent: called with " << name() 
-                <<" = "<< x << " is not in range " 
-                <<  m_fetch->minValFullRange() << ", to " 
-                <<  m_fetch->maxValFullRange() 
-                << endreq;
-            return StatusCode::FAILURE;
-        }
+const OverlaySnapshot* OverlayDataSvc::getOverlaySnapshot()
+{
+    if (m_needToReadEvent && m_configureForInput) selectNextEvent();
 
-        // make sure we have the right tree selected for new value    
-        // if still valid, do not change
-        if( !m_fetch->isCurrent(x) )
-        {
-            // New bin, set new tree
-            setNewInputBin(x);   
-        }
+    return m_snapshot;
+}
 
-        // If m_eventOverlay is not null then we have a problem
-        if (!m_needToReadEvent)
-        {
-            log << MSG::ERROR << "Found non-zero pointer to EventOverlay during event loop!" << endreq;
-            return StatusCode::FAILURE;
-        }
+const OverlayEventView* OverlayDataSvc::getOverlayEventView()
+{
+    if (!m_configureForInput) return 0;
 
-        // Retrieve and increment the index (and, by definition, it exists!)
-        std::map<std::string, long long>::iterator inputIndexIter = m_inputIndexMap.find(m_curFileType);
+    EventOverlay* overlayRoot = getRootEventOverlay();
 
-		bool happy = false;
+    if (!overlayRoot) return 0;
 
-		while(!happy)
-		{
-			long long inputIndex = inputIndexIter->second;
-
-			// update the input index
-			inputIndexIter->second = inputIndex + 1;
-
-			// Poor man's mod
-			if (inputIndexIter->second >= m_inputEntriesMap[m_curFileType]) inputIndexIter->second = 0;
-
-			// Try reading the event this way... 
-			// using treename as the key
-			m_eventOverlay = dynamic_cast<EventOverlay*>(m_rootIoSvc->getNextEvent(m_curFileType, inputIndex));
-
-			// If the call returns a null pointer then we have some sort of IO error that needs to be trapped
-			if( m_eventOverlay == 0)
-			{ 
-				log << MSG::ERROR 
-					<< "selectEvent: called with " << name() 
-					<< ": Error detected in RootIO call"
-					<< endreq;
-				return StatusCode::FAILURE;
-			}
+    // Filled once per event, the generation is never zero once an event has begun
+    if (m_eventViewGeneration != m_eventGeneration)
+    {
+        OverlayTdsFill::fillEventView(m_eventView, *overlayRoot, m_columns, m_snapshot, getReadCuts());
 
-			// If the trigger reject mask is non-zero then check to see if allowed input overlay event
-			if (m_triggerRejectMask)
-			{
-				unsigned int trigger = m_eventOverlay->getGemOverlay().getConditionSummary();
+        m_eventViewGeneration = m_eventGeneration;
+    }
 
-				if (trigger & m_triggerRejectMask)
-				{
-					continue;
-				}
-			}
+    return &m_eventView;
+}
 
-			happy = true;
-		}
+void OverlayDataSvc::declareReadCuts(const OverlayReadCuts& cuts)
+{
+    m_readCuts.combine(cuts);
 
-        // Set flag to indicate we have read the event
-        m_needToReadEvent = false;
+    // The declarations come from the merge algorithms' initialize, after ours, so the effective cuts
+    // are reported each time they change
+    if (m_applyReadCuts && cuts.isDeclared())
+    {
+        MsgStream log(msgSvc(), name());
+        log << MSG::INFO << "Applying read cuts: " << m_readCuts.describe() 
+            << ", other consumers of the overlay TDS see only these objects" << endreq;
     }
 
-    return StatusCode::SUCCESS;
+    return;
 }
 
-StatusCode OverlayDataSvc::registerOutputPath(const std::string& path)
+const OverlayReadCuts& OverlayDataSvc::getReadCuts() const
 {
-    m_objectList.push_back(path);
+    static const OverlayReadCuts acceptAll;
 
-    return StatusCode::SUCCESS;
+    return m_applyReadCuts ? m_readCuts : acceptAll;
 }
 
-// handle "incidents"
-void OverlayDataSvc::handle(const Incident &inc)
+namespace
+{
+    /// Collects the registry entries below the root of a data service
+    class OverlayLeafCollector : virtual public IDataStoreAgent
+    {
+    public:
+        OverlayLeafCollector(IRegistry* root) : m_root(root) {}
+        virtual ~OverlayLeafCollector() {}
+
+        virtual bool analyse(IRegistry* entry, int)
+        {
+            if (entry != m_root) m_leaves.push_back(entry);
+            return true;
+        }
+
+        const std::vector<IRegistry*>& getLeaves() const {return m_leaves;}
+
+    private:
+        IRegistry*              m_root;
+        std::vector<IRegistry*> m_leaves;
+    };
+}
+
+StatusCode OverlayDataSvc::refillOverlayTree()
+{
+    if (!m_reuseOverlayTree) return StatusCode::FAILURE;
+
+    // The tree must have been built in an earlier event
+    DataObject* header = 0;
+    if (findObject(rootName(), header).isFailure() || !header) return StatusCode::FAILURE;
+
+    OverlayLeafCollector collector(header->registry());
+    if (traverseSubTree(rootName(), &collector).isFailure()) return StatusCode::FAILURE;
+
+    const std::vector<IRegistry*>& leaves = collector.getLeaves();
+
+    if (m_configureForInput)
+    {
+        EventOverlay* overlayRoot = getRootEventOverlay();
+        if (!overlayRoot) return StatusCode::FAILURE;
+
+        const OverlayColumns*  columns  = getOverlayColumns();
+        const OverlaySnapshot* snapshot = getOverlaySnapshot();
+        const OverlayReadCuts& cuts     = getReadCuts();
+
+        if (!OverlayTdsFill::refill(header, *overlayRoot, columns, snapshot, cuts)) return StatusCode::FAILURE;
+
+        for(std::vector<IRegistry*>::const_iterator leafItr = leaves.begin(); leafItr != leaves.end(); leafItr++)
+        {
+            DataObject* object = (*leafItr)->object();
+
+            // Never loaded, its address converts the current event when it is first used
+            if (!object) continue;
+
+            if (OverlayTdsFill::refill(object, *overlayRoot, columns, snapshot, cuts)) continue;
+
+            // Otherwise replace it by a new object
+            std::string path      = (*leafItr)->identifier();
+            DataObject* newObject = OverlayTdsFill::create(object->clID(), *overlayRoot, columns, snapshot, cuts);
+
+            if (unregisterObject(object).isFailure()) return StatusCode::FAILURE;
+
+            delete object;
+
+            if (newObject && registerObject(path, newObject).isFailure())
+            {
+                delete newObject;
+                return StatusCode::FAILURE;
+            }
+        }
+    }
+    else
+    {
+        // The header is filled again by EventToOverlayTool, the collections are emptied and 
+        // anything else is dropped to be made again by the translation tools
+        for(std::vector<IRegistry*>::const_iterator leafItr = leaves.begin(); leafItr != leaves.end(); leafItr++)
+        {
+            DataObject* object = (*leafItr)->object();
+
+            if (!object || OverlayTdsFill::clear(object)) continue;
+
+            if (unregisterObject(object).isFailure()) return StatusCode::FAILURE;
+
+            delete object;
+        }
+    }
+
+    return StatusCode::SUCCESS;
+}
+
+StatusCode OverlayDataSvc::selectNextEvent()
+{
+    if (m_configureForInput)
+    {
+        // When replaying there is no bin selection, the entry comes from the provenance file
+        if (m_replayReader) return replayNextEvent();
+
+        // If the read was started by prefetchEvent then we only need to wait for it
+        if (m_readPending)
+        {
+            m_ioPool->wait(m_readJob);
+            m_readPending = false;
+        }
+        else
+        {
+            StatusCode status = selectInputBin();
+
+            if (status.isFailure()) return status;
+
+            readNextEvent();
+        }
+
+        return finishRead();
+    }
+
+    return StatusCode::SUCCESS;
+}
+
+StatusCode OverlayDataSvc::prefetchEvent()
+{
+    // Nothing to do unless reading with an I/O pool and the event has not already been read (or started)
+    if (!m_configureForInput || !m_ioPool || m_replayReader || !m_needToReadEvent || m_readPending) 
+        return StatusCode::SUCCESS;
+
+    // The bin selection needs the TDS so is done here, only the reading is handed to the pool
+    StatusCode status = selectInputBin();
+
+    if (status.isFailure()) return status;
+
+    m_readPending = true;
+    m_ioPool->submit(m_readJob);
+
+    return StatusCode::SUCCESS;
+}
+
+StatusCode OverlayDataSvc::selectInputBin()
+{
+    MsgStream log(msgSvc(), name());
+
+    // Get the desired bin
+    double x = m_binTool->value();
+
+    // First check that the returned value is within range
+    if( !m_fetch->isValid(x) )
+    {
+        log << MSG::ERROR 
+            << "selectEvent: called with " << name() 
+            <<" = "<< x << " is not in range " 
+            <<  m_fetch->minValFullRange() << ", to " 
+            <<  m_fetch->maxValFullRange() 
+            << endreq;
+        return StatusCode::FAILURE;
+    }
+
+    // make sure we have the right tree selected for new value    
+    // if still valid, do not change
+    if( !m_fetch->isCurrent(x) )
+    {
+        // New bin, set new tree
+        setNewInputBin(x);   
+    }
+
+    // If m_eventOverlay is not null then we have a problem
+    if (!m_needToReadEvent)
+    {
+        log << MSG::ERROR << "Found non-zero pointer to EventOverlay during event loop!" << endreq;
+        return StatusCode::FAILURE;
+    }
+
+    return StatusCode::SUCCESS;
+}
+
+void OverlayDataSvc::readNextEvent()
+{
+    // Note that this may run on an I/O pool thread so must not use the TDS or message service
+
+    // Retrieve the sampler for this bin (and, by definition, it exists!)
+    OverlayBinSampler* sampler   = m_samplerMap[m_curFileType];
+    OverlayReadCache*  readCache = m_activeReadCache;
+
+	bool happy = false;
+
+	while(!happy)
+	{
+        long long numWraps = sampler->getNumWraps();
+
+		m_readIndex = sampler->next();
+
+        // Cached baskets are no use after wrapping back to the start
+        if (readCache && sampler->getNumWraps() != numWraps) readCache->wrapped();
+
+		// Try reading the event this way... 
+		// using treename as the key
+        if (readCache) readCache->beginRead();
+
+		m_eventOverlay = readEntry(m_curFileType, m_readIndex);
+
+        if (readCache) readCache->endRead();
+
+		// If the call returns a null pointer then we have some sort of IO error, trapped in finishRead
+		if( m_eventOverlay == 0) return;
+
+		// If the trigger reject mask is non-zero then check to see if allowed input overlay event
+		if (m_triggerRejectMask)
+		{
+			unsigned int trigger = m_eventOverlay->getGemOverlay().getConditionSummary();
+
+			if (trigger & m_triggerRejectMask)
+			{
+				sampler->reject();
+				continue;
+			}
+		}
+
+		happy = true;
+	}
+
+    return;
+}
+
+StatusCode OverlayDataSvc::finishRead()
+{
+    MsgStream log(msgSvc(), name());
+
+    if( m_eventOverlay == 0)
+    { 
+        log << MSG::ERROR 
+            << "selectEvent: called with " << name() 
+            << ": Error detected in RootIO call"
+            << endreq;
+        return StatusCode::FAILURE;
+    }
+
+    // Keep track of where this event came from
+    if (m_provWriter) recordProvenance(m_readIndex);
+
+    // Set flag to indicate we have read the event
+    m_needToReadEvent = false;
+
+    return StatusCode::SUCCESS;
+}
+
+void OverlayDataSvc::activateReadCache()
+{
+    std::map<std::string, OverlayReadCache*>::iterator cacheItr = m_readCacheMap.find(m_curFileType);
+
+    OverlayReadCache* readCache = cacheItr != m_readCacheMap.end() ? cacheItr->second : 0;
+
+    if (readCache == m_activeReadCache) return;
+
+    // Only the current input holds a cache
+    if (m_activeReadCache) m_activeReadCache->deactivate();
+
+    m_activeReadCache = readCache;
+
+    if (m_activeReadCache) m_activeReadCache->activate();
+
+    return;
+}
+
+std::vector<std::string> OverlayDataSvc::getNeighbourBinFiles()
+{
+    std::vector<std::string> fileList;
+    int                      binIndex = m_fetch->getCurrentBinIndex();
+
+    for(int offset = 1; offset <= m_neighbourBins; offset++)
+    {
+        std::vector<std::string> loList = m_fetch->getFilesByIndex(binIndex - offset);
+        std::vector<std::string> hiList = m_fetch->getFilesByIndex(binIndex + offset);
+
+        fileList.insert(fileList.end(), loList.begin(), loList.end());
+        fileList.insert(fileList.end(), hiList.begin(), hiList.end());
+    }
+
+    return fileList;
+}
+
+void OverlayReadJob::run()
+{
+    m_dataSvc->readNextEvent();
+}
+
+StatusCode OverlayDataSvc::registerOutputPath(const std::string& path)
+{
+    m_objectList.push_back(path);
+
+    return StatusCode::SUCCESS;
+}
+
+// handle "incidents"
+void OverlayDataSvc::handle(const Incident &inc)
 {
     if      ( inc.type()=="BeginEvent") beginEvent();
     else if (inc.type()=="EndEvent")    endEvent();
@@ -479,12 +1316,28 @@ void OverlayDataSvc::handle(const Incident &inc)
 
 void OverlayDataSvc::beginEvent() // should be called at the beginning of an event
 { 
+    // Scratch memory of the previous event is no longer in use
+    OverlayArena::eventArena().reset();
+
+    // Objects found by handles in the previous event are gone
+    m_eventGeneration++;
+
     // What we do depends on our configuration
     if (m_configureForInput)
     {
+        // A read started for the previous event but never used must be finished before clearing
+        if (m_readPending)
+        {
+            m_ioPool->wait(m_readJob);
+            m_readPending = false;
+        }
+
         // At beginning of event we need to clear our EventOverlay object
         m_myOverlay.Clear(m_clearOption.value().c_str());
 
+        m_columns  = 0;
+        m_snapshot = 0;
+
         // Set the flag to indicate the need to input the next event
         m_needToReadEvent = true;
     }
@@ -510,6 +1363,8 @@ void OverlayDataSvc::endEvent()  // must be called at the end of an event to upd
             // Now do a clear of the root DigiEvent root object
             m_eventOverlay->Clear();
 
+            if (m_snapshotWriter) m_snapshotWriter->clear();
+
             // Go through list of data objects and "convert" them...
             for(std::vector<std::string>::iterator dataIter = m_objectList.begin();
                                                    dataIter != m_objectList.end();
@@ -520,10 +1375,19 @@ void OverlayDataSvc::endEvent()  // must be called at the end of an event to upd
                 DataObject* object = 0;
                 StatusCode status = retrieveObject(rootName() + path, object);
 
+                // A snapshot takes the Tkr, Cal and Acd collections as they are
+                if (m_snapshotWriter && m_snapshotWriter->add(object)) continue;
+
                 IOpaqueAddress* address = 0;
                 status = m_cnvSvc->createRep(object, address);
             }
 
+            // Move the Tkr, Cal and Acd collections into their columns
+            if (m_columnWriter) m_columnWriter->fill(*m_eventOverlay);
+
+            // Or serialize them into the snapshot
+            if (m_snapshotWriter) m_snapshotWriter->fill();
+
             // Now fill the root tree for this event
             m_rootIoSvc->fillTree("OverlayOut");
         }
@@ -547,39 +1411,46 @@ void OverlayDataSvc::setNewInputBin(double x)
 
     std::string fileName = fileList[0];
 
+    // Stage the neighbouring bins in the background, they are the most likely to be needed next
+    if (m_stageCache) m_stageCache->stageInBackground(getNeighbourBinFiles());
+
     if (m_inputFileMap.find(fileName) == m_inputFileMap.end())
     {
         try 
         {
-            // Create a rootIoSvc "type" name to identify this file to RootIoSvc
-            std::stringstream rootType;
-
-            rootType << m_rootName << "_" << m_inputFileMap.size();
-
-            // Set it as our "current" file type
-            m_curFileType = rootType.str();
-
-            // And store this away in our map of opened files
-            m_inputFileMap[fileName] = m_curFileType;
+            // Open the new input files and set them as our "current" file type
+            m_curFileType = prepareInput(m_fetch->getTreeName(), m_fetch->getBranchName(), m_fetch->getFormat(), fileList);
 
-            // Open the new input files
-            m_rootIoSvc->prepareRootInput(m_curFileType, 
-                                          m_fetch->getTreeName(), 
-                                          m_fetch->getBranchName(),
-                                         (TObject**)&m_myOverlayPtr,
-                                          fileList);
+            // The sampler selects events within the allowed number of events
+            std::map<std::string, OverlayObjectReader*>::iterator   objectItr   = m_objectReaderMap.find(m_curFileType);
+            std::map<std::string, OverlayColumnReader*>::iterator   readerItr   = m_columnReaderMap.find(m_curFileType);
+            std::map<std::string, OverlaySnapshotReader*>::iterator snapshotItr = m_snapshotReaderMap.find(m_curFileType);
 
-            // Select a random starting position within the allowed number of events
-            long long numEventsLong = m_rootIoSvc->getRootEvtMax(m_curFileType);
-            double    numEvents     = numEventsLong;
-            long long startEvent    = (long long)(CLHEP::RandFlat::shoot() * (numEvents - 1));
-            //Long64_t startEvent    = (Long64_t)(CLHEP::RandFlat::shoot() * (numEvents - 1));
+            long long numEventsLong = objectItr   != m_objectReaderMap.end()   ? objectItr->second->getEntries()
+                                    : readerItr   != m_columnReaderMap.end()   ? readerItr->second->getEntries() 
+                                    : snapshotItr->second->getEntries();
 
-            // Set the index in our local map
-            m_inputIndexMap[m_curFileType] = startEvent;
-
-			// And keep track of the total number of events
-			m_inputEntriesMap[m_curFileType] = numEventsLong;
+            // If preselecting then restrict to the eligible entries, found once when the library is opened
+            if (m_preselection)
+            {
+                // Scan the staged copies if we have them
+                std::vector<std::string> scanList = m_stageCache ? m_stageCache->localFiles(fileList) : fileList;
+                std::vector<long long>   entries  = m_preselection->eligibleEntries(m_fetch->getTreeName(), 
+                                                                                    m_fetch->getBranchName(), 
+                                                                                    scanList);
+
+                log << MSG::INFO << "Preselection accepts " << entries.size() << " of " << numEventsLong 
+                    << " entries in " << fileName << endreq;
+
+                if (entries.empty())
+                {
+                    log << MSG::ERROR << "No eligible entries in " << fileName << endreq;
+                    throw std::runtime_error("OverlayDataSvc: no eligible entries in " + fileName);
+                }
+
+                m_samplerMap[m_curFileType] = new OverlayBinSampler(entries, m_samplerMode);
+            }
+            else m_samplerMap[m_curFileType] = new OverlayBinSampler(numEventsLong, m_samplerMode);
         } 
         catch(...) 
         {
@@ -592,6 +1463,265 @@ void OverlayDataSvc::setNewInputBin(double x)
         m_curFileType = m_inputFileMap[fileName];
     }
 
+    if (m_readCacheSize > 0 || m_parallelUnzip) activateReadCache();
+
+    // Read ahead the new bin and its neighbours (unless they are being staged), release idle bins
+    if (m_pageHints)
+    {
+        std::vector<std::string> predictedFiles;
+
+        if (!m_stageCache) predictedFiles = getNeighbourBinFiles();
+
+        m_pageHints->binChanged(m_curFileType, m_inputListMap[m_curFileType], predictedFiles);
+    }
+
+    return;
+}
+
+std::string OverlayDataSvc::prepareInput(const std::string&              treeName, 
+                                         const std::string&              branchName, 
+                                         const std::string&              format,
+                                         const std::vector<std::string>& fileList)
+{
+    std::string fileName = fileList[0];
+
+    // Already open?
+    if (m_inputFileMap.find(fileName) != m_inputFileMap.end()) return m_inputFileMap[fileName];
+
+    // Create a "type" name to identify this input
+    std::stringstream rootType;
+
+    rootType << m_rootName << "_" << m_inputFileMap.size();
+
+    // And store this away in our map of opened files
+    m_inputFileMap[fileName] = rootType.str();
+
+    // Open the new input files, from the local staging cache if we have one
+    std::vector<std::string> inputList = m_stageCache ? m_stageCache->localFiles(fileList) : fileList;
+
+    // Every format is read by a reader of our own (see OverlayObjectReader)
+    TChain* chain = 0;
+
+    if (format == "columnar")
+    {
+        OverlayColumnReader* reader = new OverlayColumnReader(treeName, branchName, inputList);
+
+        m_columnReaderMap[rootType.str()] = reader;
+        chain = reader->getChain();
+    }
+    else if (format == "snapshot")
+    {
+        OverlaySnapshotReader* reader = new OverlaySnapshotReader(treeName, branchName, inputList);
+
+        m_snapshotReaderMap[rootType.str()] = reader;
+        chain = reader->getChain();
+    }
+    else if (format == "object")
+    {
+        OverlayObjectReader* reader = new OverlayObjectReader(treeName, branchName, inputList, &m_myOverlayPtr);
+
+        m_objectReaderMap[rootType.str()] = reader;
+        chain = reader->getChain();
+    }
+    else throw std::runtime_error("OverlayDataSvc: unknown library format " + format + " for " + fileName);
+
+    m_inputListMap[rootType.str()] = inputList;
+
+    // Take control of the read cache (and decompression) for this input
+    if (m_readCacheSize > 0 || m_parallelUnzip)
+    {
+        OverlayReadCache* readCache = new OverlayReadCache(chain, m_readCacheSize, m_readCacheLearnEntries, m_readCacheBranches);
+
+        readCache->setParallelUnzip(m_parallelUnzip);
+
+        m_readCacheMap[rootType.str()] = readCache;
+    }
+
+    // Declare the new library to the provenance file
+    if (m_provWriter) m_libraryMap[rootType.str()] = m_provWriter->addLibrary(treeName, branchName, format, fileList);
+
+    return rootType.str();
+}
+
+EventOverlay* OverlayDataSvc::readEntry(const std::string& type, long long entry)
+{
+    std::map<std::string, OverlayColumnReader*>::iterator readerItr = m_columnReaderMap.find(type);
+
+    if (readerItr != m_columnReaderMap.end())
+    {
+        EventOverlay* eventOverlay = readerItr->second->read(entry);
+
+        m_columns  = eventOverlay ? readerItr->second->getColumns() : 0;
+        m_snapshot = 0;
+
+        return eventOverlay;
+    }
+
+    std::map<std::string, OverlaySnapshotReader*>::iterator snapshotItr = m_snapshotReaderMap.find(type);
+
+    if (snapshotItr != m_snapshotReaderMap.end())
+    {
+        EventOverlay* eventOverlay = snapshotItr->second->read(entry);
+
+        m_columns  = 0;
+        m_snapshot = eventOverlay ? snapshotItr->second->getSnapshot() : 0;
+
+        return eventOverlay;
+    }
+
+    m_columns  = 0;
+    m_snapshot = 0;
+
+    std::map<std::string, OverlayObjectReader*>::iterator objectItr = m_objectReaderMap.find(type);
+
+    return objectItr != m_objectReaderMap.end() ? objectItr->second->read(entry) : 0;
+}
+
+void OverlayDataSvc::recordProvenance(long long entry)
+{
+    SmartDataPtr<Event::EventHeader> header(m_eventDataSvc, EventModel::EventHeader);
+
+    unsigned int run   = header ? header->run()   : 0;
+    unsigned int event = header ? header->event() : 0;
+
+    m_provWriter->record(run, event, m_libraryMap[m_curFileType], entry);
+
     return;
 }
 
+StatusCode OverlayDataSvc::replayNextEvent()
+{
+    MsgStream log(msgSvc(), name());
+
+    const std::vector<OverlayProvenanceReader::Record>& records = m_replayReader->records();
+
+    m_eventOverlay = 0;
+
+    // Events are expected in the same order as recorded, check this against the simulated event
+    SmartDataPtr<Event::EventHeader> header(m_eventDataSvc, EventModel::EventHeader);
+
+    unsigned int run   = header ? header->run()   : 0;
+    unsigned int event = header ? header->event() : 0;
+
+    if (m_replayCursor < records.size() && records[m_replayCursor].run == run && records[m_replayCursor].event == event)
+    {
+        // Read the next block if we have exhausted the current one, or if a lookup has moved
+        // the cursor back before it
+        if (m_replayCursor < m_replayBlockStart || m_replayCursor >= m_replayBlockStart + m_replayBlock.size())
+        {
+            if (loadReplayBlock().isFailure()) return StatusCode::FAILURE;
+        }
+
+        m_eventOverlay = m_replayBlock[m_replayCursor - m_replayBlockStart];
+        m_curFileType  = m_replayTypes[records[m_replayCursor].library];
+        m_columns      = 0;
+        m_snapshot     = 0;
+
+        // Columnar and snapshot entries are not held in the block, read them now
+        if (!m_eventOverlay)
+        {
+            m_eventOverlay = readEntry(m_curFileType, records[m_replayCursor].entry);
+
+            if (m_eventOverlay == 0)
+            { 
+                log << MSG::ERROR << "replayNextEvent: Error detected in columnar or snapshot read" << endreq;
+                return StatusCode::FAILURE;
+            }
+        }
+
+        if (m_provWriter) recordProvenance(records[m_replayCursor].entry);
+
+        m_replayCursor++;
+    }
+    // Otherwise look it up and read it directly
+    else
+    {
+        std::map<std::pair<unsigned int, unsigned int>, size_t>::iterator indexItr = 
+            m_replayIndexMap.find(std::make_pair(run, event));
+
+        if (indexItr == m_replayIndexMap.end())
+        {
+            log << MSG::ERROR << "Run " << run << ", event " << event << " not found in replay file" << endreq;
+            return StatusCode::FAILURE;
+        }
+
+        const OverlayProvenanceReader::Record& record = records[indexItr->second];
+
+        m_curFileType  = m_replayTypes[record.library];
+        m_eventOverlay = readEntry(m_curFileType, record.entry);
+
+        if (m_eventOverlay == 0)
+        { 
+            log << MSG::ERROR << "replayNextEvent: Error detected in RootIO call" << endreq;
+            return StatusCode::FAILURE;
+        }
+
+        if (m_provWriter) recordProvenance(record.entry);
+
+        // Resume sequential replay after this event
+        m_replayCursor = indexItr->second + 1;
+    }
+
+    // Set flag to indicate we have read the event
+    m_needToReadEvent = false;
+
+    return StatusCode::SUCCESS;
+}
+
+StatusCode OverlayDataSvc::loadReplayBlock()
+{
+    MsgStream log(msgSvc(), name());
+
+    // Release the previous block
+    for(std::vector<EventOverlay*>::iterator blockItr = m_replayBlock.begin(); blockItr != m_replayBlock.end(); blockItr++)
+    {
+        delete *blockItr;
+    }
+
+    const std::vector<OverlayProvenanceReader::Record>& records = m_replayReader->records();
+
+    size_t blockEnd = std::min(m_replayCursor + m_replayBlockSize, records.size());
+
+    m_replayBlockStart = m_replayCursor;
+    m_replayBlock.assign(blockEnd - m_replayBlockStart, 0);
+
+    // Read the entries in order of library and entry so each file (and basket) is visited once
+    typedef std::pair<std::pair<unsigned int, long long>, size_t> ReadOrder;
+
+    std::vector<ReadOrder> readOrder;
+
+    for(size_t idx = m_replayBlockStart; idx < blockEnd; idx++)
+    {
+        // A copy of the EventOverlay would not carry the columns or snapshot, these entries are read when used
+        const std::string& type = m_replayTypes[records[idx].library];
+
+        if (m_columnReaderMap.find(type)   != m_columnReaderMap.end())   continue;
+        if (m_snapshotReaderMap.find(type) != m_snapshotReaderMap.end()) continue;
+
+        readOrder.push_back(ReadOrder(std::make_pair(records[idx].library, records[idx].entry), idx - m_replayBlockStart));
+    }
+
+    std::sort(readOrder.begin(), readOrder.end());
+
+    EventOverlay* lastRead = 0;
+
+    for(std::vector<ReadOrder>::iterator readItr = readOrder.begin(); readItr != readOrder.end(); readItr++)
+    {
+        // The same entry may have been used more than once, no need to read it again
+        if (!lastRead || readItr == readOrder.begin() || readItr->first != (readItr - 1)->first)
+        {
+            lastRead = readEntry(m_replayTypes[readItr->first.first], readItr->first.second);
+
+            if (lastRead == 0)
+            { 
+                log << MSG::ERROR << "loadReplayBlock: Error detected in RootIO call" << endreq;
+                return StatusCode::FAILURE;
+            }
+        }
+
+        m_replayBlock[readItr->second] = dynamic_cast<EventOverlay*>(lastRead->Clone());
+    }
+
+    return StatusCode::SUCCESS;
+}
+
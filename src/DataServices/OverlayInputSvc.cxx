@@ -20,6 +20,7 @@
 
 #include "../InputControl/XmlFetchEvents.h"
 #include "Overlay/IOverlayDataSvc.h"
+#include "Overlay/OverlayReadCuts.h"
 #include "Overlay/IBackgroundBinTool.h"
 #include "Overlay/IFetchEvents.h"
 
@@ -40,9 +41,38 @@ public:
     /// Get pointer to a Root DigiEvent object
     virtual EventOverlay* getRootEventOverlay();
 
+    /// Columnar input is not supported by this service
+    virtual const OverlayColumns* getOverlayColumns() {return 0;}
+
+    /// Snapshot input is not supported by this service either
+    virtual const OverlaySnapshot* getOverlaySnapshot() {return 0;}
+
+    /// Nor is the event view
+    virtual const OverlayEventView* getOverlayEventView() {return 0;}
+
+    /// Read cuts are not applied by this service, declarations are ignored
+    virtual void declareReadCuts(const OverlayReadCuts&) {return;}
+
+    /// So everything is accepted
+    virtual const OverlayReadCuts& getReadCuts() const
+    {
+        static const OverlayReadCuts acceptAll;
+
+        return acceptAll;
+    }
+
+    /// Incremented at each BeginEvent, see OverlayTdsHandle
+    virtual unsigned long getEventGeneration() const {return m_eventGeneration;}
+
+    /// The overlay tree is always rebuilt, callers then set the root as usual
+    virtual StatusCode refillOverlayTree() {return StatusCode::FAILURE;}
+
     /// Select the next event
     virtual StatusCode selectNextEvent();
 
+    /// No background reading for this service
+    virtual StatusCode prefetchEvent() {return StatusCode::SUCCESS;}
+
     /// Register an output path with us
     virtual StatusCode registerOutputPath(const std::string&) {return StatusCode::SUCCESS;}
 
@@ -88,6 +118,9 @@ private:
     // flag to signal that we need to read the current event
     bool                m_needToReadEvent;
 
+    /// Incremented at each BeginEvent
+    unsigned long       m_eventGeneration;
+
     StringProperty      m_inputXmlFilePath;
 
     /// Option string which will be passed to McEvent::Clear
@@ -106,7 +139,8 @@ DECLARE_SERVICE_FACTORY(OverlayInputSvc);
 
 /// Standard Constructor
 OverlayInputSvc::OverlayInputSvc(const std::string& name,ISvcLocator* svc) : Service(name,svc),
-                               m_rootIoSvc(0), m_curFileType(""), m_eventOverlay(0), m_myOverlayPtr(&m_myOverlay), m_needToReadEvent(true)
+                               m_rootIoSvc(0), m_curFileType(""), m_eventOverlay(0), m_myOverlayPtr(&m_myOverlay), m_needToReadEvent(true),
+                               m_eventGeneration(0)
 {
     // Input pararmeters that may be set via the jobOptions file
     // Input ROOT file name  provided for backward compatibility, digiRootFileList is preferred
@@ -302,7 +336,12 @@ StatusCode OverlayInputSvc::selectNextEvent()
 // handle "incidents"
 void OverlayInputSvc::handle(const Incident &inc)
 {
-    if      ( inc.type()=="BeginEvent") beginEvent();
+    if      ( inc.type()=="BeginEvent")
+    {
+        // Objects found in earlier events are gone (see OverlayTdsHandle)
+        m_eventGeneration++;
+        beginEvent();
+    }
     else if (inc.type()=="EndEvent")    endEvent();
 }
 
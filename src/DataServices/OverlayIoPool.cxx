@@ -0,0 +1,174 @@
+/**  @file OverlayIoPool.cxx
+@brief implementation of class OverlayIoPool
+
+$Header$
+*/
+
+#include "OverlayIoPool.h"
+
+#include "TThread.h"
+#include "TMutex.h"
+#include "TCondition.h"
+#include "TROOT.h"
+#include "RVersion.h"
+
+OverlayIoPool* OverlayIoPool::s_pool  = 0;
+int            OverlayIoPool::s_users = 0;
+
+int            OverlayIoPool::s_imtThreads = 0;
+int            OverlayIoPool::s_imtUsers   = 0;
+
+OverlayIoPool* OverlayIoPool::acquire(int numThreads)
+{
+    if (!s_pool)
+    {
+        // Required before ROOT can be read from more than one thread, from ROOT 6 on this makes
+        // gFile and gDirectory thread local so that each thread can read its own files
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,0,0)
+        ROOT::EnableThreadSafety();
+#endif
+
+        s_pool = new OverlayIoPool(numThreads);
+    }
+
+    s_users++;
+
+    return s_pool;
+}
+
+bool OverlayIoPool::isAvailable()
+{
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,0,0)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void OverlayIoPool::release()
+{
+    if (s_users > 0 && --s_users == 0)
+    {
+        delete s_pool;
+        s_pool = 0;
+    }
+}
+
+int OverlayIoPool::acquireImplicitMT(int numThreads)
+{
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,8,0)
+    if (s_imtUsers++ == 0)
+    {
+        ROOT::EnableImplicitMT(numThreads);
+
+        s_imtThreads = numThreads;
+    }
+
+    return s_imtThreads;
+#else
+    return 0;
+#endif
+}
+
+void OverlayIoPool::releaseImplicitMT()
+{
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,8,0)
+    if (s_imtUsers > 0 && --s_imtUsers == 0)
+    {
+        ROOT::DisableImplicitMT();
+
+        s_imtThreads = 0;
+    }
+#endif
+}
+
+OverlayIoPool::OverlayIoPool(int numThreads) : m_stop(false)
+{
+    TThread::Initialize();
+
+    m_mutex         = new TMutex();
+    m_workAvailable = new TCondition(m_mutex);
+    m_jobDone       = new TCondition(m_mutex);
+
+    for(int idx = 0; idx < numThreads; idx++)
+    {
+        TThread* thread = new TThread("OverlayIoPool", workerLoop, this);
+
+        thread->Run();
+
+        m_threads.push_back(thread);
+    }
+}
+
+OverlayIoPool::~OverlayIoPool()
+{
+    // Tell the workers to finish up and wait for them
+    m_mutex->Lock();
+    m_stop = true;
+    m_workAvailable->Broadcast();
+    m_mutex->UnLock();
+
+    for(std::vector<TThread*>::iterator threadItr = m_threads.begin(); threadItr != m_threads.end(); threadItr++)
+    {
+        (*threadItr)->Join();
+        delete *threadItr;
+    }
+
+    delete m_jobDone;
+    delete m_workAvailable;
+    delete m_mutex;
+}
+
+void OverlayIoPool::submit(Job* job)
+{
+    m_mutex->Lock();
+    job->m_done = false;
+    m_queue.push_back(job);
+    m_workAvailable->Signal();
+    m_mutex->UnLock();
+}
+
+void OverlayIoPool::wait(Job* job)
+{
+    m_mutex->Lock();
+    while(!job->m_done) m_jobDone->Wait();
+    m_mutex->UnLock();
+}
+
+bool OverlayIoPool::isDone(Job* job)
+{
+    m_mutex->Lock();
+    bool done = job->m_done;
+    m_mutex->UnLock();
+
+    return done;
+}
+
+void* OverlayIoPool::workerLoop(void* arg)
+{
+    OverlayIoPool* pool = static_cast<OverlayIoPool*>(arg);
+
+    pool->m_mutex->Lock();
+
+    while(true)
+    {
+        while(!pool->m_stop && pool->m_queue.empty()) pool->m_workAvailable->Wait();
+
+        if (pool->m_queue.empty()) break;
+
+        Job* job = pool->m_queue.front();
+        pool->m_queue.pop_front();
+
+        // Run the job without holding the lock
+        pool->m_mutex->UnLock();
+        job->run();
+        pool->m_mutex->Lock();
+
+        job->m_done = true;
+        pool->m_jobDone->Broadcast();
+    }
+
+    pool->m_mutex->UnLock();
+
+    return 0;
+}
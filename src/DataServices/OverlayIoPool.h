@@ -0,0 +1,108 @@
+/** @file OverlayIoPool.h
+
+    @brief declaration of the OverlayIoPool class
+
+$Header$
+
+*/
+
+#ifndef OverlayIoPool_h
+#define OverlayIoPool_h
+
+#include <deque>
+#include <vector>
+
+class TThread;
+class TMutex;
+class TCondition;
+
+/** @class OverlayIoPool
+    @brief A small pool of threads used to read overlay input events concurrently
+
+    The pool is shared by all overlay data services in the job, each acquires it at initialize 
+    and releases it at finalize. Jobs are queued with submit() and the caller synchronizes with 
+    wait(), which returns once the job has been run.
+
+    ROOT is put in its thread safe mode when the pool is created. A job must still only use ROOT
+    objects (TChain, TFile) that nothing else uses while it runs: the overlay services read from
+    chains of their own, never through RootIoSvc, and do not touch a chain again until the read 
+    on it has been waited for. Everything else (RootIoSvc, the output file, the message service, 
+    the random engine) stays on the main thread.
+
+    Work that must not hold up the reads (such as staging files) gets a pool of its own, created
+    directly rather than through acquire().
+*/
+class OverlayIoPool
+{
+public:
+    /** @class Job
+        @brief Base class for work given to the pool
+    */
+    class Job
+    {
+    public:
+        Job() : m_done(true) {}
+        virtual ~Job() {}
+
+        /// Called on a worker thread
+        virtual void run() = 0;
+
+    private:
+        friend class OverlayIoPool;
+
+        bool m_done;
+    };
+
+    /// Can ROOT be read from a pool thread? Needs ROOT::EnableThreadSafety (ROOT 6 and later)
+    static bool isAvailable();
+
+    /// Get the shared pool, the first caller determines the number of threads
+    static OverlayIoPool* acquire(int numThreads);
+
+    /// Release the shared pool, the threads are stopped when the last user releases it
+    static void release();
+
+    /// Size ROOT's implicit multi-threading pool (which decompresses baskets in parallel for the 
+    /// chains that ask for it). The pool is process wide so it is set here, once: the first caller
+    /// sets the size and later callers get that size back. Returns zero if this ROOT (before 6.08) 
+    /// has no implicit multi-threading
+    static int acquireImplicitMT(int numThreads);
+
+    /// Implicit multi-threading is turned off when the last user releases it
+    static void releaseImplicitMT();
+
+    /// Queue a job to be run
+    void submit(Job* job);
+
+    /// Wait for a submitted job to complete
+    void wait(Job* job);
+
+    /// Has the job been run (or not yet submitted)?
+    bool isDone(Job* job);
+
+    /// A private pool, not shared with the readers
+    OverlayIoPool(int numThreads);
+    ~OverlayIoPool();
+
+private:
+
+    /// The function run by each worker thread
+    static void* workerLoop(void* arg);
+
+    std::vector<TThread*> m_threads;
+    std::deque<Job*>      m_queue;
+
+    TMutex*               m_mutex;
+    TCondition*           m_workAvailable;
+    TCondition*           m_jobDone;
+
+    bool                  m_stop;
+
+    static OverlayIoPool* s_pool;
+    static int            s_users;
+
+    static int            s_imtThreads;
+    static int            s_imtUsers;
+};
+
+#endif
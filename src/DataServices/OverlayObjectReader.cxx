@@ -0,0 +1,62 @@
+/**  @file OverlayObjectReader.cxx
+@brief implementation of class OverlayObjectReader
+
+$Header$
+*/
+
+#include "OverlayObjectReader.h"
+
+#include "facilities/Util.h"
+#include "overlayRootData/EventOverlay.h"
+
+#include "TChain.h"
+
+#include <stdexcept>
+
+OverlayObjectReader::OverlayObjectReader(const std::string&              treeName, 
+                                         const std::string&              branchName, 
+                                         const std::vector<std::string>& fileList,
+                                         EventOverlay**                  eventOverlay) :
+                                         m_chain(0), m_eventOverlay(eventOverlay)
+{
+    m_chain = new TChain(treeName.c_str());
+
+    for(std::vector<std::string>::const_iterator fileItr = fileList.begin(); fileItr != fileList.end(); fileItr++)
+    {
+        // The xml file lists may refer to environment variables, as RootIoSvc allowed
+        std::string fileName = *fileItr;
+
+        facilities::Util::expandEnvVar(&fileName);
+
+        if (m_chain->Add(fileName.c_str(), 0) == 0)
+        {
+            delete m_chain;
+            throw std::runtime_error("OverlayObjectReader: cannot open " + fileName);
+        }
+    }
+
+    if (m_chain->SetBranchAddress(branchName.c_str(), m_eventOverlay) < 0)
+    {
+        delete m_chain;
+        throw std::runtime_error("OverlayObjectReader: no " + branchName + " branch in " + treeName);
+    }
+}
+
+OverlayObjectReader::~OverlayObjectReader()
+{
+    m_chain->ResetBranchAddresses();
+
+    delete m_chain;
+}
+
+long long OverlayObjectReader::getEntries() const
+{
+    return m_chain->GetEntries();
+}
+
+EventOverlay* OverlayObjectReader::read(long long entry)
+{
+    if (m_chain->GetEntry(entry) <= 0) return 0;
+
+    return *m_eventOverlay;
+}
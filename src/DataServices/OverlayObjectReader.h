@@ -0,0 +1,48 @@
+/** @file OverlayObjectReader.h
+
+    @brief declaration of the OverlayObjectReader class
+
+$Header$
+
+*/
+
+#ifndef OverlayObjectReader_h
+#define OverlayObjectReader_h
+
+#include <string>
+#include <vector>
+
+class EventOverlay;
+class TChain;
+
+/** @class OverlayObjectReader
+    @brief Reads an object (the original format) overlay library through a TChain of its own
+
+    The overlay data service reads its inputs itself rather than through RootIoSvc so that a read
+    on an I/O pool thread never touches RootIoSvc, which the rest of the job uses from the main
+    thread. The EventOverlay is read into the object the caller points the branch at.
+*/
+class OverlayObjectReader
+{
+public:
+    /// Opens the library, throws std::runtime_error if this fails
+    OverlayObjectReader(const std::string&              treeName, 
+                        const std::string&              branchName, 
+                        const std::vector<std::string>& fileList,
+                        EventOverlay**                  eventOverlay);
+
+    ~OverlayObjectReader();
+
+    long long getEntries() const;
+
+    /// Read the given entry, returns zero on error
+    EventOverlay* read(long long entry);
+
+    TChain* getChain() const {return m_chain;}
+
+private:
+    TChain*        m_chain;
+    EventOverlay** m_eventOverlay;
+};
+
+#endif
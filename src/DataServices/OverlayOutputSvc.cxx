@@ -20,6 +20,7 @@
 #include "facilities/Util.h"
 
 #include "Overlay/IOverlayDataSvc.h"
+#include "Overlay/OverlayReadCuts.h"
 
 class OverlayOutputSvc : virtual public IOverlayDataSvc, virtual public IIncidentListener, public Service
 {    
@@ -38,9 +39,38 @@ public:
     /// Get pointer to a Root DigiEvent object
     virtual EventOverlay* getRootEventOverlay();
 
+    /// Columnar input is not supported by this service
+    virtual const OverlayColumns* getOverlayColumns() {return 0;}
+
+    /// Snapshot input is not supported by this service either
+    virtual const OverlaySnapshot* getOverlaySnapshot() {return 0;}
+
+    /// Nor is the event view
+    virtual const OverlayEventView* getOverlayEventView() {return 0;}
+
+    /// Read cuts are not applied by this service, declarations are ignored
+    virtual void declareReadCuts(const OverlayReadCuts&) {return;}
+
+    /// So everything is accepted
+    virtual const OverlayReadCuts& getReadCuts() const
+    {
+        static const OverlayReadCuts acceptAll;
+
+        return acceptAll;
+    }
+
+    /// Incremented at each BeginEvent, see OverlayTdsHandle
+    virtual unsigned long getEventGeneration() const {return m_eventGeneration;}
+
+    /// The overlay tree is always rebuilt, callers then set the root as usual
+    virtual StatusCode refillOverlayTree() {return StatusCode::FAILURE;}
+
     /// Select the next event
     virtual StatusCode selectNextEvent();
 
+    /// No background reading for this service
+    virtual StatusCode prefetchEvent() {return StatusCode::SUCCESS;}
+
     /// Register an output path with us
     virtual StatusCode registerOutputPath(const std::string& path);
 
@@ -81,6 +111,8 @@ private:
     int               m_compressionLevel;
     /// Flag to specify whether event is to be written at end of event
     bool              m_saveEvent;
+    /// Incremented at each BeginEvent
+    unsigned long     m_eventGeneration;
 };
 
 
@@ -92,7 +124,7 @@ DECLARE_SERVICE_FACTORY(OverlayOutputSvc);
 
 /// Standard Constructor
 OverlayOutputSvc::OverlayOutputSvc(const std::string& name,ISvcLocator* svc) : Service(name,svc),
-                               m_rootIoSvc(0), m_eventOverlay(0), m_saveEvent(false)
+                               m_rootIoSvc(0), m_eventOverlay(0), m_saveEvent(false), m_eventGeneration(0)
 {
     // Input pararmeters that may be set via the jobOptions file
     // Input ROOT file name  provided for backward compatibility, digiRootFileList is preferred
@@ -217,7 +249,12 @@ StatusCode OverlayOutputSvc::registerOutputPath(const std::string& path)
 // handle "incidents"
 void OverlayOutputSvc::handle(const Incident &inc)
 {
-    if      ( inc.type()=="BeginEvent") beginEvent();
+    if      ( inc.type()=="BeginEvent")
+    {
+        // Objects found in earlier events are gone (see OverlayTdsHandle)
+        m_eventGeneration++;
+        beginEvent();
+    }
     else if (inc.type()=="EndEvent")    endEvent();
 }
 
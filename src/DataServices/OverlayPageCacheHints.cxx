@@ -0,0 +1,128 @@
+/**  @file OverlayPageCacheHints.cxx
+@brief implementation of class OverlayPageCacheHints
+
+$Header$
+*/
+
+#include "OverlayPageCacheHints.h"
+
+#include "facilities/Util.h"
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // Apply the advice to (at most maxBytes of) a file, returns the number of bytes covered
+    double adviseFile(const std::string& fileName, int advice, double maxBytes)
+    {
+#if !defined(WIN32) && defined(POSIX_FADV_WILLNEED)
+        std::string localName = fileName;
+
+        facilities::Util::expandEnvVar(&localName);
+
+        int fd = open(localName.c_str(), O_RDONLY);
+
+        if (fd < 0) return 0.;
+
+        struct stat fileStat;
+        double      length = 0.;
+
+        if (fstat(fd, &fileStat) == 0)
+        {
+            length = fileStat.st_size < maxBytes ? fileStat.st_size : maxBytes;
+
+            // A length of zero means to the end of the file
+            if (posix_fadvise(fd, 0, length < fileStat.st_size ? (off_t)length : 0, advice) != 0) length = 0.;
+        }
+
+        close(fd);
+
+        return length;
+#else
+        return 0.;
+#endif
+    }
+}
+
+OverlayPageCacheHints::OverlayPageCacheHints(double willNeedBytes, double idleSeconds) :
+    m_willNeedBytes(willNeedBytes), m_idleSeconds(idleSeconds), m_numWillNeed(0), m_numDontNeed(0)
+{
+}
+
+void OverlayPageCacheHints::binChanged(const std::string&              inputType, 
+                                       const std::vector<std::string>& fileList,
+                                       const std::vector<std::string>& predictedFiles)
+{
+    time_t now = time(0);
+
+    if (inputType == m_currentType) return;
+
+    // The input we are leaving starts to become idle
+    if (!m_currentType.empty()) m_leftTime[m_currentType] = now;
+
+    m_currentType             = inputType;
+    m_inputFiles[inputType]   = fileList;
+    m_leftTime.erase(inputType);
+
+    // Read ahead the new current bin, and then the predicted bins with what remains of the budget
+    std::vector<std::string> needList = fileList;
+
+    needList.insert(needList.end(), predictedFiles.begin(), predictedFiles.end());
+
+    m_numWillNeed += willNeed(needList);
+
+    // Release the pages of inputs which have been idle too long
+    std::map<std::string, time_t>::iterator leftItr = m_leftTime.begin();
+
+    while(leftItr != m_leftTime.end())
+    {
+        if (difftime(now, leftItr->second) > m_idleSeconds)
+        {
+            m_numDontNeed += dontNeed(m_inputFiles[leftItr->first]);
+
+            // Only released once, it starts over if it becomes current again
+            m_leftTime.erase(leftItr++);
+        }
+        else leftItr++;
+    }
+}
+
+int OverlayPageCacheHints::willNeed(const std::vector<std::string>& fileList)
+{
+    int    numAdvised = 0;
+    double budget     = m_willNeedBytes;
+
+#if !defined(WIN32) && defined(POSIX_FADV_WILLNEED)
+    for(std::vector<std::string>::const_iterator fileItr = fileList.begin(); fileItr != fileList.end() && budget > 0.; fileItr++)
+    {
+        double length = adviseFile(*fileItr, POSIX_FADV_WILLNEED, budget);
+
+        if (length > 0.)
+        {
+            budget -= length;
+            numAdvised++;
+        }
+    }
+#endif
+
+    return numAdvised;
+}
+
+int OverlayPageCacheHints::dontNeed(const std::vector<std::string>& fileList)
+{
+    int numAdvised = 0;
+
+#if !defined(WIN32) && defined(POSIX_FADV_DONTNEED)
+    for(std::vector<std::string>::const_iterator fileItr = fileList.begin(); fileItr != fileList.end(); fileItr++)
+    {
+        // A very large limit covers the whole file
+        if (adviseFile(*fileItr, POSIX_FADV_DONTNEED, 1.e18) > 0.) numAdvised++;
+    }
+#endif
+
+    return numAdvised;
+}
@@ -0,0 +1,64 @@
+/** @file OverlayPageCacheHints.h
+
+    @brief declaration of the OverlayPageCacheHints class
+
+$Header$
+
+*/
+
+#ifndef OverlayPageCacheHints_h
+#define OverlayPageCacheHints_h
+
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+/** @class OverlayPageCacheHints
+    @brief Gives the operating system page cache hints for overlay input files as bins change
+
+    When a bin becomes current, its files and those of the predicted next bins are advised as
+    soon to be needed so the kernel starts reading them ahead. Inputs which have not been
+    current for longer than an idle threshold are advised as no longer needed so their pages
+    can be reclaimed. Hints are only given where posix_fadvise is available.
+*/
+class OverlayPageCacheHints
+{
+public:
+    /**@brief Constructor
+       @param willNeedBytes Maximum number of bytes to advise as needed per bin
+       @param idleSeconds   Time after which an input which is not current is released
+    */
+    OverlayPageCacheHints(double willNeedBytes, double idleSeconds);
+
+    ~OverlayPageCacheHints() {}
+
+    /// Called when the current input changes, with the files of the bins predicted to be next
+    void binChanged(const std::string&              inputType, 
+                    const std::vector<std::string>& fileList,
+                    const std::vector<std::string>& predictedFiles);
+
+    /// Statistics
+    int getNumWillNeed() const {return m_numWillNeed;}
+    int getNumDontNeed() const {return m_numDontNeed;}
+
+private:
+    /// Advise the kernel about the given files, returns the number of files advised
+    int willNeed(const std::vector<std::string>& fileList);
+    int dontNeed(const std::vector<std::string>& fileList);
+
+    double                                          m_willNeedBytes;
+    double                                          m_idleSeconds;
+
+    /// The current input
+    std::string                                     m_currentType;
+
+    /// Files of the inputs which have been current, and the time they were left
+    std::map<std::string, std::vector<std::string> > m_inputFiles;
+    std::map<std::string, time_t>                   m_leftTime;
+
+    int                                             m_numWillNeed;
+    int                                             m_numDontNeed;
+};
+
+#endif
@@ -0,0 +1,139 @@
+/**  @file OverlayReadCache.cxx
+@brief implementation of class OverlayReadCache
+
+$Header$
+*/
+
+#include "OverlayReadCache.h"
+
+#include "TROOT.h"
+#include "TChain.h"
+#include "TFile.h"
+#include "TTreeCache.h"
+#include "RVersion.h"
+
+OverlayReadCache::OverlayReadCache(TChain*                         chain, 
+                                   long long                       cacheSize, 
+                                   int                             learnEntries, 
+                                   const std::vector<std::string>& branches) :
+                                   m_chain(chain),
+                                   m_cacheSize(cacheSize),
+                                   m_learnEntries(learnEntries),
+                                   m_branches(branches),
+                                   m_parallelUnzip(false),
+                                   m_numReads(0),
+                                   m_readCalls(0),
+                                   m_bytesRead(0),
+                                   m_startTree(-1),
+                                   m_startCalls(0),
+                                   m_startBytes(0),
+                                   m_numResets(0),
+                                   m_efficiency(0.),
+                                   m_numSamples(0)
+{
+}
+
+void OverlayReadCache::activate()
+{
+    if (!m_chain) return;
+
+    if (m_parallelUnzip) setChainParallelUnzip(true);
+
+    if (m_cacheSize <= 0) return;
+
+    m_chain->SetCacheSize(m_cacheSize);
+
+    // Either cache the given branches or learn them
+    if (!m_branches.empty())
+    {
+        for(std::vector<std::string>::iterator branchItr = m_branches.begin(); branchItr != m_branches.end(); branchItr++)
+        {
+            m_chain->AddBranchToCache(branchItr->c_str(), true);
+        }
+
+        m_chain->StopCacheLearningPhase();
+    }
+    else if (m_learnEntries > 0) TTreeCache::SetLearnEntries(m_learnEntries);
+}
+
+void OverlayReadCache::deactivate()
+{
+    if (!m_chain) return;
+
+    if (m_parallelUnzip) setChainParallelUnzip(false);
+
+    if (m_cacheSize <= 0) return;
+
+    sampleEfficiency();
+
+    // Release the memory held by the cache
+    m_chain->SetCacheSize(0);
+}
+
+void OverlayReadCache::wrapped()
+{
+    if (!m_chain || m_cacheSize <= 0) return;
+
+    sampleEfficiency();
+
+    // The cached baskets are for the end of the input, start afresh
+    TFile*      file  = m_chain->GetCurrentFile();
+    TTreeCache* cache = file ? dynamic_cast<TTreeCache*>(file->GetCacheRead()) : 0;
+
+    if (cache) cache->ResetCache();
+
+    m_numResets++;
+}
+
+void OverlayReadCache::beginRead()
+{
+    TFile* file = m_chain->GetCurrentFile();
+
+    m_startTree  = m_chain->GetTreeNumber();
+    m_startCalls = file ? file->GetReadCalls() : 0;
+    m_startBytes = file ? file->GetBytesRead() : 0;
+}
+
+void OverlayReadCache::endRead()
+{
+    TFile* file = m_chain->GetCurrentFile();
+
+    m_numReads++;
+
+    if (!file) return;
+
+    // If the read moved the chain on to another file then everything read from that file was read
+    // for this event (the previous file is not read again once the chain leaves it)
+    if (m_chain->GetTreeNumber() != m_startTree)
+    {
+        m_startCalls = 0;
+        m_startBytes = 0;
+    }
+
+    m_readCalls += file->GetReadCalls() - m_startCalls;
+    m_bytesRead += file->GetBytesRead() - m_startBytes;
+}
+
+void OverlayReadCache::sampleEfficiency()
+{
+    TFile*      file  = m_chain->GetCurrentFile();
+    TTreeCache* cache = file ? dynamic_cast<TTreeCache*>(file->GetCacheRead()) : 0;
+
+    if (cache)
+    {
+        m_efficiency += cache->GetEfficiency();
+        m_numSamples++;
+    }
+}
+
+void OverlayReadCache::setChainParallelUnzip(bool parallelUnzip)
+{
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,8,0)
+    // With implicit multi-threading GetEntry decompresses the baskets of the different branches
+    // in parallel on ROOT's task pool. Only chains which ask for it use the pool
+    m_chain->SetImplicitMT(parallelUnzip);
+#else
+    // Baskets in the read cache are decompressed ahead of use by a helper thread
+    m_chain->SetParallelUnzip(parallelUnzip);
+#endif
+}
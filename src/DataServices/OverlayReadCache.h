@@ -0,0 +1,91 @@
+/** @file OverlayReadCache.h
+
+    @brief declaration of the OverlayReadCache class
+
+$Header$
+
+*/
+
+#ifndef OverlayReadCache_h
+#define OverlayReadCache_h
+
+#include <string>
+#include <vector>
+
+class TChain;
+
+/** @class OverlayReadCache
+    @brief Controls the ROOT read cache (TTreeCache) and parallel decompression of one overlay input 
+           and keeps read statistics
+
+    The TChain is the one the data service's reader for the input owns. Read statistics are taken
+    from the chain's own files, so they count only this input. Only the active input of a 
+    data service holds a cache, it is dropped when the bin is left and rebuilt (with a new learning
+    phase) when the bin is reentered. The cache is also reset when reading wraps around to the start 
+    of the input.
+*/
+class OverlayReadCache
+{
+public:
+    /**@brief Constructor
+       @param chain        The chain of the input
+       @param cacheSize    Size of the read cache in bytes
+       @param learnEntries Number of entries used to learn which branches to cache
+       @param branches     Branches to cache (if empty they are learned)
+    */
+    OverlayReadCache(TChain*                         chain, 
+                     long long                       cacheSize, 
+                     int                             learnEntries, 
+                     const std::vector<std::string>& branches);
+
+    ~OverlayReadCache() {}
+
+    /// Decompress baskets in parallel while the input is active, on ROOT's implicit multi-threading
+    /// pool (see OverlayIoPool::acquireImplicitMT) or, before ROOT 6.08, a read cache helper thread
+    void setParallelUnzip(bool parallelUnzip) {m_parallelUnzip = parallelUnzip;}
+
+    /// Set up the cache for the input when its bin becomes the current bin
+    void activate();
+
+    /// Drop the cache when the bin is left
+    void deactivate();
+
+    /// Reading has wrapped around to the start of the input
+    void wrapped();
+
+    /// Bracket each event read to accumulate read statistics (both on the thread doing the read)
+    void beginRead();
+    void endRead();
+
+    /// Statistics
+    long long getNumReads()   const {return m_numReads;}
+    long long getReadCalls()  const {return m_readCalls;}
+    long long getBytesRead()  const {return m_bytesRead;}
+    int       getNumResets()  const {return m_numResets;}
+    double    getEfficiency() const {return m_numSamples > 0 ? m_efficiency / m_numSamples : 0.;}
+
+private:
+    /// Record the current cache efficiency
+    void sampleEfficiency();
+
+    /// Turn parallel decompression on or off for the chain
+    void setChainParallelUnzip(bool parallelUnzip);
+
+    TChain*                  m_chain;
+    long long                m_cacheSize;
+    int                      m_learnEntries;
+    std::vector<std::string> m_branches;
+    bool                     m_parallelUnzip;
+
+    long long                m_numReads;
+    long long                m_readCalls;
+    long long                m_bytesRead;
+    int                      m_startTree;
+    long long                m_startCalls;
+    long long                m_startBytes;
+    int                      m_numResets;
+    double                   m_efficiency;
+    int                      m_numSamples;
+};
+
+#endif
@@ -0,0 +1,176 @@
+/**  @file OverlaySnapshotIo.cxx
+@brief implementation of classes OverlaySnapshotWriter and OverlaySnapshotReader
+
+$Header$
+*/
+
+#include "OverlaySnapshotIo.h"
+
+#include "RootIo/IRootIoSvc.h"
+#include "overlayRootData/EventOverlay.h"
+
+#include "OverlayEvent/TkrOverlay.h"
+#include "OverlayEvent/CalOverlay.h"
+#include "OverlayEvent/AcdOverlay.h"
+
+#include "TChain.h"
+
+#include <stdexcept>
+
+void OverlaySnapshotWriter::setupBranch(IRootIoSvc* rootIoSvc, const std::string& type, int bufSize)
+{
+    rootIoSvc->setupBranch(type, "OverlaySnapshot", "vector<char>", &m_bufferPtr, bufSize, 0);
+}
+
+void OverlaySnapshotWriter::clear()
+{
+    m_tkr.clear();
+    m_strips.clear();
+    m_cal.clear();
+    m_acd.clear();
+}
+
+bool OverlaySnapshotWriter::add(DataObject* object)
+{
+    if (!object) return false;
+
+    const CLID& clID = object->clID();
+
+    // Tracker
+    if (clID == ObjectVector<Event::TkrOverlay>::classID())
+    {
+        Event::TkrOverlayCol* tkrOverlayCol = static_cast<Event::TkrOverlayCol*>(object);
+
+        for(Event::TkrOverlayCol::const_iterator tkrItr = tkrOverlayCol->begin(); tkrItr != tkrOverlayCol->end(); tkrItr++)
+        {
+            const Event::TkrOverlay&  tkrOverlay = **tkrItr;
+            OverlaySnapshot::TkrRecord record = OverlaySnapshot::TkrRecord();
+
+            record.towerX      = tkrOverlay.getTower().ix();
+            record.towerY      = tkrOverlay.getTower().iy();
+            record.bilayer     = tkrOverlay.getBilayer();
+            record.view        = tkrOverlay.getView() == idents::GlastAxis::X ? 0 : 1;
+            record.tot[0]      = tkrOverlay.getToT(0);
+            record.tot[1]      = tkrOverlay.getToT(1);
+            record.lastC0Strip = tkrOverlay.getLastController0Strip();
+            record.numStrips   = tkrOverlay.getNumHits();
+
+            for(unsigned int iHit = 0; iHit < tkrOverlay.getNumHits(); iHit++)
+            {
+                m_strips.push_back(tkrOverlay.getHit(iHit));
+            }
+
+            m_tkr.push_back(record);
+        }
+    }
+    // Calorimeter
+    else if (clID == ObjectVector<Event::CalOverlay>::classID())
+    {
+        Event::CalOverlayCol* calOverlayCol = static_cast<Event::CalOverlayCol*>(object);
+
+        for(Event::CalOverlayCol::const_iterator calItr = calOverlayCol->begin(); calItr != calOverlayCol->end(); calItr++)
+        {
+            const Event::CalOverlay&   calOverlay = **calItr;
+            const idents::CalXtalId&   xtalId     = calOverlay.getCalXtalId();
+            const Point&               position   = calOverlay.getPosition();
+            OverlaySnapshot::CalRecord record = OverlaySnapshot::CalRecord();
+
+            record.position[0] = position.x();
+            record.position[1] = position.y();
+            record.position[2] = position.z();
+            record.energy      = calOverlay.getEnergy();
+            record.status      = calOverlay.getStatus();
+            record.tower       = xtalId.getTower();
+            record.layer       = xtalId.getLayer();
+            record.column      = xtalId.getColumn();
+
+            m_cal.push_back(record);
+        }
+    }
+    // ACD
+    else if (clID == ObjectVector<Event::AcdOverlay>::classID())
+    {
+        Event::AcdOverlayCol* acdOverlayCol = static_cast<Event::AcdOverlayCol*>(object);
+
+        for(Event::AcdOverlayCol::const_iterator acdItr = acdOverlayCol->begin(); acdItr != acdOverlayCol->end(); acdItr++)
+        {
+            const Event::AcdOverlay&   acdOverlay = **acdItr;
+            idents::VolumeIdentifier   volId      = acdOverlay.getVolumeId();
+            const idents::AcdId&       acdId      = acdOverlay.getAcdId();
+            const HepPoint3D&          position   = acdOverlay.getPosition();
+            OverlaySnapshot::AcdRecord record = OverlaySnapshot::AcdRecord();
+
+            record.volId       = volId.getValue();
+            record.volIdSize   = volId.size();
+            record.position[0] = position.x();
+            record.position[1] = position.y();
+            record.position[2] = position.z();
+            record.energy      = acdOverlay.getEnergyDep();
+            record.status      = acdOverlay.getStatus();
+            record.layer       = acdId.layer();
+            record.face        = acdId.face();
+            record.row         = acdId.row();
+            record.column      = acdId.column();
+
+            m_acd.push_back(record);
+        }
+    }
+    else return false;
+
+    return true;
+}
+
+void OverlaySnapshotWriter::fill()
+{
+    OverlaySnapshot::pack(m_buffer, m_tkr, m_strips, m_cal, m_acd);
+}
+
+OverlaySnapshotReader::OverlaySnapshotReader(const std::string&              treeName,
+                                             const std::string&              branchName,
+                                             const std::vector<std::string>& fileList) :
+                                             m_chain(0), m_eventOverlay(0), m_buffer(0)
+{
+    m_chain = new TChain(treeName.c_str());
+
+    for(std::vector<std::string>::const_iterator fileItr = fileList.begin(); fileItr != fileList.end(); fileItr++)
+    {
+        if (m_chain->Add(fileItr->c_str(), 0) == 0)
+        {
+            delete m_chain;
+            throw std::runtime_error("OverlaySnapshotReader: cannot open " + *fileItr);
+        }
+    }
+
+    if (!m_chain->GetBranch("OverlaySnapshot"))
+    {
+        delete m_chain;
+        throw std::runtime_error("OverlaySnapshotReader: no OverlaySnapshot branch in " + fileList[0]);
+    }
+
+    m_chain->SetBranchAddress(branchName.c_str(), &m_eventOverlay);
+    m_chain->SetBranchAddress("OverlaySnapshot", &m_buffer);
+}
+
+OverlaySnapshotReader::~OverlaySnapshotReader()
+{
+    m_chain->ResetBranchAddresses();
+
+    delete m_chain;
+    delete m_eventOverlay;
+    delete m_buffer;
+}
+
+long long OverlaySnapshotReader::getEntries() const
+{
+    return m_chain->GetEntries();
+}
+
+EventOverlay* OverlaySnapshotReader::read(long long entry)
+{
+    if (m_chain->GetEntry(entry) <= 0) return 0;
+
+    // The TDS objects are built straight from the records, nothing more to do here
+    if (!m_buffer || !m_snapshot.attach(*m_buffer)) return 0;
+
+    return m_eventOverlay;
+}
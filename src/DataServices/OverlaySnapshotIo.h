@@ -0,0 +1,86 @@
+/** @file OverlaySnapshotIo.h
+
+    @brief declaration of the OverlaySnapshotWriter and OverlaySnapshotReader classes
+
+$Header$
+
+*/
+
+#ifndef OverlaySnapshotIo_h
+#define OverlaySnapshotIo_h
+
+#include "Overlay/OverlaySnapshot.h"
+
+#include <string>
+#include <vector>
+
+class DataObject;
+class EventOverlay;
+class IRootIoSvc;
+class TChain;
+
+/** @class OverlaySnapshotWriter
+    @brief Writes the Tkr, Cal and Acd overlay collections of each event, straight from the TDS,
+           as a snapshot (see OverlaySnapshot)
+*/
+class OverlaySnapshotWriter
+{
+public:
+    OverlaySnapshotWriter() : m_bufferPtr(&m_buffer) {}
+    ~OverlaySnapshotWriter() {}
+
+    /// Add the snapshot branch to the given RootIoSvc output tree
+    void setupBranch(IRootIoSvc* rootIoSvc, const std::string& type, int bufSize);
+
+    /// Start a new event
+    void clear();
+
+    /// Add a TDS object to the snapshot, returns false if it is not one of the Tkr, Cal or Acd
+    /// collections (it must then be converted to the EventOverlay as usual)
+    bool add(DataObject* object);
+
+    /// Serialize the collections added, ready to fill the tree
+    void fill();
+
+private:
+    std::vector<OverlaySnapshot::TkrRecord> m_tkr;
+    std::vector<unsigned short>             m_strips;
+    std::vector<OverlaySnapshot::CalRecord> m_cal;
+    std::vector<OverlaySnapshot::AcdRecord> m_acd;
+
+    std::vector<char>                       m_buffer;
+
+    /// The branch needs the address of a pointer to the buffer
+    std::vector<char>*                      m_bufferPtr;
+};
+
+/** @class OverlaySnapshotReader
+    @brief Reads a snapshot overlay library, both the EventOverlay branch and the snapshot
+*/
+class OverlaySnapshotReader
+{
+public:
+    /// Opens the library, throws std::runtime_error if this fails
+    OverlaySnapshotReader(const std::string&              treeName,
+                          const std::string&              branchName,
+                          const std::vector<std::string>& fileList);
+
+    ~OverlaySnapshotReader();
+
+    long long getEntries() const;
+
+    /// Read the given entry, returns zero on error (including a snapshot which cannot be used)
+    EventOverlay* read(long long entry);
+
+    const OverlaySnapshot* getSnapshot() const {return &m_snapshot;}
+
+    TChain* getChain() const {return m_chain;}
+
+private:
+    TChain*            m_chain;
+    EventOverlay*      m_eventOverlay;
+    std::vector<char>* m_buffer;
+    OverlaySnapshot    m_snapshot;
+};
+
+#endif
@@ -0,0 +1,289 @@
+/**  @file OverlayStageCache.cxx
+@brief implementation of class OverlayStageCache
+
+$Header$
+*/
+
+// Staging relies on POSIX file system calls
+#ifndef WIN32
+
+#include "OverlayStageCache.h"
+
+#include "facilities/Util.h"
+
+#include "TMutex.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+namespace
+{
+    // FNV-1a hash, used to give the cached files unique names
+    std::string hashName(const std::string& key)
+    {
+        unsigned long long hash = 14695981039346656037ULL;
+
+        for(std::string::const_iterator keyItr = key.begin(); keyItr != key.end(); keyItr++)
+        {
+            hash ^= (unsigned char)*keyItr;
+            hash *= 1099511628211ULL;
+        }
+
+        char name[32];
+        sprintf(name, "%016llx", hash);
+
+        return name;
+    }
+
+    // Helper to hold an exclusive lock on a lock file for the life of the object
+    class LockFile
+    {
+    public:
+        LockFile(const std::string& name) 
+        {
+            m_fd = open(name.c_str(), O_RDWR | O_CREAT, 0666);
+
+            if (m_fd >= 0 && flock(m_fd, LOCK_EX) != 0)
+            {
+                close(m_fd);
+                m_fd = -1;
+            }
+        }
+        ~LockFile()     {if (m_fd >= 0) {flock(m_fd, LOCK_UN); close(m_fd);}}
+        bool isLocked() {return m_fd >= 0;}
+    private:
+        int m_fd;
+    };
+
+    // Cached file with its size and last use, for eviction
+    struct CacheEntry
+    {
+        std::string name;
+        double      size;
+        time_t      lastUse;
+        bool operator<(const CacheEntry& right) const {return lastUse < right.lastUse;}
+    };
+
+    bool endsWith(const std::string& name, const std::string& ending)
+    {
+        return name.size() >= ending.size() && name.compare(name.size() - ending.size(), ending.size(), ending) == 0;
+    }
+}
+
+OverlayStageCache::OverlayStageCache(const std::string& cacheDir, double maxBytes, bool useLinks) :
+    m_cacheDir(cacheDir), m_maxBytes(maxBytes), m_useLinks(useLinks), m_ioPool(0), m_stageJob(0),
+    m_numHits(0), m_numStaged(0), m_numFailed(0)
+{
+    mkdir(m_cacheDir.c_str(), 0777);
+
+    m_mutex    = new TMutex();
+    m_ioPool   = new OverlayIoPool(1);
+    m_stageJob = new StageJob(this);
+}
+
+OverlayStageCache::~OverlayStageCache()
+{
+    // Don't leave a staging job running
+    m_ioPool->wait(m_stageJob);
+
+    delete m_ioPool;
+
+    delete m_stageJob;
+    delete m_mutex;
+}
+
+std::vector<std::string> OverlayStageCache::localFiles(const std::vector<std::string>& fileList)
+{
+    std::vector<std::string> localList;
+
+    for(std::vector<std::string>::const_iterator fileItr = fileList.begin(); fileItr != fileList.end(); fileItr++)
+    {
+        std::string localName = stageFile(*fileItr);
+
+        localList.push_back(localName.empty() ? *fileItr : localName);
+    }
+
+    return localList;
+}
+
+void OverlayStageCache::stageInBackground(const std::vector<std::string>& fileList)
+{
+    if (fileList.empty() || !m_ioPool->isDone(m_stageJob)) return;
+
+    m_stageJob->m_fileList = fileList;
+
+    m_ioPool->submit(m_stageJob);
+}
+
+void OverlayStageCache::StageJob::run()
+{
+    for(std::vector<std::string>::iterator fileItr = m_fileList.begin(); fileItr != m_fileList.end(); fileItr++)
+    {
+        m_cache->stageFile(*fileItr);
+    }
+}
+
+std::string OverlayStageCache::stageFile(const std::string& fileName)
+{
+    std::string sourceName = fileName;
+
+    facilities::Util::expandEnvVar(&sourceName);
+
+    // Only local or network mounted files can be staged (not, eg, root:// urls)
+    struct stat sourceStat;
+
+    if (sourceName.find("://") != std::string::npos || stat(sourceName.c_str(), &sourceStat) != 0) 
+    {
+        m_mutex->Lock();
+        m_numFailed++;
+        m_mutex->UnLock();
+
+        return "";
+    }
+
+    // The cached name is made unique by a hash of the full source path
+    std::string baseName  = sourceName.substr(sourceName.rfind('/') + 1);
+    std::string localName = m_cacheDir + "/" + hashName(sourceName) + "_" + baseName;
+
+    m_mutex->Lock();
+    m_inUse.insert(localName);
+    m_mutex->UnLock();
+
+    struct stat localStat;
+
+    // Already staged? Then mark it as used
+    if (stat(localName.c_str(), &localStat) == 0 && localStat.st_size == sourceStat.st_size)
+    {
+        // Hard links share their times with the source, leave those alone
+        if (localStat.st_nlink == 1) utime(localName.c_str(), 0);
+
+        m_mutex->Lock();
+        m_numHits++;
+        m_mutex->UnLock();
+
+        return localName;
+    }
+
+    // Lock this file, if another job is staging it we will wait here until it is done
+    LockFile lock(localName + ".lock");
+
+    if (!lock.isLocked()) return "";
+
+    bool staged = stat(localName.c_str(), &localStat) == 0 && localStat.st_size == sourceStat.st_size;
+
+    if (!staged)
+    {
+        makeRoom(sourceStat.st_size);
+
+        // Stage to a temporary name and rename when complete
+        std::stringstream tmpName;
+
+        tmpName << localName << "." << getpid() << ".tmp";
+
+        staged = copyFile(sourceName, tmpName.str()) && rename(tmpName.str().c_str(), localName.c_str()) == 0;
+
+        if (!staged) remove(tmpName.str().c_str());
+    }
+    else if (localStat.st_nlink == 1) utime(localName.c_str(), 0);
+
+    m_mutex->Lock();
+    if (staged) m_numStaged++;
+    else        m_numFailed++;
+    m_mutex->UnLock();
+
+    return staged ? localName : "";
+}
+
+void OverlayStageCache::makeRoom(double numBytes)
+{
+    // Only one job at a time cleans up
+    LockFile lock(m_cacheDir + "/.evict.lock");
+
+    std::vector<CacheEntry> entries;
+    double                  totalBytes = 0.;
+
+    if (DIR* dir = opendir(m_cacheDir.c_str()))
+    {
+        while(struct dirent* dirEntry = readdir(dir))
+        {
+            std::string name = dirEntry->d_name;
+
+            if (name[0] == '.' || endsWith(name, ".lock") || endsWith(name, ".tmp")) continue;
+
+            CacheEntry  entry;
+            struct stat fileStat;
+
+            entry.name = m_cacheDir + "/" + name;
+
+            if (stat(entry.name.c_str(), &fileStat) != 0 || !S_ISREG(fileStat.st_mode)) continue;
+
+            entry.size    = fileStat.st_size;
+            entry.lastUse = fileStat.st_mtime;
+
+            totalBytes += entry.size;
+
+            entries.push_back(entry);
+        }
+
+        closedir(dir);
+    }
+
+    // Remove the least recently used files, but not those staged for this job
+    std::sort(entries.begin(), entries.end());
+
+    for(std::vector<CacheEntry>::iterator entryItr = entries.begin(); entryItr != entries.end(); entryItr++)
+    {
+        if (totalBytes + numBytes <= m_maxBytes) break;
+
+        m_mutex->Lock();
+        bool inUse = m_inUse.find(entryItr->name) != m_inUse.end();
+        m_mutex->UnLock();
+
+        if (inUse) continue;
+
+        if (remove(entryItr->name.c_str()) == 0) totalBytes -= entryItr->size;
+    }
+}
+
+bool OverlayStageCache::copyFile(const std::string& source, const std::string& destination)
+{
+    // A hard link is free if the cache is on the same file system
+    if (m_useLinks && link(source.c_str(), destination.c_str()) == 0) return true;
+
+    FILE* in = fopen(source.c_str(), "rb");
+
+    if (!in) return false;
+
+    FILE* out = fopen(destination.c_str(), "wb");
+
+    if (!out)
+    {
+        fclose(in);
+        return false;
+    }
+
+    std::vector<char> buffer(1 << 20);
+    size_t            numRead = 0;
+    bool              ok      = true;
+
+    while(ok && (numRead = fread(&buffer[0], 1, buffer.size(), in)) > 0)
+    {
+        ok = fwrite(&buffer[0], 1, numRead, out) == numRead;
+    }
+
+    ok = !ferror(in) && ok;
+
+    fclose(in);
+
+    return fclose(out) == 0 && ok;
+}
+
+#endif
@@ -0,0 +1,92 @@
+/** @file OverlayStageCache.h
+
+    @brief declaration of the OverlayStageCache class
+
+$Header$
+
+*/
+
+#ifndef OverlayStageCache_h
+#define OverlayStageCache_h
+
+#include "OverlayIoPool.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+class TMutex;
+
+/** @class OverlayStageCache
+    @brief Stages overlay library files into a local cache directory so they can be read from local disk
+
+    Files are hard linked into the cache if possible, otherwise copied. A per-file lock serializes
+    staging of the same file by different jobs (or threads) on a node so that they all share one
+    copy, and files only appear in the cache under their final name once complete. The total size 
+    of the cache is kept below a limit by removing the least recently used files, files staged for 
+    this job are never removed by it (files removed while open by another job remain readable).
+*/
+class OverlayStageCache
+{
+public:
+    /**@brief Constructor
+       @param cacheDir  Local directory to hold the cache
+       @param maxBytes  Maximum total size of the files in the cache
+       @param useLinks  Try to hard link files before copying them
+    */
+    OverlayStageCache(const std::string& cacheDir, double maxBytes, bool useLinks);
+
+    ~OverlayStageCache();
+
+    /// Stage the files now, returns the list of names to read (original names for files which could not be staged)
+    std::vector<std::string> localFiles(const std::vector<std::string>& fileList);
+
+    /// Stage the files in the background, ignored if a previous background request is still in progress
+    void stageInBackground(const std::vector<std::string>& fileList);
+
+    /// Statistics
+    int getNumHits()   const {return m_numHits;}
+    int getNumStaged() const {return m_numStaged;}
+    int getNumFailed() const {return m_numFailed;}
+
+private:
+    /// Job to stage files on the I/O pool
+    class StageJob : public OverlayIoPool::Job
+    {
+    public:
+        StageJob(OverlayStageCache* cache) : m_cache(cache) {}
+        virtual void run();
+
+        std::vector<std::string> m_fileList;
+
+    private:
+        OverlayStageCache* m_cache;
+    };
+
+    /// Stage a single file, returns the local name or an empty string on failure
+    std::string stageFile(const std::string& fileName);
+
+    /// Remove least recently used files until there is room for the given number of bytes
+    void makeRoom(double numBytes);
+
+    /// Copy or link a file to a (temporary) destination
+    bool copyFile(const std::string& source, const std::string& destination);
+
+    std::string           m_cacheDir;
+    double                m_maxBytes;
+    bool                  m_useLinks;
+
+    /// Local files handed out to this job, these are not evicted
+    std::set<std::string> m_inUse;
+    TMutex*               m_mutex;
+
+    /// A thread of our own so that reads never queue behind staging copies
+    OverlayIoPool*        m_ioPool;
+    StageJob*             m_stageJob;
+
+    int                   m_numHits;
+    int                   m_numStaged;
+    int                   m_numFailed;
+};
+
+#endif
@@ -0,0 +1,98 @@
+/** @file OverlayTdsHandle.h
+
+    @brief declaration and implementation of the OverlayTdsHandle class template
+
+$Header$
+
+*/
+
+#ifndef OverlayTdsHandle_h
+#define OverlayTdsHandle_h
+
+#include "Overlay/IOverlayDataSvc.h"
+
+#include "GaudiKernel/DataSvc.h"
+#include "GaudiKernel/SmartDataPtr.h"
+
+#include <string>
+
+/** @class OverlayTdsHandle
+    @brief Access to one object in the overlay section of the TDS, resolved once at initialize
+
+    At initialize the handle looks up the data service and builds the full path (the service root
+    name plus the path below it), so the per event accesses no longer locate services or build
+    strings. The object found is kept until the data service starts a new event (its event
+    generation changes), so further accesses in the same event are a pointer check.
+
+    The registry of the overlay section is rebuilt every event (the root is set again by DoMergeAlg
+    or EventToOverlayTool, which run first), so nothing below the data service can be kept across
+    events. Objects which are not found are not remembered, they may still be registered later in
+    the event.
+*/
+template <class T> class OverlayTdsHandle
+{
+public:
+    OverlayTdsHandle() : m_dataSvc(0), m_overlaySvc(0), m_object(0), m_generation(0) {}
+
+    ~OverlayTdsHandle() {}
+
+    /**@brief Resolve the handle
+       @param dataSvc The overlay data service (an OverlayDataSvc)
+       @param path    Path below the root of the service, empty for the root (header) itself
+    */
+    StatusCode initialize(IService* dataSvc, const std::string& path)
+    {
+        m_dataSvc    = dynamic_cast<DataSvc*>(dataSvc);
+        m_overlaySvc = dynamic_cast<IOverlayDataSvc*>(dataSvc);
+        m_object     = 0;
+
+        if (!m_dataSvc || !m_overlaySvc) return StatusCode::FAILURE;
+
+        m_path = m_dataSvc->rootName() + path;
+
+        return StatusCode::SUCCESS;
+    }
+
+    /// Return the object for the current event, zero if it is not (yet) available
+    T* get()
+    {
+        unsigned long generation = m_overlaySvc->getEventGeneration();
+
+        if (m_object && m_generation == generation) return m_object;
+
+        SmartDataPtr<T> object(m_dataSvc, m_path);
+
+        m_object     = object;
+        m_generation = generation;
+
+        return m_object;
+    }
+
+    /// Register a new object for the current event at the handle's path
+    StatusCode put(T* object)
+    {
+        StatusCode status = m_dataSvc->registerObject(m_path, object);
+
+        if (status.isSuccess())
+        {
+            m_object     = object;
+            m_generation = m_overlaySvc->getEventGeneration();
+        }
+
+        return status;
+    }
+
+    /// Full path of the object and the service it lives in
+    const std::string& path()    const {return m_path;}
+    DataSvc*           dataSvc() const {return m_dataSvc;}
+
+private:
+    DataSvc*         m_dataSvc;
+    IOverlayDataSvc* m_overlaySvc;
+    std::string      m_path;
+
+    T*               m_object;
+    unsigned long    m_generation;
+};
+
+#endif
@@ -0,0 +1,133 @@
+/**  @file OverlayBinSampler.cxx
+@brief implementation of class OverlayBinSampler
+
+$Header$
+*/
+
+#include "OverlayBinSampler.h"
+
+#include "CLHEP/Random/RandFlat.h"
+#include "CLHEP/Random/JamesRandom.h"
+
+#include <algorithm>
+
+OverlayBinSampler::OverlayBinSampler(long long numEntries, Mode mode) :
+    m_numEntries(numEntries), m_mode(mode), m_cursor(0), m_engine(0), m_numDraws(0), m_numRejected(0), m_numWraps(0)
+{
+    initialize();
+}
+
+OverlayBinSampler::OverlayBinSampler(const std::vector<long long>& entries, Mode mode) :
+    m_entries(entries), m_numEntries(entries.size()), m_mode(mode), m_cursor(0), m_engine(0), m_numDraws(0), m_numRejected(0), m_numWraps(0)
+{
+    initialize();
+}
+
+OverlayBinSampler::~OverlayBinSampler()
+{
+    delete m_engine;
+}
+
+void OverlayBinSampler::initialize()
+{
+    if (m_numEntries < 1) m_numEntries = 1;
+
+    m_useCount.assign(m_numEntries, 0);
+
+    // Sequential mode starts at a random position within the allowed number of events
+    if (m_mode == Sequential)
+    {
+        m_cursor = (long long)(CLHEP::RandFlat::shoot() * (m_numEntries - 1));
+    }
+    // Permutation mode starts from the identity, Fisher-Yates shuffles as we go. The seed of its
+    // engine is drawn from the shared one (HepJamesRandom takes seeds up to 900000000)
+    else
+    {
+        long seed = (long)(CLHEP::RandFlat::shoot() * 900000000);
+
+        m_engine = new CLHEP::HepJamesRandom(seed);
+
+        m_permutation.resize(m_numEntries);
+
+        for(long long idx = 0; idx < m_numEntries; idx++) m_permutation[idx] = idx;
+    }
+}
+
+long long OverlayBinSampler::randomIndex(long long range)
+{
+    long long index = (long long)(CLHEP::RandFlat::shoot(m_engine) * range);
+
+    return index < range ? index : range - 1;
+}
+
+bool OverlayBinSampler::modeFromName(const std::string& name, Mode& mode)
+{
+    if      (name == "Sequential")  mode = Sequential;
+    else if (name == "Permutation") mode = Permutation;
+    else return false;
+
+    return true;
+}
+
+long long OverlayBinSampler::next()
+{
+    long long index = 0;
+
+    if (m_mode == Sequential)
+    {
+        index = m_cursor++;
+
+        // Poor man's mod
+        if (m_cursor >= m_numEntries)
+        {
+            m_cursor = 0;
+            m_numWraps++;
+        }
+    }
+    else
+    {
+        // Swap a random remaining entry into the current position. Once exhausted simply 
+        // start over, shuffling the previous permutation is as good as shuffling the identity
+        if (m_cursor >= m_numEntries)
+        {
+            m_cursor = 0;
+            m_numWraps++;
+        }
+
+        long long swapIdx = m_cursor + randomIndex(m_numEntries - m_cursor);
+
+        std::swap(m_permutation[m_cursor], m_permutation[swapIdx]);
+
+        index = m_permutation[m_cursor++];
+    }
+
+    if (m_useCount[index] < 0xffff) m_useCount[index]++;
+
+    m_numDraws++;
+
+    return m_entries.empty() ? index : m_entries[index];
+}
+
+long long OverlayBinSampler::getNumUsed() const
+{
+    long long numUsed = 0;
+
+    for(std::vector<unsigned short>::const_iterator useItr = m_useCount.begin(); useItr != m_useCount.end(); useItr++)
+    {
+        if (*useItr) numUsed++;
+    }
+
+    return numUsed;
+}
+
+unsigned int OverlayBinSampler::getMaxUses() const
+{
+    unsigned int maxUses = 0;
+
+    for(std::vector<unsigned short>::const_iterator useItr = m_useCount.begin(); useItr != m_useCount.end(); useItr++)
+    {
+        if (*useItr > maxUses) maxUses = *useItr;
+    }
+
+    return maxUses;
+}
@@ -0,0 +1,98 @@
+/** @file OverlayBinSampler.h
+
+    @brief declaration of the OverlayBinSampler class
+
+$Header$
+
+*/
+
+#ifndef OverlayBinSampler_h
+#define OverlayBinSampler_h
+
+#include <string>
+#include <vector>
+
+namespace CLHEP {class HepRandomEngine;}
+
+/** @class OverlayBinSampler
+    @brief Selects the sequence of entries to read from the files of one input bin and keeps
+           track of how often each entry has been used.
+
+    Two modes are supported:
+    - Sequential:  read consecutive entries starting from a random position, wrapping at the end
+                   (this is the original behaviour of OverlayDataSvc)
+    - Permutation: draw entries in random order without replacement, once all entries have been 
+                   drawn a new permutation is started
+
+    In both modes a "pass" is completed each time the number of draws reaches the number of entries,
+    entries are only reused once a pass has been completed.
+
+    The shared random engine is only used when the sampler is constructed (on the main thread). 
+    Permutation mode then draws from an engine of its own, seeded from the shared one, so that
+    next() can be called from an I/O pool thread and a job remains reproducible.
+*/
+class OverlayBinSampler
+{
+public:
+    enum Mode {Sequential, Permutation};
+
+    OverlayBinSampler(long long numEntries, Mode mode);
+
+    /// Sample only from the given list of (eligible) entries
+    OverlayBinSampler(const std::vector<long long>& entries, Mode mode);
+
+    ~OverlayBinSampler();
+
+    /// Convert a mode name to a Mode, returns false if not recognized
+    static bool modeFromName(const std::string& name, Mode& mode);
+
+    /// Return the next entry to read
+    long long next();
+
+    /// Signal that the last entry returned was rejected (eg by the trigger reject mask)
+    void reject() {m_numRejected++;}
+
+    /// Statistics
+    long long    getNumEntries()  const {return m_numEntries;}  ///< number of entries sampled from
+    long long    getNumDraws()    const {return m_numDraws;}
+    long long    getNumRejected() const {return m_numRejected;}
+    long long    getNumPasses()   const {return m_numDraws / (m_numEntries > 0 ? m_numEntries : 1);}
+    long long    getNumWraps()    const {return m_numWraps;}   ///< times the sequence restarted from its beginning
+    long long    getNumUsed()     const;  ///< number of distinct entries drawn at least once
+    unsigned int getMaxUses()     const;  ///< largest number of times any one entry was drawn
+
+private:
+    /// Not copyable, the engine is owned
+    OverlayBinSampler(const OverlayBinSampler&);
+    OverlayBinSampler& operator=(const OverlayBinSampler&);
+
+    void initialize();
+
+    /// Return a random integer in the range [0, range) from our engine
+    long long randomIndex(long long range);
+
+    /// If not empty, the entries to sample from (otherwise all entries in the bin)
+    std::vector<long long>      m_entries;
+
+    /// Number of entries in the bin
+    long long                   m_numEntries;
+    Mode                        m_mode;
+
+    /// Position in the sequence (or current permutation)
+    long long                   m_cursor;
+
+    /// Permutation mode: the current permutation, built incrementally by Fisher-Yates
+    std::vector<unsigned int>   m_permutation;
+
+    /// Permutation mode: the engine the permutation is drawn from
+    CLHEP::HepRandomEngine*     m_engine;
+
+    /// Number of times each entry has been drawn (saturating)
+    std::vector<unsigned short> m_useCount;
+
+    long long                   m_numDraws;
+    long long                   m_numRejected;
+    long long                   m_numWraps;
+};
+
+#endif
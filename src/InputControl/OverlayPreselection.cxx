@@ -0,0 +1,214 @@
+/**  @file OverlayPreselection.cxx
+@brief implementation of class OverlayPreselection
+
+$Header$
+*/
+
+#include "OverlayPreselection.h"
+
+#include "overlayRootData/EventOverlay.h"
+
+#include "TChain.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // FNV-1a hash, used to name the sidecar files
+    std::string hashName(const std::string& key)
+    {
+        unsigned long long hash = 14695981039346656037ULL;
+
+        for(std::string::const_iterator keyItr = key.begin(); keyItr != key.end(); keyItr++)
+        {
+            hash ^= (unsigned char)*keyItr;
+            hash *= 1099511628211ULL;
+        }
+
+        char name[32];
+        sprintf(name, "%016llx", hash);
+
+        return name;
+    }
+}
+
+OverlayPreselection::OverlayPreselection(const std::vector<int>& dataQual,
+                                         const std::vector<int>& latModes,
+                                         double                  minLivetimeFrac,
+                                         const std::string&      branchPattern,
+                                         const std::string&      cacheDir) :
+                                         m_dataQual(dataQual),
+                                         m_latModes(latModes),
+                                         m_minLivetimeFrac(minLivetimeFrac),
+                                         m_branchPattern(branchPattern),
+                                         m_cacheDir(cacheDir)
+{
+}
+
+bool OverlayPreselection::isActive() const
+{
+    return !m_dataQual.empty() || !m_latModes.empty() || m_minLivetimeFrac > 0.;
+}
+
+bool OverlayPreselection::accept(const PtOverlay& ptOverlay) const
+{
+    if (!m_dataQual.empty() && std::find(m_dataQual.begin(), m_dataQual.end(), ptOverlay.getDataQual()) == m_dataQual.end())
+        return false;
+
+    if (!m_latModes.empty() && std::find(m_latModes.begin(), m_latModes.end(), ptOverlay.getLATMode()) == m_latModes.end())
+        return false;
+
+    if (ptOverlay.getLivetimeFrac() < m_minLivetimeFrac) return false;
+
+    return true;
+}
+
+std::string OverlayPreselection::describe() const
+{
+    std::stringstream desc;
+
+    desc << "DataQual in {";
+    for(std::vector<int>::const_iterator qualItr = m_dataQual.begin(); qualItr != m_dataQual.end(); qualItr++)
+        desc << (qualItr != m_dataQual.begin() ? "," : "") << *qualItr;
+    desc << "}, LATMode in {";
+    for(std::vector<int>::const_iterator modeItr = m_latModes.begin(); modeItr != m_latModes.end(); modeItr++)
+        desc << (modeItr != m_latModes.begin() ? "," : "") << *modeItr;
+    desc << "}, LivetimeFrac >= " << m_minLivetimeFrac;
+
+    return desc.str();
+}
+
+std::vector<long long> OverlayPreselection::eligibleEntries(const std::string&              treeName,
+                                                            const std::string&              branchName,
+                                                            const std::vector<std::string>& fileList) const
+{
+    std::vector<long long> entries;
+
+    // The sidecar is identified by the selection and the library it was made from
+    std::string key = describe() + "|" + treeName + "|" + branchName;
+
+    for(std::vector<std::string>::const_iterator fileItr = fileList.begin(); fileItr != fileList.end(); fileItr++)
+    {
+        key += "|" + *fileItr;
+    }
+
+    std::string sidecarName = m_cacheDir.empty() ? "" : m_cacheDir + "/" + hashName(key) + ".sel";
+
+    if (!sidecarName.empty() && readSidecar(sidecarName, key, entries)) return entries;
+
+    entries = scanLibrary(treeName, branchName, fileList);
+
+    if (!sidecarName.empty()) writeSidecar(sidecarName, key, entries);
+
+    return entries;
+}
+
+std::vector<long long> OverlayPreselection::scanLibrary(const std::string&              treeName,
+                                                        const std::string&              branchName,
+                                                        const std::vector<std::string>& fileList) const
+{
+    std::vector<long long> entries;
+
+    TChain chain(treeName.c_str());
+
+    for(std::vector<std::string>::const_iterator fileItr = fileList.begin(); fileItr != fileList.end(); fileItr++)
+    {
+        if (chain.Add(fileItr->c_str(), 0) == 0)
+            throw std::runtime_error("OverlayPreselection: cannot open " + *fileItr);
+    }
+
+    EventOverlay* eventOverlay = 0;
+
+    chain.SetBranchAddress(branchName.c_str(), &eventOverlay);
+
+    // Only read the PtOverlay information, if the pattern matches nothing then read everything
+    unsigned int found = 0;
+
+    chain.SetBranchStatus("*", 0);
+    chain.SetBranchStatus(m_branchPattern.c_str(), 1, &found);
+
+    if (!found) chain.SetBranchStatus("*", 1);
+
+    long long numEntries = chain.GetEntries();
+
+    for(long long entry = 0; entry < numEntries; entry++)
+    {
+        if (chain.GetEntry(entry) <= 0 || !eventOverlay)
+            throw std::runtime_error("OverlayPreselection: error reading " + treeName);
+
+        if (accept(eventOverlay->getPtOverlay())) entries.push_back(entry);
+    }
+
+    chain.ResetBranchAddresses();
+
+    delete eventOverlay;
+
+    return entries;
+}
+
+bool OverlayPreselection::readSidecar(const std::string& fileName, const std::string& key, std::vector<long long>& entries) const
+{
+    FILE* file = fopen(fileName.c_str(), "rb");
+
+    if (!file) return false;
+
+    // The file starts with the key, to protect against hash collisions, then the entry count
+    unsigned long long keyLength  = 0;
+    unsigned long long numEntries = 0;
+    std::string        fileKey;
+    bool               ok         = fread(&keyLength, sizeof(keyLength), 1, file) == 1 && keyLength == key.size();
+
+    if (ok)
+    {
+        fileKey.resize(keyLength);
+        ok = fread(&fileKey[0], 1, keyLength, file) == keyLength && fileKey == key 
+          && fread(&numEntries, sizeof(numEntries), 1, file) == 1;
+    }
+
+    if (ok)
+    {
+        entries.resize(numEntries);
+        ok = numEntries == 0 || fread(&entries[0], sizeof(long long), numEntries, file) == numEntries;
+    }
+
+    fclose(file);
+
+    if (!ok) entries.clear();
+
+    return ok;
+}
+
+void OverlayPreselection::writeSidecar(const std::string& fileName, const std::string& key, const std::vector<long long>& entries) const
+{
+    // Write to a temporary file and rename so concurrent jobs never see a partial file
+    std::stringstream tmpStream;
+
+    tmpStream << fileName << "." << getpid() << ".tmp";
+
+    std::string tmpName = tmpStream.str();
+    FILE*       file    = fopen(tmpName.c_str(), "wb");
+
+    if (!file) return;
+
+    unsigned long long keyLength  = key.size();
+    unsigned long long numEntries = entries.size();
+
+    bool ok = fwrite(&keyLength, sizeof(keyLength), 1, file) == 1
+           && fwrite(key.data(), 1, keyLength, file) == keyLength
+           && fwrite(&numEntries, sizeof(numEntries), 1, file) == 1
+           && (numEntries == 0 || fwrite(&entries[0], sizeof(long long), numEntries, file) == numEntries);
+
+    ok = fclose(file) == 0 && ok;
+
+    if (!ok || rename(tmpName.c_str(), fileName.c_str()) != 0) remove(tmpName.c_str());
+}
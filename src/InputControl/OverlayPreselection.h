@@ -0,0 +1,77 @@
+/** @file OverlayPreselection.h
+
+    @brief declaration of the OverlayPreselection class
+
+$Header$
+
+*/
+
+#ifndef OverlayPreselection_h
+#define OverlayPreselection_h
+
+#include <string>
+#include <vector>
+
+class PtOverlay;
+
+/** @class OverlayPreselection
+    @brief Selects the entries of an overlay library which are eligible for use, based on the 
+           PtOverlay data quality, LAT mode and livetime fraction
+
+    The selection is made once for each library when it is opened. Only the PtOverlay branches 
+    are read to do this and, if a cache directory is given, the resulting list of eligible entries
+    is stored in a sidecar file so subsequent jobs using the same library and selection need not 
+    scan it again.
+*/
+class OverlayPreselection
+{
+public:
+    /**@brief Constructor
+       @param dataQual        Accepted values of the data quality flag (empty accepts all)
+       @param latModes        Accepted values of the LAT mode (empty accepts all)
+       @param minLivetimeFrac Minimum livetime fraction 
+       @param branchPattern   Pattern matching the PtOverlay branches of the library tree
+       @param cacheDir        Directory for the sidecar files, empty to not use them
+    */
+    OverlayPreselection(const std::vector<int>& dataQual,
+                        const std::vector<int>& latModes,
+                        double                  minLivetimeFrac,
+                        const std::string&      branchPattern,
+                        const std::string&      cacheDir);
+
+    ~OverlayPreselection() {}
+
+    /// Does this selection actually reject anything?
+    bool isActive() const;
+
+    /// Apply the selection to one event
+    bool accept(const PtOverlay& ptOverlay) const;
+
+    /// A string describing the selection
+    std::string describe() const;
+
+    /**@brief Return the eligible entries in the given library, 
+              throws std::runtime_error if the library cannot be read
+    */
+    std::vector<long long> eligibleEntries(const std::string&              treeName,
+                                           const std::string&              branchName,
+                                           const std::vector<std::string>& fileList) const;
+
+private:
+    /// Scan the library, reading only the PtOverlay information
+    std::vector<long long> scanLibrary(const std::string&              treeName,
+                                       const std::string&              branchName,
+                                       const std::vector<std::string>& fileList) const;
+
+    /// Sidecar file handling
+    bool readSidecar(const std::string& fileName, const std::string& key, std::vector<long long>& entries) const;
+    void writeSidecar(const std::string& fileName, const std::string& key, const std::vector<long long>& entries) const;
+
+    std::vector<int> m_dataQual;
+    std::vector<int> m_latModes;
+    double           m_minLivetimeFrac;
+    std::string      m_branchPattern;
+    std::string      m_cacheDir;
+};
+
+#endif
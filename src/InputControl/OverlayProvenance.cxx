@@ -0,0 +1,206 @@
+/**  @file OverlayProvenance.cxx
+@brief implementation of classes OverlayProvenanceWriter and OverlayProvenanceReader
+
+$Header$
+*/
+
+#include "OverlayProvenance.h"
+
+#include <stdexcept>
+
+namespace
+{
+    // Identifies the file type, followed by a format version number
+    const char         provMagic[4]  = {'O', 'V', 'L', 'P'};
+    const unsigned int provVersion   = 2;
+
+    // Record types
+    const int          libraryRecord = 'L';
+    const int          eventRecord   = 'E';
+}
+
+OverlayProvenanceWriter::OverlayProvenanceWriter(const std::string& fileName) :
+    m_file(0), m_numLibraries(0)
+{
+    m_file = fopen(fileName.c_str(), "wb");
+
+    if (m_file)
+    {
+        fwrite(provMagic, 1, sizeof(provMagic), m_file);
+        writeUInt(provVersion);
+    }
+}
+
+OverlayProvenanceWriter::~OverlayProvenanceWriter()
+{
+    close();
+}
+
+int OverlayProvenanceWriter::addLibrary(const std::string&              treeName,
+                                        const std::string&              branchName,
+                                        const std::string&              format,
+                                        const std::vector<std::string>& fileList)
+{
+    int library = m_numLibraries++;
+
+    if (!m_file) return library;
+
+    fputc(libraryRecord, m_file);
+    writeUInt(library);
+    writeString(treeName);
+    writeString(branchName);
+    writeString(format);
+    writeUInt(fileList.size());
+
+    for(std::vector<std::string>::const_iterator fileItr = fileList.begin(); fileItr != fileList.end(); fileItr++)
+    {
+        writeString(*fileItr);
+    }
+
+    return library;
+}
+
+void OverlayProvenanceWriter::record(unsigned int run, unsigned int event, int library, long long entry)
+{
+    if (!m_file) return;
+
+    fputc(eventRecord, m_file);
+    writeUInt(run);
+    writeUInt(event);
+    writeUInt(library);
+    writeLong(entry);
+}
+
+void OverlayProvenanceWriter::close()
+{
+    if (m_file) fclose(m_file);
+
+    m_file = 0;
+}
+
+void OverlayProvenanceWriter::writeUInt(unsigned int value)
+{
+    unsigned char bytes[4];
+
+    for(int idx = 0; idx < 4; idx++) bytes[idx] = (value >> (8 * idx)) & 0xff;
+
+    fwrite(bytes, 1, sizeof(bytes), m_file);
+}
+
+void OverlayProvenanceWriter::writeLong(long long value)
+{
+    unsigned long long uValue = value;
+    unsigned char      bytes[8];
+
+    for(int idx = 0; idx < 8; idx++) bytes[idx] = (uValue >> (8 * idx)) & 0xff;
+
+    fwrite(bytes, 1, sizeof(bytes), m_file);
+}
+
+void OverlayProvenanceWriter::writeString(const std::string& value)
+{
+    writeUInt(value.size());
+    fwrite(value.data(), 1, value.size(), m_file);
+}
+
+OverlayProvenanceReader::OverlayProvenanceReader(const std::string& fileName)
+{
+    FILE* file = fopen(fileName.c_str(), "rb");
+
+    if (!file) throw std::runtime_error("OverlayProvenanceReader: cannot open " + fileName);
+
+    char         magic[4];
+    unsigned int version = 0;
+
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) || !readUInt(file, version) ||
+        std::string(magic, sizeof(magic)) != std::string(provMagic, sizeof(provMagic)) || version < 1 || version > provVersion)
+    {
+        fclose(file);
+        throw std::runtime_error("OverlayProvenanceReader: " + fileName + " is not an overlay provenance file");
+    }
+
+    bool ok         = true;
+    int  recordType = 0;
+
+    while(ok && (recordType = fgetc(file)) != EOF)
+    {
+        if (recordType == libraryRecord)
+        {
+            unsigned int library  = 0;
+            unsigned int numFiles = 0;
+            Library      lib;
+
+            ok = readUInt(file, library)        && library == m_libraries.size()
+              && readString(file, lib.treeName) && readString(file, lib.branchName)
+              && (version < 2 || readString(file, lib.format))
+              && readUInt(file, numFiles);
+
+            // Version 1 files predate columnar libraries
+            if (lib.format.empty()) lib.format = "object";
+
+            for(unsigned int idx = 0; ok && idx < numFiles; idx++)
+            {
+                std::string fileName;
+
+                if ((ok = readString(file, fileName))) lib.fileList.push_back(fileName);
+            }
+
+            if (ok) m_libraries.push_back(lib);
+        }
+        else if (recordType == eventRecord)
+        {
+            Record rec;
+
+            ok = readUInt(file, rec.run) && readUInt(file, rec.event) && readUInt(file, rec.library)
+              && readLong(file, rec.entry) && rec.library < m_libraries.size();
+
+            if (ok) m_records.push_back(rec);
+        }
+        else ok = false;
+    }
+
+    fclose(file);
+
+    if (!ok) throw std::runtime_error("OverlayProvenanceReader: corrupt or truncated file " + fileName);
+}
+
+bool OverlayProvenanceReader::readUInt(FILE* file, unsigned int& value)
+{
+    unsigned char bytes[4];
+
+    if (fread(bytes, 1, sizeof(bytes), file) != sizeof(bytes)) return false;
+
+    value = 0;
+
+    for(int idx = 0; idx < 4; idx++) value |= (unsigned int)bytes[idx] << (8 * idx);
+
+    return true;
+}
+
+bool OverlayProvenanceReader::readLong(FILE* file, long long& value)
+{
+    unsigned char bytes[8];
+
+    if (fread(bytes, 1, sizeof(bytes), file) != sizeof(bytes)) return false;
+
+    unsigned long long uValue = 0;
+
+    for(int idx = 0; idx < 8; idx++) uValue |= (unsigned long long)bytes[idx] << (8 * idx);
+
+    value = uValue;
+
+    return true;
+}
+
+bool OverlayProvenanceReader::readString(FILE* file, std::string& value)
+{
+    unsigned int length = 0;
+
+    if (!readUInt(file, length)) return false;
+
+    value.resize(length);
+
+    if (length == 0) return true;
+
+    return fread(&value[0], 1, length, file) == length;
+}
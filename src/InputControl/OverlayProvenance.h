@@ -0,0 +1,96 @@
+/** @file OverlayProvenance.h
+
+    @brief declaration of the OverlayProvenanceWriter and OverlayProvenanceReader classes
+
+$Header$
+
+*/
+
+#ifndef OverlayProvenance_h
+#define OverlayProvenance_h
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/** @class OverlayProvenanceWriter
+    @brief Writes a compact record of which overlay library entry was used for each simulated event
+
+    The output is a small binary stream consisting of a header followed by two kinds of records:
+    library records, which describe the tree, branch, format and file list of an input bin the first time
+    it is opened, and event records, which relate a simulated run/event pair to a library index
+    and the entry read from it. All integers are written little endian.
+*/
+class OverlayProvenanceWriter
+{
+public:
+    OverlayProvenanceWriter(const std::string& fileName);
+
+    ~OverlayProvenanceWriter();
+
+    /// Was the output file opened successfully?
+    bool isOpen() const {return m_file != 0;}
+
+    /// Declare a new library, returns the index to use when recording events from it
+    int addLibrary(const std::string&              treeName,
+                   const std::string&              branchName,
+                   const std::string&              format,
+                   const std::vector<std::string>& fileList);
+
+    /// Record the library entry used for the given simulated event
+    void record(unsigned int run, unsigned int event, int library, long long entry);
+
+    /// Flush and close the output file
+    void close();
+
+private:
+    void writeUInt(unsigned int value);
+    void writeLong(long long value);
+    void writeString(const std::string& value);
+
+    FILE* m_file;
+    int   m_numLibraries;
+};
+
+/** @class OverlayProvenanceReader
+    @brief Reads back a file written by OverlayProvenanceWriter
+*/
+class OverlayProvenanceReader
+{
+public:
+    /// Description of an input library (the file list of one input bin)
+    struct Library
+    {
+        std::string              treeName;
+        std::string              branchName;
+        std::string              format;
+        std::vector<std::string> fileList;
+    };
+
+    /// One entry per simulated event, in the order they were processed
+    struct Record
+    {
+        unsigned int run;
+        unsigned int event;
+        unsigned int library;
+        long long    entry;
+    };
+
+    /// Reads the full file, throws std::runtime_error if it cannot be parsed
+    OverlayProvenanceReader(const std::string& fileName);
+
+    ~OverlayProvenanceReader() {}
+
+    const std::vector<Library>& libraries() const {return m_libraries;}
+    const std::vector<Record>&  records()   const {return m_records;}
+
+private:
+    bool readUInt(FILE* file, unsigned int& value);
+    bool readLong(FILE* file, long long& value);
+    bool readString(FILE* file, std::string& value);
+
+    std::vector<Library> m_libraries;
+    std::vector<Record>  m_records;
+};
+
+#endif
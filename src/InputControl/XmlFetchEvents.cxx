@@ -177,8 +177,30 @@ std::vector<std::string> XmlFetchEvents::getFiles(double binVal, bool)
 
         // Retrieve the tree name
         m_branchName = xmlBase::Dom::getAttribute(*domIter, "branchName");
+
+        // Retrieve the storage format
+        m_format = xmlBase::Dom::getAttribute(*domIter, "format");
     }
 
     return fileList;
 }
 
+
+std::vector<std::string> XmlFetchEvents::getFilesByIndex(int binIndex) const
+{
+    std::vector<std::string> fileList;
+
+    if (binIndex < 0 || binIndex >= (int)m_binChildren.size()) return fileList;
+
+    std::vector<DOMElement*> domElemList;
+
+    DOMElement* fileListElem = xmlBase::Dom::findFirstChildByName(m_binChildren[binIndex], "fileList");
+    xmlBase::Dom::getChildrenByTagName(fileListElem, "file", domElemList);
+
+    for (std::vector<DOMElement*>::iterator domIter = domElemList.begin(); domIter != domElemList.end(); domIter++)
+    {
+        fileList.push_back(xmlBase::Dom::getAttribute(*domIter, "filePath"));
+    }
+
+    return fileList;
+}
@@ -46,6 +46,13 @@ public:
 
     virtual std::string getTreeName()   const {return m_treeName;}
     virtual std::string getBranchName() const {return m_branchName;}
+    virtual std::string getFormat()     const {return m_format.empty() ? "object" : m_format;}
+
+    virtual int getNumBins()            const {return m_binChildren.size();}
+    virtual int getCurrentBinIndex()    const {return m_lastBinIndex;}
+
+    /// Returns the file list for the given bin index without changing the current bin
+    virtual std::vector<std::string> getFilesByIndex(int binIndex) const;
 
 private:
 
@@ -70,6 +77,7 @@ private:
     std::string m_name;
     std::string m_treeName;
     std::string m_branchName;
+    std::string m_format;
 
 };
 
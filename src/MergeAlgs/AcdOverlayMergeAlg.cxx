@@ -23,6 +23,11 @@
 #include "OverlayEvent/OverlayEventModel.h"
 #include "OverlayEvent/EventOverlay.h"
 #include "OverlayEvent/AcdOverlay.h"
+#include "Overlay/IOverlayDataSvc.h"
+#include "Overlay/OverlayReadCuts.h"
+#include "Overlay/OverlayEventView.h"
+
+#include "../DataServices/OverlayTdsHandle.h"
 
 #include "GlastSvc/GlastDetSvc/IGlastDetSvc.h"
 
@@ -51,6 +56,30 @@ public:
  
 private:
 
+    /// Tiles are indexed by the AcdId fields
+    enum {NumLayers = 2, NumFaces = 8, NumRows = 8, NumColumns = 8, NumTiles = NumLayers * NumFaces * NumRows * NumColumns};
+
+    /// Index of a tile, -1 if the fields are out of range
+    static int tileIndex(int layer, int face, int row, int column)
+    {
+        if (layer < 0 || layer >= NumLayers || face < 0 || face >= NumFaces || row < 0 || row >= NumRows || column < 0 || column >= NumColumns) return -1;
+
+        return ((layer * NumFaces + face) * NumRows + row) * NumColumns + column;
+    }
+
+    /// The entry and exit points given to the McPositionHit of an overlay hit in a tile
+    struct TileEntry
+    {
+        bool       valid;
+        HepPoint3D entryPoint;
+        HepPoint3D exitPoint;
+        HepPoint3D locEntryPoint;
+        HepPoint3D locExitPoint;
+    };
+
+    /// Work out the points for a tile from its geometry
+    void fillTileEntry(const idents::AcdId& acdId, TileEntry& tileEntry);
+
     /// used for constants & conversion routines.
     IGlastDetSvc*    m_detSvc;
 
@@ -60,8 +89,14 @@ private:
     /// Energy threshold ("zero-suppression") for ACD hits
     double           m_energyThreshold;
 
-    /// Pointer to the overlay's data provider service
-    DataSvc*         m_dataSvc;
+    /// The overlay's data provider service, its event view holds the AcdOverlay data
+    IOverlayDataSvc* m_overlaySvc;
+
+    /// Handle to the EventOverlay in the overlay's data provider service
+    OverlayTdsHandle<Event::EventOverlay> m_overHeader;
+
+    /// The points of every tile, built at initialize
+    std::vector<TileEntry> m_tileTable;
 };
 
 
@@ -72,7 +107,7 @@ DECLARE_ALGORITHM_FACTORY(AcdOverlayMergeAlg);
 
 /// construct object & declare jobOptions
 AcdOverlayMergeAlg::AcdOverlayMergeAlg(const std::string& name, ISvcLocator* pSvcLocator) :
-  Algorithm(name, pSvcLocator)
+  Algorithm(name, pSvcLocator), m_overlaySvc(0)
 {
 
     // Declare the properties that may be set in the job options file
@@ -132,21 +167,95 @@ StatusCode AcdOverlayMergeAlg::initialize()
         return sc;
     }
 
-    // Caste back to the "correct" pointer
-    m_dataSvc = dynamic_cast<DataSvc*>(dataSvc);
+    // Resolve the overlay objects we use once, here, the AcdOverlay data are read from the service's event view
+    if (!(m_overlaySvc = dynamic_cast<IOverlayDataSvc*>(dataSvc))) {
+        log << MSG::ERROR << "  " << dataSvcName << " is not an overlay data service " << endreq;
+        return StatusCode::FAILURE;
+    }
+    if ((sc = m_overHeader.initialize(dataSvc, OverlayEventModel::Overlay::EventOverlay)).isFailure()) {
+        log << MSG::ERROR << "  " << dataSvcName << " is not an overlay data service " << endreq;
+        return sc;
+    }
+
+    // Tell the converters what we will use: only tiles are merged and hits below the energy 
+    // threshold are dropped, so they need not be built at all
+    OverlayReadCuts readCuts;
+    readCuts.needSubsystem(OverlayReadCuts::Acd);
+    readCuts.setAcdTilesOnly(true);
+    readCuts.setAcdEnergyThreshold(m_energyThreshold);
+
+    m_overlaySvc->declareReadCuts(readCuts);
+
+    // The points depend only on the tile, work them out for all tiles the geometry has
+    TileEntry noTile;
+    noTile.valid = false;
+
+    m_tileTable.assign(NumTiles, noTile);
+
+    const std::map<idents::AcdId, int>& acdIdVolCount = m_acdGeoSvc->getAcdIdVolCountCol();
+
+    for(std::map<idents::AcdId, int>::const_iterator volIter = acdIdVolCount.begin(); volIter != acdIdVolCount.end(); volIter++)
+    {
+        const idents::AcdId& acdId = volIter->first;
+        int                  index = tileIndex(acdId.layer(), acdId.face(), acdId.row(), acdId.column());
+
+        if (acdId.tile() && index >= 0) fillTileEntry(acdId, m_tileTable[index]);
+    }
 
     return sc;
 }
 
+void AcdOverlayMergeAlg::fillTileEntry(const idents::AcdId& acdId, TileEntry& tileEntry)
+{
+    // Look up the geometry for the tile
+    const AcdTileDim* tileDim = m_acdGeoSvc->geomMap().getTile(acdId,*m_acdGeoSvc);
+
+    // Work out the entry point
+    HepPoint3D entryPoint = tileDim->corner(0)[0];
+
+    for(int idx = 1; idx < 4; idx++) entryPoint += tileDim->corner(0)[idx];
+
+    entryPoint /= 4;
+
+    HepPoint3D locEntryPoint;
+
+    tileDim->toLocal(entryPoint, locEntryPoint, 0);
+
+    HepPoint3D locExitPoint(locEntryPoint.x(), locEntryPoint.y(), locEntryPoint.z() + 0.5);
+
+    HepPoint3D exitPoint = tileDim->transform(0).inverse() * locExitPoint;
+
+    // Irregular shape?
+    if (tileDim->nVol() > 1)
+    {
+        // Work out the exit point (only its local version is used, as it always has been)
+        HepPoint3D exitPoint = tileDim->corner(1)[0];
+
+        for(int idx = 1; idx < 4; idx++) exitPoint += tileDim->corner(1)[idx];
+
+        exitPoint /= 4;
+
+        tileDim->toLocal(exitPoint, locExitPoint, 1);
+    }
+
+    tileEntry.valid         = true;
+    tileEntry.entryPoint    = entryPoint;
+    tileEntry.exitPoint     = exitPoint;
+    tileEntry.locEntryPoint = locEntryPoint;
+    tileEntry.locExitPoint  = locExitPoint;
+
+    return;
+}
+
 /// \brief take Hits from McIntegratingHits, create & register AcdDigis
 StatusCode AcdOverlayMergeAlg::execute() 
 {
     // Get a message object for output
     MsgStream msglog(msgSvc(), name());
 
-    // First, recover any overlay digis, to see if we have anything to do
-    SmartDataPtr<Event::AcdOverlayCol> overlayCol(m_dataSvc, m_dataSvc->rootName() + OverlayEventModel::Overlay::AcdOverlayCol);
-    if (!overlayCol) return StatusCode::SUCCESS;
+    // First, recover the overlay event, to see if we have anything to do
+    const OverlayEventView* overlayView = m_overlaySvc->getOverlayEventView();
+    if (!overlayView) return StatusCode::SUCCESS;
 
     // The calibration will need the Event Header information for both the sim and the overlay
     SmartDataPtr<Event::McPositionHitCol> mcPosHitCol(eventSvc(), EventModel::MC::McPositionHitCol);
@@ -161,68 +270,37 @@ StatusCode AcdOverlayMergeAlg::execute()
     }
 
     // The calibration will need the Event Header information for both the sim and the overlay
-    SmartDataPtr<Event::EventOverlay> overHeader(m_dataSvc, m_dataSvc->rootName() + OverlayEventModel::Overlay::EventOverlay);
+    Event::EventOverlay* overHeader = m_overHeader.get();
   
     if (!overHeader) {
       msglog << MSG::ERROR << "Unable to retrieve event timestamp for overlay" << endreq;
       return StatusCode::FAILURE;
     }
 
-    // Loop through the input digis and using the above map merge with existing MC digis
-    for(Event::AcdOverlayCol::iterator overIter  = overlayCol->begin(); overIter != overlayCol->end(); overIter++)
+    // Loop through the rows of input digis and using the above map merge with existing MC digis
+    for(unsigned int row = 0; row < overlayView->numAcd(); row++)
     {
-        Event::AcdOverlay* acdOverlay = *overIter;
-
         // Retrieve the volume identifiers
-        const idents::VolumeIdentifier& volumeId = acdOverlay->getVolumeId();
-        const idents::AcdId&            acdId    = acdOverlay->getAcdId();
+        idents::VolumeIdentifier volumeId;
+        volumeId.init(overlayView->acdVolId[row], overlayView->acdVolIdSize[row]);
+
+        idents::AcdId acdId(overlayView->acdLayer[row], overlayView->acdFace[row], overlayView->acdRow[row], overlayView->acdColumn[row]);
 
         // Energy deposited
-        double energyDep = acdOverlay->getEnergyDep();
+        double energyDep = overlayView->acdEnergy[row];
 
         //if threshold is above zero, cut on that value...
         if (m_energyThreshold>0.0 && energyDep < m_energyThreshold) continue;
 
-        // Position
-        HepPoint3D position = acdOverlay->getPosition();
-
-        HepPoint3D center;
-
         // If we have a struck tile go down this path
         if (acdId.tile())
         {
-            // Look up the geometry for the tile
-            const AcdTileDim* tileDim = m_acdGeoSvc->geomMap().getTile(acdId,*m_acdGeoSvc);
-
-            center = tileDim->tileCenter(0);
-
-            // Work out the entry point
-            HepPoint3D entryPoint = tileDim->corner(0)[0];
-
-            for(int idx = 1; idx < 4; idx++) entryPoint += tileDim->corner(0)[idx];
-
-            entryPoint /= 4;
-
-            HepPoint3D locEntryPoint;
-
-            tileDim->toLocal(entryPoint, locEntryPoint, 0);
-
-            HepPoint3D locExitPoint(locEntryPoint.x(), locEntryPoint.y(), locEntryPoint.z() + 0.5);
-
-            HepPoint3D exitPoint = tileDim->transform(0).inverse() * locExitPoint;
-
-            // Irregular shape?
-            if (tileDim->nVol() > 1)
-            {
-                // Work out the exit point
-                HepPoint3D exitPoint = tileDim->corner(1)[0];
-
-                for(int idx = 1; idx < 4; idx++) exitPoint += tileDim->corner(1)[idx];
-
-                exitPoint /= 4;
+            // The points for the tile come from the table, a tile it does not have is added now
+            int        index = tileIndex(acdId.layer(), acdId.face(), acdId.row(), acdId.column());
+            TileEntry  extraEntry;
+            TileEntry* tileEntry = index >= 0 ? &m_tileTable[index] : &extraEntry;
 
-                tileDim->toLocal(exitPoint, locExitPoint, 1);
-            }
+            if (index < 0 || !tileEntry->valid) fillTileEntry(acdId, *tileEntry);
 
             // Create a new McPositionHit for this 
             Event::McPositionHit* mcHit = new Event::McPositionHit();
@@ -230,14 +308,14 @@ StatusCode AcdOverlayMergeAlg::execute()
             // Initalize
             mcHit->init(energyDep, 
                         volumeId, 
-                        locEntryPoint, 
-                        locExitPoint, 
-                        entryPoint, 
-                        exitPoint, 
+                        tileEntry->locEntryPoint, 
+                        tileEntry->locExitPoint, 
+                        tileEntry->entryPoint, 
+                        tileEntry->exitPoint, 
                         Event::McPositionHit::overlayHit);
 
             // Since this is from overlay, add the acdOverlay status mask to the packed flags
-            mcHit->addPackedMask(acdOverlay->getStatus() | Event::AcdDigi::DIGI_OVERLAY);
+            mcHit->addPackedMask(overlayView->acdStatus[row] | Event::AcdDigi::DIGI_OVERLAY);
 
             mcPosHitCol->push_back(mcHit);
         }
@@ -0,0 +1,255 @@
+/**  @file CalDiodeLightKernel.cxx
+@brief implementation of class CalDiodeLightKernel
+
+$Header$
+*/
+
+#include "CalDiodeLightKernel.h"
+
+#include <algorithm>
+#include <cmath>
+
+// The AVX2 version is compiled for that target whatever the build flags and only called when the
+// processor has it
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define CALDIODELIGHT_AVX2
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    /// Distance from the diode centre to the hit and the argument of the solid angle asin, for one
+    /// hit and diode. The operations are those of the Hep3Vector code this replaces
+    inline void diodeGeometry(double globalX, double globalY, double globalZ,
+                              double diodeX,  double diodeY,  double diodeZ,
+                              double nrmlX,   double nrmlY,   double nrmlZ,
+                              double faceAlpha, double faceBeta, double& distToCenter, double& aSinArg)
+    {
+        // Get the vector from the center of the diode to the current energy deposition point
+        double lineX = globalX - diodeX;
+        double lineY = globalY - diodeY;
+        double lineZ = globalZ - diodeZ;
+        double mag2  = lineX*lineX + lineY*lineY + lineZ*lineZ;
+
+        distToCenter = std::sqrt(mag2);
+
+        // Now want the angle between this line and the diode normal
+        if (mag2 > 0.)
+        {
+            double norm = 1.0 / std::sqrt(mag2);
+
+            lineX *= norm;
+            lineY *= norm;
+            lineZ *= norm;
+        }
+
+        double cosTheta = lineX*nrmlX + lineY*nrmlY + lineZ*nrmlZ;
+
+        if (cosTheta < 0.) cosTheta *= -1.;
+
+        // Projected area of rectangle is diodeFaceArea * cosTheta, which can also be
+        // written as diodeFaceAlpha * diodeFaceBeta * cosTheta, so we scale diodeFaceBeta
+        // by cosTheta for what follows
+        double faceBetaPr = faceBeta * cosTheta;
+
+        // Determine fractional solid angle subtended. For this problem, this is the solid
+        // angle subtended by a pyramid.
+        double radical = (4.*distToCenter*distToCenter + faceAlpha*faceAlpha)
+                       * (4.*distToCenter*distToCenter + faceBetaPr*faceBetaPr);
+
+        aSinArg = faceAlpha * faceBetaPr / std::sqrt(radical);
+    }
+
+#ifdef CALDIODELIGHT_AVX2
+    bool cpuHasAvx2()
+    {
+        __builtin_cpu_init();
+
+        return __builtin_cpu_supports("avx2");
+    }
+#else
+    bool cpuHasAvx2() {return false;}
+#endif
+}
+
+CalDiodeLightKernel::CalDiodeLightKernel() : m_useAvx2(cpuHasAvx2()), m_faceBeta(0.)
+{
+    for(int diode = 0; diode < NumDiodes; diode++) m_faceAlpha[diode] = 0.;
+}
+
+void CalDiodeLightKernel::setDiodeFaces(const std::vector<double>& heights, double width)
+{
+    for(int diode = 0; diode < NumDiodes && diode < (int)heights.size(); diode++) m_faceAlpha[diode] = 2. * heights[diode];
+
+    m_faceBeta = 2. * width;
+}
+
+void CalDiodeLightKernel::useAvx2(bool useIt)
+{
+    m_useAvx2 = useIt && cpuHasAvx2();
+}
+
+void CalDiodeLightKernel::clear()
+{
+    m_globalX.clear();
+    m_globalY.clear();
+    m_globalZ.clear();
+    m_localX.clear();
+    m_localY.clear();
+    m_energy.clear();
+    m_diodes.clear();
+}
+
+void CalDiodeLightKernel::addHit(double globalX, double globalY, double globalZ, double localX, double localY,
+                                 double energy, const Diodes* diodes)
+{
+    m_globalX.push_back(globalX);
+    m_globalY.push_back(globalY);
+    m_globalZ.push_back(globalZ);
+    m_localX.push_back(localX);
+    m_localY.push_back(localY);
+    m_energy.push_back(energy);
+    m_diodes.push_back(diodes);
+}
+
+void CalDiodeLightKernel::run()
+{
+    unsigned int numPairs = numHits() * NumDiodes;
+
+    m_distToCenter.resize(numPairs);
+    m_aSinArg.resize(numPairs);
+    m_totalDepE.resize(numPairs);
+    m_directDepE.resize(numPairs);
+
+    if (m_useAvx2) geometryAvx2(0, numHits());
+    else           geometryScalar(0, numHits());
+
+    // The light fractions, the same for both versions
+    for(unsigned int pair = 0; pair < numPairs; pair++)
+    {
+        unsigned int hit = pair / NumDiodes;
+
+        double fracAngle  = asin(m_aSinArg[pair]) / M_PI;
+        double directFrac = 0.;
+        double totalDep   = 0.;
+
+        // Does angle to surface normal put us in the range of surface reflection?
+        if (m_distToCenter[pair] < 30.)
+        {
+            // The following is based on patterns extracted from flight data
+            double dist2Side = std::max(0., 13.5 -fabs(m_localY[hit]));
+            double dist2End  = std::max(0., 165.-fabs(m_localX[hit]));
+
+            // No angle factor for direct light - probably due to end roughening...
+            directFrac += fracAngle;
+
+            // Total light attenuation governed by location - strong dependence side to side,
+            // as well as dependencce with distance from end
+            if(dist2End < 30)
+            {
+                double attenFactor = ((30. - dist2End) * (std::max(0., 13.5-dist2Side)))/ (30.*13.5);
+                totalDep += 1. - .33*attenFactor * attenFactor;
+            }
+            else
+            {
+                totalDep   += 1.;
+                directFrac += fracAngle;
+            }
+        }
+        // Otherwise, all light "seen" by diode and all energy deposited in crystal
+        else
+        {
+            directFrac += fracAngle;
+            totalDep   += 1.;
+        }
+
+        // Now get the direct and total energy fractions
+        m_directDepE[pair] = m_energy[hit] * directFrac;
+        m_totalDepE[pair]  = m_energy[hit] * totalDep;
+    }
+
+    return;
+}
+
+void CalDiodeLightKernel::geometryScalar(unsigned int begin, unsigned int end)
+{
+    for(unsigned int hit = begin; hit < end; hit++)
+    {
+        const Diodes& diodes = *m_diodes[hit];
+
+        for(int diode = 0; diode < NumDiodes; diode++)
+        {
+            unsigned int pair = hit * NumDiodes + diode;
+
+            diodeGeometry(m_globalX[hit], m_globalY[hit], m_globalZ[hit],
+                          diodes.x[diode], diodes.y[diode], diodes.z[diode],
+                          diodes.nrmlX[diode], diodes.nrmlY[diode], diodes.nrmlZ[diode],
+                          m_faceAlpha[diode], m_faceBeta, m_distToCenter[pair], m_aSinArg[pair]);
+        }
+    }
+
+    return;
+}
+
+#ifdef CALDIODELIGHT_AVX2
+
+// One hit per iteration, its four diodes in the four lanes. Only plain IEEE operations (no fused
+// multiply-add) so each lane gives exactly what diodeGeometry does
+__attribute__((target("avx2")))
+void CalDiodeLightKernel::geometryAvx2(unsigned int begin, unsigned int end)
+{
+    const __m256d zero      = _mm256_setzero_pd();
+    const __m256d one       = _mm256_set1_pd(1.0);
+    const __m256d four      = _mm256_set1_pd(4.);
+    const __m256d signBit   = _mm256_set1_pd(-0.);
+    const __m256d faceAlpha = _mm256_loadu_pd(m_faceAlpha);
+    const __m256d faceBeta  = _mm256_set1_pd(m_faceBeta);
+    const __m256d alpha2    = _mm256_mul_pd(faceAlpha, faceAlpha);
+
+    for(unsigned int hit = begin; hit < end; hit++)
+    {
+        const Diodes& diodes = *m_diodes[hit];
+
+        __m256d lineX = _mm256_sub_pd(_mm256_set1_pd(m_globalX[hit]), _mm256_loadu_pd(diodes.x));
+        __m256d lineY = _mm256_sub_pd(_mm256_set1_pd(m_globalY[hit]), _mm256_loadu_pd(diodes.y));
+        __m256d lineZ = _mm256_sub_pd(_mm256_set1_pd(m_globalZ[hit]), _mm256_loadu_pd(diodes.z));
+
+        __m256d mag2  = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(lineX, lineX), _mm256_mul_pd(lineY, lineY)),
+                                      _mm256_mul_pd(lineZ, lineZ));
+        __m256d dist  = _mm256_sqrt_pd(mag2);
+
+        // Unit vector, a zero length line is left as it is
+        __m256d norm    = _mm256_div_pd(one, dist);
+        __m256d nonZero = _mm256_cmp_pd(mag2, zero, _CMP_GT_OQ);
+
+        lineX = _mm256_blendv_pd(lineX, _mm256_mul_pd(lineX, norm), nonZero);
+        lineY = _mm256_blendv_pd(lineY, _mm256_mul_pd(lineY, norm), nonZero);
+        lineZ = _mm256_blendv_pd(lineZ, _mm256_mul_pd(lineZ, norm), nonZero);
+
+        __m256d cosTheta = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(lineX, _mm256_loadu_pd(diodes.nrmlX)),
+                                                       _mm256_mul_pd(lineY, _mm256_loadu_pd(diodes.nrmlY))),
+                                         _mm256_mul_pd(lineZ, _mm256_loadu_pd(diodes.nrmlZ)));
+
+        cosTheta = _mm256_andnot_pd(signBit, cosTheta);
+
+        __m256d faceBetaPr = _mm256_mul_pd(faceBeta, cosTheta);
+        __m256d dist4      = _mm256_mul_pd(_mm256_mul_pd(four, dist), dist);
+        __m256d radical    = _mm256_mul_pd(_mm256_add_pd(dist4, alpha2),
+                                           _mm256_add_pd(dist4, _mm256_mul_pd(faceBetaPr, faceBetaPr)));
+        __m256d aSinArg    = _mm256_div_pd(_mm256_mul_pd(faceAlpha, faceBetaPr), _mm256_sqrt_pd(radical));
+
+        _mm256_storeu_pd(&m_distToCenter[hit * NumDiodes], dist);
+        _mm256_storeu_pd(&m_aSinArg[hit * NumDiodes],      aSinArg);
+    }
+
+    return;
+}
+
+#else
+
+void CalDiodeLightKernel::geometryAvx2(unsigned int begin, unsigned int end)
+{
+    geometryScalar(begin, end);
+}
+
+#endif
@@ -0,0 +1,95 @@
+/** @file CalDiodeLightKernel.h
+
+    @brief declaration of the CalDiodeLightKernel class
+
+$Header$
+
+*/
+
+#ifndef CalDiodeLightKernel_h
+#define CalDiodeLightKernel_h
+
+#include <vector>
+
+/** @class CalDiodeLightKernel
+    @brief Computes, for a batch of Cal overlay hits, the light each of the four diodes of the hit
+           crystal sees (as done one hit at a time in G4Generator's IntDetectorManager)
+
+    The hits of an event are added one at a time and kept as a structure of arrays, run() then
+    works through all hits x 4 diodes at once. The geometry part (distance and angle to each diode,
+    solid angle argument) is done four diodes at a time with AVX2 when the processor has it, the
+    same operations in the same order as the scalar code so the results are identical. The asin and
+    the light attenuation are then done in a scalar pass.
+*/
+class CalDiodeLightKernel
+{
+public:
+    enum {NumDiodes = 4};
+
+    /// The four diodes of a crystal: their centres and their normals pointing into the crystal
+    struct Diodes
+    {
+        double x[NumDiodes];
+        double y[NumDiodes];
+        double z[NumDiodes];
+        double nrmlX[NumDiodes];
+        double nrmlY[NumDiodes];
+        double nrmlZ[NumDiodes];
+    };
+
+    /// Picks the AVX2 implementation if the processor supports it
+    CalDiodeLightKernel();
+    ~CalDiodeLightKernel() {}
+
+    /// Set the diode face dimensions, height of each diode and the common width (half sizes)
+    void setDiodeFaces(const std::vector<double>& heights, double width);
+
+    /// Use the AVX2 implementation (if the processor supports it) or the scalar one
+    void useAvx2(bool useIt);
+    bool usingAvx2() const {return m_useAvx2;}
+
+    /// Start a new batch
+    void clear();
+
+    /// Add a hit: its global position, its position in the crystal centre frame, its energy and the
+    /// diodes of its crystal (which must stay valid until run())
+    void addHit(double globalX, double globalY, double globalZ, double localX, double localY,
+                double energy, const Diodes* diodes);
+
+    /// Compute the deposited energies for all hits added
+    void run();
+
+    unsigned int numHits() const {return m_energy.size();}
+
+    /// Results of run(), total and direct energy seen by a diode for a hit
+    double totalDepE(unsigned int hit, int diode)  const {return m_totalDepE[hit * NumDiodes + diode];}
+    double directDepE(unsigned int hit, int diode) const {return m_directDepE[hit * NumDiodes + diode];}
+
+private:
+    /// Geometry part for hits [begin, end), fills m_distToCenter and m_aSinArg
+    void geometryScalar(unsigned int begin, unsigned int end);
+    void geometryAvx2(unsigned int begin, unsigned int end);
+
+    bool                        m_useAvx2;
+
+    /// Twice the diode face dimensions
+    double                      m_faceAlpha[NumDiodes];
+    double                      m_faceBeta;
+
+    /// One entry per hit
+    std::vector<double>         m_globalX;
+    std::vector<double>         m_globalY;
+    std::vector<double>         m_globalZ;
+    std::vector<double>         m_localX;
+    std::vector<double>         m_localY;
+    std::vector<double>         m_energy;
+    std::vector<const Diodes*>  m_diodes;
+
+    /// One entry per hit and diode
+    std::vector<double>         m_distToCenter;
+    std::vector<double>         m_aSinArg;
+    std::vector<double>         m_totalDepE;
+    std::vector<double>         m_directDepE;
+};
+
+#endif
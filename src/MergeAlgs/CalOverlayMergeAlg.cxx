@@ -22,6 +22,9 @@
 #include "OverlayEvent/OverlayEventModel.h"
 #include "OverlayEvent/EventOverlay.h"
 #include "OverlayEvent/CalOverlay.h"
+#include "Overlay/IOverlayDataSvc.h"
+#include "Overlay/OverlayReadCuts.h"
+#include "Overlay/OverlayEventView.h"
 #include "CalUtil/CalDefs.h"
 #include "GlastSvc/GlastDetSvc/IGlastDetSvc.h"
 #include "GlastSvc/Reco/IPropagator.h"
@@ -31,7 +34,9 @@
 #include "CLHEP/Geometry/Point3D.h"
 #include "CLHEP/Geometry/Vector3D.h"
 
-#include <map>
+#include "CalDiodeLightKernel.h"
+
+#include <cmath>
 
 typedef HepGeom::Point3D<double> HepPoint3D;
 typedef HepGeom::Vector3D<double> HepVector3D;
@@ -45,21 +50,100 @@ public:
 
     StatusCode initialize();
     StatusCode execute();
-    StatusCode finalize() {return StatusCode::SUCCESS;}
+    StatusCode finalize();
  
 private:
 
+    /// Crystals are indexed by tower, layer and column, each has this many segments
+    enum {NumTowers = 16, NumLayers = 8, NumColumns = 12, NumXtals = NumTowers * NumLayers * NumColumns, NumSegments = 12,
+          NumSegmentSlots = NumXtals * NumSegments};
+
+    static int xtalIndex(int tower, int layer, int column) {return (tower * NumLayers + layer) * NumColumns + column;}
+    static int segmentSlot(int xtal, int segment)          {return xtal * NumSegments + segment;}
+
+    /// The static geometry of one crystal, everything the merge needs from the detector service
+    struct XtalGeometry
+    {
+        /// The segment nearest a position along the crystal (x in the crystal centre frame)
+        int segmentAt(double longPos) const
+        {
+            int nearest = 0;
+
+            for(int segment = 1; segment < NumSegments; segment++)
+            {
+                if (fabs(longPos - segmentCentre[segment]) < fabs(longPos - segmentCentre[nearest])) nearest = segment;
+            }
+
+            return nearest;
+        }
+
+        idents::VolumeIdentifier xtalId;                   ///< the crystal, all but the segment field
+        double               segmentCentre[NumSegments];   ///< along the crystal, in the crystal centre frame
+        bool                 segmentValid[NumSegments];
+        HepGeom::Transform3D segmentInverse[NumSegments];  ///< global to segment local
+        bool                 centreValid;
+        HepGeom::Transform3D centreInverse;                ///< global to crystal centre local
+        bool                 diodeValid[CalDiodeLightKernel::NumDiodes];
+        CalDiodeLightKernel::Diodes diodes;                ///< diode centres and normals, order as m_diodeNames
+    };
+
+    /// What goes into one McIntegratingHit: one overlay hit or, when they are aggregated, all
+    /// the overlay hits of a crystal segment. The positions are kept for a single hit so it goes
+    /// in exactly as it is, the moments give the energy weighted positions of several
+    struct SegmentDeposit
+    {
+        Event::McIntegratingHit* mcHit;
+        const XtalGeometry*      xtalGeom;
+        int                      numHits;
+        double                   energy;
+        HepPoint3D               localHit;                 ///< first hit, in the segment frame
+        HepPoint3D               centreHit;                ///< first hit, in the crystal centre frame
+        double                   energyMoment[3];
+        double                   diodeTotal[CalDiodeLightKernel::NumDiodes];
+        double                   diodeDirect[CalDiodeLightKernel::NumDiodes];
+        double                   diodeMoment[CalDiodeLightKernel::NumDiodes][3];
+    };
+
+    /// Fill the geometry table, crystals the detector service does not know are left invalid
+    void fillXtalGeometry();
+
+    /// Slot of a Cal crystal segment VolumeIdentifier, -1 if it is not one
+    int volIdSlot(const idents::VolumeIdentifier& volId) const;
+
+    /// The McIntegratingHit an overlay hit in a slot goes to, an existing pure overlay one or a new one
+    Event::McIntegratingHit* findMcHit(int slot, const idents::VolumeIdentifier& overId, Event::McIntegratingHitCol* calMcHitCol);
+
+    /// Position for a deposit: the single hit's own or the weighted mean of several
+    static HepPoint3D depositPosition(int numHits, const HepPoint3D& first, const double* moment, double weight);
+
     /// For making a VolumeIdentifier
     idents::VolumeIdentifier makeVolId(idents::CalXtalId calXtalId);
 
+    /// The segment VolumeIdentifier the propagator finds at a position, the reference for the analytic one
+    idents::VolumeIdentifier propagatorVolId(const Point& position);
+
     /// used for constants & conversion routines.
     IGlastDetSvc*            m_detSvc;
 
     /// Pointer to the propagator
     IPropagator*             m_propagator;
 
-    /// Pointer to the overlay's data provider service
-    DataSvc*         m_dataSvc;
+    /// The overlay's data provider service, its event view holds the CalOverlay data
+    IOverlayDataSvc*         m_overlaySvc;
+
+    /// Check the analytic segment identifiers against the propagator (slow, needs Geant4 navigation)
+    BooleanProperty          m_validateVolIds;
+
+    /// Sum the overlay hits of each crystal segment into a single energy item (and one per diode).
+    /// Off by default: the deposited energies and their moments are unchanged but CalXtalResponse
+    /// evaluates the light taper once at the segment's energy weighted mean position instead of at
+    /// each hit, so the CalDigi ADC values differ by the curvature of the taper over the spread of
+    /// the hits within the segment (which is at most one segment, about 27 mm, long)
+    BooleanProperty          m_aggregateDeposits;
+
+    /// Number of hits checked and number where the two identifiers differ
+    int                      m_numVolIdChecked;
+    int                      m_numVolIdMismatch;
 
     /// store first range option ("autoRng" ---> best range first, "lex8", "lex1", "hex8", "hex1" ---> lex8-hex1 first)
     StringProperty           m_firstRng;
@@ -68,6 +152,23 @@ private:
     std::vector<std::string> m_diodeNames;
     std::vector<double>      m_diodeHeights;
     double                   m_diodeWidth;
+
+    /// The geometry of every crystal, built at initialize
+    std::vector<XtalGeometry> m_xtalGeometry;
+
+    /// The light seen by the diodes, computed for all the hits of an event at once
+    CalDiodeLightKernel      m_diodeLight;
+
+    /// The McIntegratingHits of the event by crystal segment slot, and the slots set (to reset them)
+    std::vector<Event::McIntegratingHit*> m_slotMcHits;
+    std::vector<int>         m_usedSlots;
+
+    /// The deposits of the event, the deposit (if any) of each slot when aggregating, and for each
+    /// hit given to the diode light kernel its deposit and position in the crystal centre frame
+    std::vector<SegmentDeposit> m_deposits;
+    std::vector<int>         m_slotDeposits;
+    std::vector<int>         m_hitDeposits;
+    std::vector<HepPoint3D>  m_hitCentres;
 };
 
 
@@ -78,11 +179,13 @@ DECLARE_ALGORITHM_FACTORY(CalOverlayMergeAlg);
 
 /// construct object & declare jobOptions
 CalOverlayMergeAlg::CalOverlayMergeAlg(const string& name, ISvcLocator* pSvcLocator) :
-  Algorithm(name, pSvcLocator)
+  Algorithm(name, pSvcLocator), m_propagator(0), m_overlaySvc(0), m_numVolIdChecked(0), m_numVolIdMismatch(0)
 {
 
     // Declare the properties that may be set in the job options file
     declareProperty("FirstRangeReadout",   m_firstRng= "autoRng"); 
+    declareProperty("ValidateVolumeIds",   m_validateVolIds = false);
+    declareProperty("AggregateSegmentDeposits", m_aggregateDeposits = false);
 }
 
 /// initialize the algorithm. retrieve helper tools & services
@@ -123,16 +226,29 @@ StatusCode CalOverlayMergeAlg::initialize()
         return sc;
     }
 
-    // Caste back to the "correct" pointer
-    m_dataSvc = dynamic_cast<DataSvc*>(dataSvc);
+    // The CalOverlay data are read from the service's event view
+    if (!(m_overlaySvc = dynamic_cast<IOverlayDataSvc*>(dataSvc))) {
+        log << MSG::ERROR << "  " << dataSvcName << " is not an overlay data service " << endreq;
+        return StatusCode::FAILURE;
+    }
+
+    // Tell the converters what we will use so nothing else is built
+    OverlayReadCuts readCuts;
+    readCuts.needSubsystem(OverlayReadCuts::Cal);
+
+    m_overlaySvc->declareReadCuts(readCuts);
 
-    // Get a copy of the propagator
-    sc = toolSvc()->retrieveTool("G4PropagationTool", m_propagator);
-    if (sc.isSuccess()) 
+    // Get a copy of the propagator, only needed to check the segment identifiers
+    if (m_validateVolIds)
     {
-        log << MSG::INFO << "Retrieved G4PropagationTool" << endreq;
-    } else {
-        log << MSG::ERROR << "Couldn't retrieve G4PropagationTool" << endreq;
+        sc = toolSvc()->retrieveTool("G4PropagationTool", m_propagator);
+        if (sc.isSuccess()) 
+        {
+            log << MSG::INFO << "Retrieved G4PropagationTool" << endreq;
+        } else {
+            log << MSG::ERROR << "Couldn't retrieve G4PropagationTool" << endreq;
+            return sc;
+        }
     }
 
     // Initialize the diode names
@@ -159,18 +275,145 @@ StatusCode CalOverlayMergeAlg::initialize()
     
     m_diodeWidth = diodeZ;
 
+    // Look up the crystal, segment and diode transforms once, the merge only reads this table
+    fillXtalGeometry();
+
+    m_diodeLight.setDiodeFaces(m_diodeHeights, m_diodeWidth);
+
+    m_slotMcHits.assign(NumSegmentSlots, 0);
+    m_slotDeposits.assign(NumSegmentSlots, -1);
+
+    log << MSG::INFO << "Diode light computed with the " << (m_diodeLight.usingAvx2() ? "AVX2" : "scalar") 
+        << " kernel" << endreq;
+
     return sc;
 }
 
+void CalOverlayMergeAlg::fillXtalGeometry()
+{
+    MsgStream log(msgSvc(), name());
+
+    m_xtalGeometry.resize(NumXtals);
+
+    int numValid = 0;
+
+    for(int tower = 0; tower < NumTowers; tower++)
+    {
+        for(int layer = 0; layer < NumLayers; layer++)
+        {
+            for(int column = 0; column < NumColumns; column++)
+            {
+                idents::CalXtalId        calXtalId(tower, layer, column);
+                idents::VolumeIdentifier xtalId = makeVolId(calXtalId);
+                XtalGeometry&            geom   = m_xtalGeometry[xtalIndex(tower, layer, column)];
+
+                // The log part of the identifier, everything up to the cell component
+                idents::VolumeIdentifier logId;
+
+                for(int idx = 0; idx < CalUtil::fCellCmp; idx++) logId.append(xtalId[idx]);
+
+                geom.xtalId = logId;
+                geom.xtalId.append(0);
+
+                // The segments, with the transforms used to find the local hit position
+                HepGeom::Transform3D xtalLowTransform;
+                HepGeom::Transform3D xtalHiTransform;
+                HepPoint3D           segmentTrans[NumSegments];
+
+                for(int segment = 0; segment < NumSegments; segment++)
+                {
+                    idents::VolumeIdentifier segmentId = logId;
+                    HepGeom::Transform3D     segmentTransform;
+
+                    segmentId.append(0);
+                    segmentId.append(segment);
+
+                    geom.segmentValid[segment] = m_detSvc->getTransform3DByID(segmentId, &segmentTransform).isSuccess();
+
+                    if (!geom.segmentValid[segment]) continue;
+
+                    geom.segmentInverse[segment] = segmentTransform.inverse();
+                    segmentTrans[segment]        = segmentTransform.getTranslation();
+
+                    if (segment == 0)             xtalLowTransform = segmentTransform;
+                    if (segment == NumSegments-1) xtalHiTransform  = segmentTransform;
+                }
+
+                // The centre of the crystal, from its low and high end segments (see execute for the details)
+                HepGeom::Transform3D xtalTransform;
+
+                geom.centreValid = geom.segmentValid[0] && geom.segmentValid[NumSegments-1];
+
+                if (geom.centreValid)
+                {
+                    CLHEP::Hep3Vector xtalTrans(0.5*(xtalHiTransform.dx()+xtalLowTransform.dx()), 
+                                                0.5*(xtalHiTransform.dy()+xtalLowTransform.dy()),
+                                                xtalHiTransform.dz());
+
+                    xtalTransform      = HepGeom::Transform3D(xtalHiTransform.getRotation(), xtalTrans);
+                    geom.centreInverse = xtalTransform.inverse();
+
+                    numValid++;
+                }
+
+                // Where the segments are along the crystal, a segment which is missing is never the nearest
+                for(int segment = 0; segment < NumSegments; segment++)
+                {
+                    geom.segmentCentre[segment] = geom.centreValid && geom.segmentValid[segment] 
+                                                ? (geom.centreInverse * segmentTrans[segment]).x() : 1.e30;
+                }
+
+                // The diodes (order is small Neg, small Pos, large Neg, large Pos)
+                for(int diodeIdx = 1; diodeIdx < 5; diodeIdx++)
+                {
+                    idents::VolumeIdentifier diodeId = logId;
+                    HepGeom::Transform3D     trnsDiode;
+
+                    diodeId.append(diodeIdx);
+
+                    geom.diodeValid[diodeIdx-1] = geom.centreValid && m_detSvc->getTransform3DByID(diodeId, &trnsDiode).isSuccess();
+
+                    if (!geom.diodeValid[diodeIdx-1]) continue;
+
+                    // The normal pointing from the diode into the xtal, along y or x depending on
+                    // what the crystal measures and on which side of its centre the diode sits
+                    CLHEP::Hep3Vector diodeNrml(0., 1., 0.);
+
+                    double longDistToDiode = xtalTransform.dy() - trnsDiode.dy();
+
+                    if (calXtalId.isX()) 
+                    {
+                        longDistToDiode = xtalTransform.dx() - trnsDiode.dx();
+                        diodeNrml       = CLHEP::Hep3Vector(1., 0., 0.);
+                    }
+
+                    if (longDistToDiode < 0.) diodeNrml *= -1.;
+
+                    geom.diodes.x[diodeIdx-1]     = trnsDiode.dx();
+                    geom.diodes.y[diodeIdx-1]     = trnsDiode.dy();
+                    geom.diodes.z[diodeIdx-1]     = trnsDiode.dz();
+                    geom.diodes.nrmlX[diodeIdx-1] = diodeNrml.x();
+                    geom.diodes.nrmlY[diodeIdx-1] = diodeNrml.y();
+                    geom.diodes.nrmlZ[diodeIdx-1] = diodeNrml.z();
+                }
+            }
+        }
+    }
+
+    log << MSG::INFO << "Cached the geometry of " << numValid << " crystals" << endreq;
+
+    return;
+}
+
 /// \brief take Hits from McIntegratingHits, create & register CalDigis
 StatusCode CalOverlayMergeAlg::execute() 
 {
     // Get a message object for output
     MsgStream log(msgSvc(), name());
 
-    // First, recover any overlay digis, to see if we have anything to do
-    SmartDataPtr<Event::CalOverlayCol> overlayCol(m_dataSvc, m_dataSvc->rootName() + OverlayEventModel::Overlay::CalOverlayCol);
-    if(!overlayCol) return StatusCode::SUCCESS;
+    // First, recover the overlay event, to see if we have anything to do
+    const OverlayEventView* overlayView = m_overlaySvc->getOverlayEventView();
+    if(!overlayView) return StatusCode::SUCCESS;
 
     // Now recover the McIntegratingHits for this event
     SmartDataPtr<Event::McIntegratingHitCol> calMcHitCol(eventSvc(), EventModel::MC::McIntegratingHitCol);
@@ -188,285 +431,297 @@ StatusCode CalOverlayMergeAlg::execute()
         }
     }
 
-    // Create a map of the simulation McIntegratingHits, indexing by identifier
-    std::map<idents::VolumeIdentifier, Event::McIntegratingHit*> idToMcHitMap;
-
+    // Index the simulation McIntegratingHits by crystal segment slot
     for(Event::McIntegratingHitCol::iterator calIter = calMcHitCol->begin(); calIter != calMcHitCol->end(); calIter++)
     {
         Event::McIntegratingHit*calMcHit = *calIter;
 
-        // Add this McIntegratingHit to our map
-        idToMcHitMap[calMcHit->volumeID()] = calMcHit;
+        int slot = volIdSlot(calMcHit->volumeID());
+
+        if (slot < 0) continue;
+
+        if (!m_slotMcHits[slot]) m_usedSlots.push_back(slot);
+
+        m_slotMcHits[slot] = calMcHit;
     }
 
     // All "particles" we add will be of type "overlay"
     Event::McIntegratingHit::Particle particle = Event::McIntegratingHit::overlay;
 
-    // Propagator needs a direction, choose "up"
-    Vector direction(0.,0.,-1.);
+    m_diodeLight.clear();
+    m_deposits.clear();
+    m_hitDeposits.clear();
+    m_hitCentres.clear();
 
-    // Loop through the input CalOverlays and using the above map merge with existing McIntegratingHits
-    for(Event::CalOverlayCol::iterator overIter  = overlayCol->begin(); overIter != overlayCol->end(); overIter++)
+    // Loop through the rows of input CalOverlays and using the above table merge with existing McIntegratingHits
+    for(unsigned int row = 0; row < overlayView->numCal(); row++)
     {
-        Event::CalOverlay* calOverlay = *overIter;
-
-        // Use the propagator to get a valid VolumeIdentifier at the resolution of the McIntegratingHits
-        m_propagator->setStepStart(calOverlay->getPosition(), direction);
-        idents::VolumeIdentifier overId  = m_propagator->getVolumeId(0);
+        Point  position(overlayView->calPosX[row], overlayView->calPosY[row], overlayView->calPosZ[row]);
+        double energy = overlayView->calEnergy[row];
 
-        // Is this a crystal or a diode?
-        int volType = (int)overId[CalUtil::fCellCmp];
+        // The crystal is that of the CalOverlay, find its geometry in the table
+        int tower  = overlayView->calTower[row];
+        int layer  = overlayView->calLayer[row];
+        int column = overlayView->calColumn[row];
 
-        if (volType != 0)
+        if (tower  < 0 || tower  >= NumTowers || layer < 0 || layer >= NumLayers || column < 0 || column >= NumColumns ||
+            !m_xtalGeometry[xtalIndex(tower, layer, column)].centreValid)
         {
-            // Attempt to "tweak" the volume identifer to nudge over to a crystal
-            idents::VolumeIdentifier newIdent;
+            log << MSG::INFO << "Couldn't retrieve the transform for this xtal segment id" << endreq;
+            break;
+        }
 
-            // Loop through and copy the current fields we want
-            for (int identIdx = 0; identIdx < CalUtil::fCellCmp; identIdx++) 
-            {
-                newIdent.append(overId[identIdx]);
-            }
+        const XtalGeometry& xtalGeom = m_xtalGeometry[xtalIndex(tower, layer, column)];
 
-            // Now append the fields we need for a crystal
-            newIdent.append(0);                          // for xtal component
-            if ((volType ==2) || (volType ==4))          // + end
-            {  
-                newIdent.append(11);                     // max segment number
-            } 
-            else newIdent.append(0);                     // - end
+        HepPoint3D globalHit = position;
+        HepPoint3D centreHit = xtalGeom.centreInverse * globalHit;
 
-            // Now change the old id to the new one
-            overId.init(newIdent.getValue(), newIdent.size());
-        }
+        // The segment is the one nearest the hit along the crystal, a hit beyond an end (on a diode) 
+        // goes to the end segment, giving a VolumeIdentifier at the resolution of the McIntegratingHits
+        int segment = xtalGeom.segmentAt(centreHit.x());
+        int slot    = segmentSlot(xtalIndex(tower, layer, column), segment);
 
-        // Get a CalXtalId from this
-        idents::CalXtalId calXtalId(overId);
+        idents::VolumeIdentifier overId = xtalGeom.xtalId;
+        overId.append(segment);
 
-        // Work out the transform for this volume
-        StatusCode sc;
-        HepGeom::Transform3D xtalTransform;
-        if((sc = m_detSvc->getTransform3DByID(overId,&xtalTransform)).isFailure())
+        if (m_validateVolIds)
         {
-            log << MSG::INFO << "Couldn't retrieve the transform for this xtal segment id" << endreq;
-            return StatusCode::SUCCESS;
+            idents::VolumeIdentifier propId = propagatorVolId(position);
+
+            m_numVolIdChecked++;
+
+            if (!(propId == overId))
+            {
+                m_numVolIdMismatch++;
+                log << MSG::DEBUG << "Segment id " << overId.name() << " differs from propagator id " << propId.name() << endreq;
+            }
         }
 
-        HepPoint3D globalHit = calOverlay->getPosition();
-        HepPoint3D localHit  = xtalTransform.inverse() * globalHit;
+        HepPoint3D localHit = xtalGeom.segmentInverse[segment] * globalHit;
 
-        // Check that this is a valid CalXtalId
-        idents::CalXtalId checkId(overId);
+        // A new deposit, unless this segment has one and they are being summed
+        int depositIdx = m_aggregateDeposits ? m_slotDeposits[slot] : -1;
 
-        // Does the identifier for this CalOverlay match an McIntegratingHit in the sim map?
-        std::map<idents::VolumeIdentifier,Event::McIntegratingHit*>::iterator calIter = idToMcHitMap.find(overId);
+        if (depositIdx < 0)
+        {
+            SegmentDeposit deposit;
 
-		// If not a pure overlay McIntegratingHit then set iterator to end
-		// This will insure that the overlay information in the McIntegratingHit collection in the TDS is 
-		// included in a unique (to the simulated hits) McIntegratingHit object
-        if (calIter != idToMcHitMap.end() && (calIter->second)->getPackedFlags() != Event::McIntegratingHit::overlayHit) 
-			calIter = idToMcHitMap.end();
+            deposit.mcHit     = findMcHit(slot, overId, calMcHitCol);
+            deposit.xtalGeom  = &xtalGeom;
+            deposit.numHits   = 0;
+            deposit.energy    = 0.;
+            deposit.localHit  = localHit;
+            deposit.centreHit = centreHit;
 
-        // Pointer to the mcHit
-        Event::McIntegratingHit* mcHit = 0;
+            for(int idx = 0; idx < 3; idx++) deposit.energyMoment[idx] = 0.;
 
-        // If no match then we need to create a new McIntegratingHit and add to the collection
-        if (calIter == idToMcHitMap.end())
-        {
-            mcHit = new Event::McIntegratingHit();
+            for(int diode = 0; diode < CalDiodeLightKernel::NumDiodes; diode++)
+            {
+                deposit.diodeTotal[diode]  = 0.;
+                deposit.diodeDirect[diode] = 0.;
 
-            mcHit->setVolumeID(overId);
-            mcHit->setPackedFlags(Event::McIntegratingHit::overlayHit);
-            mcHit->addEnergyItem(calOverlay->getEnergy(), particle, localHit);
+                for(int idx = 0; idx < 3; idx++) deposit.diodeMoment[diode][idx] = 0.;
+            }
 
-            calMcHitCol->push_back(mcHit);
-        }
-        // Otherwise, a match so we just merge it into the existing McIntegratingHit
-        else
-        {
-            mcHit = calIter->second;
+            depositIdx = m_deposits.size();
 
-            mcHit->addPackedMask(Event::McIntegratingHit::overlayHit);
-            mcHit->addEnergyItem(calOverlay->getEnergy(), particle, localHit);
+            m_deposits.push_back(deposit);
+
+            if (m_aggregateDeposits)
+            {
+                m_slotDeposits[slot] = depositIdx;
+                m_usedSlots.push_back(slot);
+            }
         }
 
+        SegmentDeposit& deposit = m_deposits[depositIdx];
+
+        deposit.numHits++;
+        deposit.energy          += energy;
+        deposit.energyMoment[0] += energy * localHit.x();
+        deposit.energyMoment[1] += energy * localHit.y();
+        deposit.energyMoment[2] += energy * localHit.z();
+
         // *************************************************************************
         // The section below added to include the light seen by the diodes. It is 
         // meant to emulate the same code in G4Generator's IntDetectorManager class
         // *************************************************************************
 
-        // The first task we work at is to get a transformation from global to local
-        // coordinates for the volume containing the individual crystal segments
-        // Create a volume identifier for the containing low segment of the crystal
-        idents::VolumeIdentifier xtalIdLow;
+        // The light seen is computed for all the hits at once below, using the hit position in
+        // the volume containing the individual crystal segments (the table holds the transform 
+        // to it and the diode positions for every crystal)
+        m_diodeLight.addHit(globalHit.x(), globalHit.y(), globalHit.z(), centreHit.x(), centreHit.y(), energy, &xtalGeom.diodes);
 
-        // Create the log part of the identifier
-        for(int idx = 0; idx <= CalUtil::fCellCmp; idx++)
-        {
-            xtalIdLow.append(overId[idx]);
-        }
+        m_hitDeposits.push_back(depositIdx);
+        m_hitCentres.push_back(centreHit);
+    }
 
-        // This will be the high end
-        idents::VolumeIdentifier xtalIdHi = xtalIdLow;
+    // We need to determine the fraction of light seen by each of the diodes
+    // We do this using the same approach done in the simulation 
+    // (see IntDetectorManager in G4Generator), for all hits x 4 diodes in one go
+    m_diodeLight.run();
 
-        xtalIdLow.append(0);
-        xtalIdHi.append(11);
+    for(unsigned int hit = 0; hit < m_hitDeposits.size(); hit++)
+    {
+        SegmentDeposit&   deposit   = m_deposits[m_hitDeposits[hit]];
+        const HepPoint3D& centreHit = m_hitCentres[hit];
 
-        // Use these to determine the offset of the center of the crystal
-        HepGeom::Transform3D xtalLowTransform;
-        if((sc = m_detSvc->getTransform3DByID(xtalIdLow,&xtalLowTransform)).isFailure())
+        for(int diode = 0; diode < CalDiodeLightKernel::NumDiodes; diode++)
         {
-            log << MSG::INFO << "Couldn't retrieve the transform for this xtal id." << endreq;
-            return StatusCode::SUCCESS;
-        }
+            double totalDepE = m_diodeLight.totalDepE(hit, diode);
 
-        HepGeom::Transform3D xtalHiTransform;
-        if((sc = m_detSvc->getTransform3DByID(xtalIdHi,&xtalHiTransform)).isFailure())
-        {
-            log << MSG::INFO << "Couldn't retrieve the transform for this xtal id." << endreq;
-            return StatusCode::SUCCESS;
+            deposit.diodeTotal[diode]     += totalDepE;
+            deposit.diodeDirect[diode]    += m_diodeLight.directDepE(hit, diode);
+            deposit.diodeMoment[diode][0] += totalDepE * centreHit.x();
+            deposit.diodeMoment[diode][1] += totalDepE * centreHit.y();
+            deposit.diodeMoment[diode][2] += totalDepE * centreHit.z();
         }
+    }
 
-        // We need to make a new translation vector, use the coordinates returned above
-        // It is done this way to automatically insure that we get the right value for the 
-        // translation without having to worry if this is an x or y measuring crystal
-        // If both are same, average returns same value, if both are different we get the 
-        // average between the two
-        CLHEP::Hep3Vector xtalTrans(0.5*(xtalHiTransform.dx()+xtalLowTransform.dx()), 
-                             0.5*(xtalHiTransform.dy()+xtalLowTransform.dy()),
-                             xtalHiTransform.dz());
-
-        // The transformation to the center of the enclosing crystal
-        xtalTransform = HepGeom::Transform3D(xtalHiTransform.getRotation(), xtalTrans);
-
-        // And reset the local position to this encosing volume
-        localHit = xtalTransform.inverse() * globalHit;
-
-        // We need to determine the fraction of light seen by each of the diodes
-        // We do this using the same approach done in the simulation 
-        // (see IntDetectorManager in G4Generator)
-        // Start by looping over the diodes (order is small Neg, small Pos, large Neg, large Pos)
-        for(int diodeIdx = 1; diodeIdx < 5; diodeIdx++)
-        {
-            // Create a volume identifier for this diode. 
-            // Apparently we cannot modify the fields so we must create a new one
-            // each time through this loop
-            idents::VolumeIdentifier diodeId;
-
-            // Create the log part of the identifier
-            for(int idx = 0; idx < CalUtil::fCellCmp; idx++)
-            {
-                diodeId.append(overId[idx]);
-            }
+    // Now fill the McIntegratingHits, one energy item per deposit
+    for(std::vector<SegmentDeposit>::iterator depIter = m_deposits.begin(); depIter != m_deposits.end(); depIter++)
+    {
+        SegmentDeposit& deposit = *depIter;
 
-            // now make it a diode part
-            diodeId.append(diodeIdx);
+        deposit.mcHit->addEnergyItem(deposit.energy, particle, 
+                                     depositPosition(deposit.numHits, deposit.localHit, deposit.energyMoment, deposit.energy));
 
-            // Look up the transform, this will give the position of the center
-            // of the diode and its rotation
-            HepGeom::Transform3D trnsDiode;
-            if((sc = m_detSvc->getTransform3DByID(diodeId,&trnsDiode)).isFailure())
+        // Loop over the diodes (order is small Neg, small Pos, large Neg, large Pos)
+        for(int diode = 0; diode < CalDiodeLightKernel::NumDiodes; diode++)
+        {
+            if (!deposit.xtalGeom->diodeValid[diode])
             {
                 log << MSG::INFO << "Could not retrieve diode transform" << endreq;
                 continue;
             }
 
-            // We need to get the normal vector pointing from the diode into the xtal
-            // We can get that by checking if the crystal measures x or y, and
-            // checking to see if the diode is on the plus or negative side
-            // Assume a normal in plus y
-            CLHEP::Hep3Vector diodeNrml(0., 1., 0.);
+            // Retrieve reference to object to fill for this diode
+            Event::McIntegratingHit::XtalEnergyDep& xtalDep = deposit.mcHit->getXtalEnergyDep(m_diodeNames[diode]);
 
-            // Get both the distance from the center of the current xtal segment to the diode
-            // And reset the diodeNrml if we are oriented along x
-            double longDistToDiode = xtalTransform.dy() - trnsDiode.dy();
+            xtalDep.addEnergyItem(deposit.diodeTotal[diode], deposit.diodeDirect[diode], 
+                                  depositPosition(deposit.numHits, deposit.centreHit, deposit.diodeMoment[diode], deposit.diodeTotal[diode]));
+        }
+    }
 
-            if (calXtalId.isX()) 
-            {
-                longDistToDiode = xtalTransform.dx() - trnsDiode.dx();
-                diodeNrml       = CLHEP::Hep3Vector(1., 0., 0.);
-            }
+    // Leave the tables empty for the next event
+    for(std::vector<int>::iterator slotIter = m_usedSlots.begin(); slotIter != m_usedSlots.end(); slotIter++)
+    {
+        m_slotMcHits[*slotIter]   = 0;
+        m_slotDeposits[*slotIter] = -1;
+    }
+
+    m_usedSlots.clear();
+
+    return StatusCode::SUCCESS;
+}
 
-            if (longDistToDiode < 0.) diodeNrml *= -1.;
+int CalOverlayMergeAlg::volIdSlot(const idents::VolumeIdentifier& volId) const
+{
+    // A crystal segment has all the fields down to the segment, and is a crystal (not a diode)
+    if (volId.size() != (unsigned int)CalUtil::fSegment + 1 || volId[CalUtil::fCellCmp] != 0) return -1;
 
-            // Get the dimensions of the face of the diode we are dealing with
-            double diodeFaceAlpha = 2. * m_diodeHeights[diodeIdx-1];
-            double diodeFaceBeta  = 2. * m_diodeWidth;
+    int towerX  = volId[CalUtil::fTowerX];
+    int towerY  = volId[CalUtil::fTowerY];
+    int layer   = volId[CalUtil::fLayer];
+    int column  = volId[CalUtil::fCALXtal];
+    int segment = volId[CalUtil::fSegment];
 
-            // Get the vector from the center of the diode to the current energy deposition point
-            CLHEP::Hep3Vector lineToCenter = globalHit - trnsDiode.getTranslation();
-            double     distToCenter = lineToCenter.mag();
+    if (towerX >= 4 || towerY >= 4 || layer >= NumLayers || column >= NumColumns || segment >= NumSegments) return -1;
 
-            // Now want the angle between this line and the diode normal
-            double cosTheta = lineToCenter.unit().dot(diodeNrml);
+    int xtal = xtalIndex(idents::TowerId(towerX, towerY).id(), layer, column);
 
-            if (cosTheta < 0.)
-            {
-                cosTheta *= -1.;
-            }
+    // The other fields must be those of the Cal too
+    idents::VolumeIdentifier slotId = m_xtalGeometry[xtal].xtalId;
+    slotId.append(segment);
 
-            // Projected area of rectangle is diodeFaceArea * cosTheta, which can also be 
-            // written as diodeFaceAlpha * diodeFaceBeta * cosTheta, so we scale diodeFaceBeta
-            // by cosTheta for what follows
-            double diodeFaceBetaPr = diodeFaceBeta * cosTheta;
-
-            // Determine fractional solid angle subtended. For this problem, this is the solid
-            // angle subtended by a pyramid.
-            double radical   = (4.*distToCenter*distToCenter + diodeFaceAlpha*diodeFaceAlpha)
-                             * (4.*distToCenter*distToCenter + diodeFaceBetaPr*diodeFaceBetaPr);
-            double aSinArg   = diodeFaceAlpha * diodeFaceBetaPr / sqrt(radical);
-            double fracAngle = asin(aSinArg) / M_PI;
-                    
-            CLHEP::Hep3Vector stepPos    = localHit;
-            double     directFrac = 0.;
-            double     totalDep   = 0.;
-
-            // Does angle to surface normal put us in the range of surface reflection? 
-            if (distToCenter < 30.) 
-            {
-				// The following is based on patterns extracted from flight data
-			    double dist2Side = std::max(0., 13.5 -fabs(stepPos.y()));
-				double dist2End  = std::max(0., 165.-fabs(stepPos.x()));
+    if (!(slotId == volId)) return -1;
 
-				// No angle factor for direct light - probably due to end roughening...
-					directFrac += fracAngle;
+    return segmentSlot(xtal, segment);
+}
 
-				// Total light attenuation governed by location - strong dependence side to side, 
-				// as well as dependencce with distance from end
-				if(dist2End < 30) 
-                {
-					double attenFactor = ((30. - dist2End) * (std::max(0., 13.5-dist2Side)))/ (30.*13.5);
-					totalDep += 1. - .33*attenFactor * attenFactor;
-				}
-				else 
-                {
-					totalDep   += 1.;
-					directFrac += fracAngle;
-				}
-            }
-            // Otherwise, all light "seen" by diode and all energy deposited in crystal
-            else
-            {
-                directFrac += fracAngle;
-                totalDep   += 1.;
-            }
+Event::McIntegratingHit* CalOverlayMergeAlg::findMcHit(int slot, const idents::VolumeIdentifier& overId, Event::McIntegratingHitCol* calMcHitCol)
+{
+    // Does the identifier for this CalOverlay match an McIntegratingHit in the sim table?
+    Event::McIntegratingHit* mcHit = m_slotMcHits[slot];
 
-            // Now get the direct and total energy fractions
-            double directDepE = calOverlay->getEnergy() * directFrac;
-            double totalDepE  = calOverlay->getEnergy() * totalDep;
+    // If not a pure overlay McIntegratingHit then forget it
+    // This will insure that the overlay information in the McIntegratingHit collection in the TDS is 
+    // included in a unique (to the simulated hits) McIntegratingHit object
+    if (mcHit && mcHit->getPackedFlags() != Event::McIntegratingHit::overlayHit) mcHit = 0;
 
-            // Retrieve reference to object to fill for this diode
-            Event::McIntegratingHit::XtalEnergyDep& xtalDep = mcHit->getXtalEnergyDep(m_diodeNames[diodeIdx-1]);
+    // If no match then we need to create a new McIntegratingHit and add to the collection
+    if (!mcHit)
+    {
+        mcHit = new Event::McIntegratingHit();
 
-            xtalDep.addEnergyItem(totalDepE, directDepE, localHit);
+        mcHit->setVolumeID(overId);
+        mcHit->setPackedFlags(Event::McIntegratingHit::overlayHit);
 
-            int stop = 0;
-        }
+        calMcHitCol->push_back(mcHit);
+    }
+    // Otherwise, a match so we just merge it into the existing McIntegratingHit
+    else mcHit->addPackedMask(Event::McIntegratingHit::overlayHit);
+
+    return mcHit;
+}
+
+HepPoint3D CalOverlayMergeAlg::depositPosition(int numHits, const HepPoint3D& first, const double* moment, double weight)
+{
+    if (numHits == 1 || weight == 0.) return first;
+
+    return HepPoint3D(moment[0] / weight, moment[1] / weight, moment[2] / weight);
+}
+
+StatusCode CalOverlayMergeAlg::finalize()
+{
+    if (m_validateVolIds)
+    {
+        MsgStream log(msgSvc(), name());
+
+        log << MSG::INFO << "Segment ids checked against the propagator: " << m_numVolIdChecked 
+            << ", differing: " << m_numVolIdMismatch << endreq;
     }
 
     return StatusCode::SUCCESS;
 }
 
+idents::VolumeIdentifier CalOverlayMergeAlg::propagatorVolId(const Point& position)
+{
+    // Propagator needs a direction, choose "up"
+    Vector direction(0.,0.,-1.);
+
+    m_propagator->setStepStart(position, direction);
+    idents::VolumeIdentifier overId  = m_propagator->getVolumeId(0);
+
+    // Is this a crystal or a diode?
+    int volType = (int)overId[CalUtil::fCellCmp];
+
+    if (volType != 0)
+    {
+        // Attempt to "tweak" the volume identifer to nudge over to a crystal
+        idents::VolumeIdentifier newIdent;
+
+        // Loop through and copy the current fields we want
+        for (int identIdx = 0; identIdx < CalUtil::fCellCmp; identIdx++) 
+        {
+            newIdent.append(overId[identIdx]);
+        }
+
+        // Now append the fields we need for a crystal
+        newIdent.append(0);                          // for xtal component
+        if ((volType ==2) || (volType ==4))          // + end
+        {  
+            newIdent.append(11);                     // max segment number
+        } 
+        else newIdent.append(0);                     // - end
+
+        // Now change the old id to the new one
+        overId.init(newIdent.getValue(), newIdent.size());
+    }
+
+    return overId;
+}
+
 idents::VolumeIdentifier CalOverlayMergeAlg::makeVolId(idents::CalXtalId calXtalId)
 {
     // Snippet of code fror Leon Rochester for converting a CalXtalId into
@@ -23,6 +23,9 @@
 
 #include "Event/Recon/TkrRecon/TkrDiagnosticFlag.h"
 
+#include "../DataServices/OverlayArena.h"
+#include "../DataServices/OverlayTdsHandle.h"
+
 #include <map>
 
 class DiagDataOverlayMergeAlg : public Algorithm 
@@ -35,8 +38,8 @@ class DiagDataOverlayMergeAlg : public Algorithm
     StatusCode finalize();
 
  private:
-    /// Pointer to the overlay's data provider service
-    DataSvc*         m_dataSvc;
+    /// Handle to the DiagDataOverlay in the overlay's data provider service
+    OverlayTdsHandle<Event::DiagDataOverlay> m_diagDataOverlay;
 
     /// Type of tool to run
     std::string m_type;
@@ -91,14 +94,18 @@ StatusCode DiagDataOverlayMergeAlg::initialize()
         return sc;
     }
 
-    // Caste back to the "correct" pointer
-    m_dataSvc = dynamic_cast<DataSvc*>(dataSvc);
+    // Resolve the overlay objects we use once, here
+    if ((sc = m_diagDataOverlay.initialize(dataSvc, OverlayEventModel::Overlay::DiagDataOverlay)).isFailure()) {
+        log << MSG::ERROR << "  " << dataSvcName << " is not an overlay data service " << endreq;
+        return sc;
+    }
 
     return sc;
 }
 
 typedef std::pair<unsigned, unsigned>   DiagKeyPair;
-typedef std::map<DiagKeyPair, unsigned> OverDiagMap;
+typedef std::map<DiagKeyPair, unsigned, std::less<DiagKeyPair>, 
+                 OverlayArenaAllocator<std::pair<const DiagKeyPair, unsigned> > > OverDiagMap;
 
 StatusCode DiagDataOverlayMergeAlg::execute() 
 {
@@ -122,7 +129,7 @@ StatusCode DiagDataOverlayMergeAlg::execute()
     log << MSG::DEBUG << "execute" << endreq;
 
     // First, recover any overlay diagnostic data, to see if we have anything to do
-    SmartDataPtr<Event::DiagDataOverlay> diagDataOverlay(m_dataSvc, m_dataSvc->rootName() + OverlayEventModel::Overlay::DiagDataOverlay);
+    Event::DiagDataOverlay* diagDataOverlay = m_diagDataOverlay.get();
     if(!diagDataOverlay) return sc;
 
     // Successful recovery of an overlay TDS object! 
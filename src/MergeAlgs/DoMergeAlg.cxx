@@ -26,7 +26,10 @@
 
 #include "Overlay/IOverlayDataSvc.h"
 
+#include "../DataServices/OverlayTdsHandle.h"
+
 #include <map>
+#include <vector>
 
 class DoMergeAlg : public Algorithm 
 {
@@ -44,6 +47,13 @@ private:
 
     IOverlayDataSvc* m_dataSvc;
 
+    /// Handle to the EventOverlay at the root of the overlay section
+    OverlayTdsHandle<Event::EventOverlay> m_overHeader;
+
+    /// Overlay data services whose reads should be started (concurrently) by this algorithm
+    std::vector<std::string>      m_prefetchSvcNames;
+    std::vector<IOverlayDataSvc*> m_prefetchSvcs;
+
 };
 
 // Used by Gaudi for identifying this algorithm
@@ -56,6 +66,9 @@ DoMergeAlg::DoMergeAlg(const std::string& name, ISvcLocator* pSvcLocator)
 {
     // variable to bypass if not wanted
     declareProperty("MergeAll", m_mergeAll = false);
+
+    // Data services to start reading before this one is used, typically set for the first DoMergeAlg
+    declareProperty("PrefetchServices", m_prefetchSvcNames);
 }
 
 
@@ -97,6 +110,31 @@ StatusCode DoMergeAlg::initialize()
     // Caste back to the "correct" pointer
     m_dataSvc = dynamic_cast<IOverlayDataSvc*>(dataSvc);
 
+    if ((sc = m_overHeader.initialize(dataSvc, "")).isFailure()) {
+        log << MSG::ERROR << "  " << dataSvcName << " is not an overlay data service " << endreq;
+        return sc;
+    }
+
+    // Look up the services we are to start reading for
+    for(std::vector<std::string>::iterator nameItr = m_prefetchSvcNames.begin(); nameItr != m_prefetchSvcNames.end(); nameItr++)
+    {
+        IService* prefetchSvc = 0;
+        sc = service(*nameItr, prefetchSvc);
+        if (sc.isFailure() ) {
+            log << MSG::ERROR << "  can't get " << *nameItr << endreq;
+            return sc;
+        }
+
+        IOverlayDataSvc* overlaySvc = dynamic_cast<IOverlayDataSvc*>(prefetchSvc);
+
+        if (!overlaySvc) {
+            log << MSG::ERROR << "  " << *nameItr << " is not an overlay data service " << endreq;
+            return StatusCode::FAILURE;
+        }
+
+        m_prefetchSvcs.push_back(overlaySvc);
+    }
+
     return sc;
 }
 
@@ -114,6 +152,16 @@ StatusCode DoMergeAlg::execute()
     MsgStream log(msgSvc(), name());
     log << MSG::DEBUG << "execute" << endreq;
 
+    // Start the reads for all inputs so they proceed concurrently, each is waited on when first used
+    for(std::vector<IOverlayDataSvc*>::iterator svcItr = m_prefetchSvcs.begin(); svcItr != m_prefetchSvcs.end(); svcItr++)
+    {
+        if ((*svcItr)->prefetchEvent().isFailure())
+        {
+            log << MSG::ERROR << "Failed to start reading overlay input" << endreq;
+            return StatusCode::FAILURE;
+        }
+    }
+
     // Since our overlay stuff is not stored in the /Event section of the TDS, we need 
     // to explicitly "set the root" each event - or risk it not getting cleared. 
     sc = setRootEvent();
@@ -161,6 +209,10 @@ StatusCode DoMergeAlg::setRootEvent()
 {
     StatusCode sc = StatusCode::SUCCESS;
 
+    // If the data service reuses the section built in an earlier event (ReuseOverlayTree) it has 
+    // refilled it in place from the new input event and there is nothing more to do
+    if (m_dataSvc->refillOverlayTree().isSuccess()) return sc;
+
     // Set up the root event object
     Event::EventOverlay overObj;
 
@@ -172,11 +224,10 @@ StatusCode DoMergeAlg::setRootEvent()
                                                      overObj.clID(),
                                                      dataProviderSvc->rootName());
 
-    sc = dataProviderSvc->setRoot(dataProviderSvc->rootName(), refpAddress);
+    sc = dataProviderSvc->setRoot(m_overHeader.path(), refpAddress);
 
     // This is the magic incantation to trigger the building of the directory tree...
-    SmartDataPtr<Event::EventOverlay> overHeader(dataProviderSvc, dataProviderSvc->rootName());
-    if (!overHeader) sc = StatusCode::FAILURE;
+    if (!m_overHeader.get()) sc = StatusCode::FAILURE;
 
     return sc;
 }
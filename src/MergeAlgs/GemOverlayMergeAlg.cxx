@@ -20,6 +20,8 @@
 #include "OverlayEvent/OverlayEventModel.h"
 #include "OverlayEvent/GemOverlay.h"
 
+#include "../DataServices/OverlayTdsHandle.h"
+
 #include "enums/TriggerBits.h"
 
 #include <map>
@@ -34,8 +36,8 @@ class GemOverlayMergeAlg : public Algorithm
     StatusCode finalize();
 
  private:
-    /// Pointer to the overlay's data provider service
-    DataSvc*         m_dataSvc;
+    /// Handle to the GemOverlay in the overlay's data provider service
+    OverlayTdsHandle<Event::GemOverlay> m_gemOverlay;
     
     /// Type of tool to run
     std::string m_type;
@@ -90,8 +92,11 @@ StatusCode GemOverlayMergeAlg::initialize()
         return sc;
     }
 
-    // Caste back to the "correct" pointer
-    m_dataSvc = dynamic_cast<DataSvc*>(dataSvc);
+    // Resolve the overlay objects we use once, here
+    if ((sc = m_gemOverlay.initialize(dataSvc, OverlayEventModel::Overlay::GemOverlay)).isFailure()) {
+        log << MSG::ERROR << "  " << dataSvcName << " is not an overlay data service " << endreq;
+        return sc;
+    }
 
     return sc;
 }
@@ -111,7 +116,7 @@ StatusCode GemOverlayMergeAlg::execute()
     log << MSG::DEBUG << "execute" << endreq;
 
     // First, recover any overlay digis, to see if we have anything to do
-    SmartDataPtr<Event::GemOverlay> gemOverlay(m_dataSvc, m_dataSvc->rootName() + OverlayEventModel::Overlay::GemOverlay);
+    Event::GemOverlay* gemOverlay = m_gemOverlay.get();
     if(!gemOverlay) return sc;
 
     // Now recover the TriggerInfo for this event
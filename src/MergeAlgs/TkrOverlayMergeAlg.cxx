@@ -14,6 +14,7 @@
 #include "GaudiKernel/AlgFactory.h"
 #include "GaudiKernel/SmartDataPtr.h"
 #include "GaudiKernel/DataSvc.h"
+#include "GaudiKernel/IDataProviderSvc.h"
 
 #include "Event/TopLevel/EventModel.h"
 #include "Event/Digi/TkrDigi.h"
@@ -21,12 +22,28 @@
 #include "OverlayEvent/OverlayEventModel.h"
 #include "OverlayEvent/TkrOverlay.h"
 #include "OverlayEvent/GemOverlay.h"
+#include "Overlay/IOverlayDataSvc.h"
+#include "Overlay/OverlayReadCuts.h"
+#include "Overlay/OverlayEventView.h"
 
 #include "TkrUtil/ITkrGeometrySvc.h"
 #include "TkrUtil/ITkrMakeClustersTool.h"
 #include "TkrUtil/ITkrGhostTool.h"
 
-#include <map>
+#include "CalibData/CalibModel.h"
+#include "CalibData/Tkr/TkrSplitsCalib.h"
+
+#include "TkrStripBitmap.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+/// Orders digis the opposite way to TkrDigi::digiLess, for finding a pair out of order
+struct digiGreater
+{
+    bool operator()(Event::TkrDigi* left, Event::TkrDigi* right) const {return Event::TkrDigi::digiLess()(right, left);}
+};
 
 class TkrOverlayMergeAlg : public Algorithm 
 {
@@ -38,11 +55,48 @@ class TkrOverlayMergeAlg : public Algorithm
     StatusCode finalize();
 
  private:
-    /// Local method to copy information 
-    Event::TkrDigi* copyTkrOverlay(Event::TkrOverlay* TkrOverlay);
+    /// Tracker planes are indexed by tower, bilayer and view
+    enum {NumTowers = 16, NumBilayers = 18, NumViews = 2, NumPlanes = NumTowers * NumBilayers * NumViews};
+
+    static int planeIndex(int tower, int bilayer, int view) {return (tower * NumBilayers + bilayer) * NumViews + view;}
+
+    static bool validPlane(int tower, int bilayer, int view)
+    {
+        return tower >= 0 && tower < NumTowers && bilayer >= 0 && bilayer < NumBilayers && view >= 0 && view < NumViews;
+    }
+
+    /// Below this many strips (simulated plus overlay) in a plane merging the lists beats the bitmap union
+    enum {MinBitmapStrips = 64};
+
+    /// Local method to copy information from a row of the overlay event view
+    Event::TkrDigi* copyTkrOverlay(const OverlayEventView& overlayView, unsigned int row);
+
+    /// Merge the overlay strips of a row of the overlay event view into a simulated digi
+    void mergeStrips(Event::TkrDigi* tkrDigi, const OverlayEventView& overlayView, unsigned int row, int breakPoint);
 
-    /// Pointer to the overlay's data provider service
-    DataSvc*         m_dataSvc;
+    /// Look up the split point of every plane
+    void fillSplitPoints();
+
+    /// Has the splits calibration changed since the split points were looked up?
+    bool splitsChanged();
+
+    /// The overlay's data provider service, its event view holds the TkrOverlay data
+    IOverlayDataSvc*      m_overlaySvc;
+
+    /// Split point of each plane. TkrSplitsSvc is only loaded (from the job options or from the 
+    /// calibration database) once the event loop starts, so the table is filled at the first event
+    /// and refilled whenever the serial number of the splits calibration changes
+    std::vector<int>      m_splitPoints;
+    bool                  m_splitsLoaded;
+
+    /// Flavor of the splits calibration ("ignore" if the splits are fixed by the job options, as 
+    /// for TkrCalibAlg), the calibration data service and the serial number the table was filled from
+    std::string           m_splitsFlavor;
+    IDataProviderSvc*     m_calibDataSvc;
+    int                   m_splitsSerNo;
+
+    /// The simulated digi of each plane in the current event, zero if none
+    std::vector<Event::TkrDigi*> m_digiSlots;
 
     /// Type of tool to run
     std::string           m_type;
@@ -64,10 +118,13 @@ DECLARE_ALGORITHM_FACTORY(TkrOverlayMergeAlg);
 
 TkrOverlayMergeAlg::TkrOverlayMergeAlg(const std::string& name,
                                          ISvcLocator* pSvcLocator)
-    : Algorithm(name, pSvcLocator) 
+    : Algorithm(name, pSvcLocator), m_overlaySvc(0), m_splitsLoaded(false), m_calibDataSvc(0), m_splitsSerNo(-1)
 {
     // variable to select the tool type
     declareProperty("Type", m_type="General");
+
+    // Should match TkrCalibAlg's splitsFlavor
+    declareProperty("SplitsFlavor", m_splitsFlavor="ignore");
 }
 
 
@@ -106,6 +163,27 @@ StatusCode TkrOverlayMergeAlg::initialize()
         return StatusCode::FAILURE;
     }
 
+    // The plane tables have a fixed size
+    if (m_tkrGeom->numXTowers() * m_tkrGeom->numYTowers() > NumTowers || m_tkrGeom->numLayers() > NumBilayers)
+    {
+        log << MSG::ERROR << "Tracker geometry has more towers or bilayers than the plane tables" << endreq;
+        return StatusCode::FAILURE;
+    }
+
+    // The split points are cached, their lookup is not cheap, but not before the first event
+    m_splitPoints.assign(NumPlanes, 0);
+    m_digiSlots.assign(NumPlanes, 0);
+
+    // With splits from the calibration database we watch for them changing
+    if (m_splitsFlavor != "ignore")
+    {
+        if (service("CalibDataSvc", m_calibDataSvc, true).isFailure())
+        {
+            log << MSG::ERROR << "Could not get CalibDataSvc for the " << m_splitsFlavor << " splits" << endreq;
+            return StatusCode::FAILURE;
+        }
+    }
+
     // Convention for multiple input overlay files is that there will be separate OverlayDataSvc's with 
     // names appended by "_xx", for example OverlayDataSvc_1 for the second input file. 
     // In order to ensure the data read in goes into a unique section of the TDS we need to modify the 
@@ -123,8 +201,17 @@ StatusCode TkrOverlayMergeAlg::initialize()
         return sc;
     }
 
-    // Caste back to the "correct" pointer
-    m_dataSvc = dynamic_cast<DataSvc*>(dataSvc);
+    // The TkrOverlay data are read from the service's event view
+    if (!(m_overlaySvc = dynamic_cast<IOverlayDataSvc*>(dataSvc))) {
+        log << MSG::ERROR << "  " << dataSvcName << " is not an overlay data service " << endreq;
+        return StatusCode::FAILURE;
+    }
+
+    // Tell the converters what we will use so nothing else is built
+    OverlayReadCuts readCuts;
+    readCuts.needSubsystem(OverlayReadCuts::Tkr);
+
+    m_overlaySvc->declareReadCuts(readCuts);
 
     m_ghostTool = 0;
     sc = toolSvc()->retrieveTool("TkrGhostTool",m_ghostTool) ;
@@ -159,9 +246,9 @@ StatusCode TkrOverlayMergeAlg::execute()
     MsgStream log(msgSvc(), name());
     log << MSG::DEBUG << "execute" << endreq;
 
-    // First, recover any overlay digis, to see if we have anything to do
-    SmartDataPtr<Event::TkrOverlayCol> overlayCol(m_dataSvc, m_dataSvc->rootName() + OverlayEventModel::Overlay::TkrOverlayCol);
-    if(!overlayCol) return StatusCode::SUCCESS;
+    // First, recover the overlay event, to see if we have anything to do
+    const OverlayEventView* overlayView = m_overlaySvc->getOverlayEventView();
+    if(!overlayView) return StatusCode::SUCCESS;
 
     // Now recover the digis for this event
     SmartDataPtr<Event::TkrDigiCol> tkrDigiCol(eventSvc(), EventModel::Digi::TkrDigiCol);
@@ -200,116 +287,190 @@ StatusCode TkrOverlayMergeAlg::execute()
     // store the result in the event
     gem->setTkrVector( tkrVector );
 */
-    // Create a map of the simulation digis, indexing by identifier
-    std::map<int, Event::TkrDigi*> idToDigiMap;
+    // The split points, once TkrSplitsSvc has its (current) splits
+    bool changed = splitsChanged();
+
+    if (!m_splitsLoaded || changed) 
+    {
+        fillSplitPoints();
+
+        log << MSG::DEBUG << "Split points looked up, splits serial number " << m_splitsSerNo << endreq;
+    }
+
+    // Index the simulation digis by plane
+    std::fill(m_digiSlots.begin(), m_digiSlots.end(), (Event::TkrDigi*)0);
 
     for(Event::TkrDigiCol::iterator tkrIter = tkrDigiCol->begin(); tkrIter != tkrDigiCol->end(); tkrIter++)
     {
         Event::TkrDigi* tkrDigi = *tkrIter;
-        int             digiId  = (*tkrDigi);
 
         // Should be done elsewhere...
         tkrDigi->addToStatus(Event::TkrDigi::DIGI_MC);
 
-        // Add this digi to our map
-        idToDigiMap[digiId] = tkrDigi;
+        int tower   = tkrDigi->getTower().id();
+        int bilayer = tkrDigi->getBilayer();
+        int view    = tkrDigi->getView();
+
+        // A digi outside the table is left as it is, nothing will be merged into it
+        if (!validPlane(tower, bilayer, view))
+        {
+            log << MSG::WARNING << "Simulated TkrDigi with tower " << tower << ", bilayer " << bilayer 
+                << ", view " << view << " out of range, not merged" << endreq;
+            continue;
+        }
+
+        // Add this digi to our table
+        m_digiSlots[planeIndex(tower, bilayer, view)] = tkrDigi;
     }
 
+    // Digis made from the overlay alone are added after the simulated ones
+    int numSimDigis = tkrDigiCol->size();
+
     // Now loop through the overlay digis to merge into our simulated ones
-    for(Event::TkrOverlayCol::iterator overIter = overlayCol->begin(); overIter != overlayCol->end(); overIter++)
+    for(unsigned int row = 0; row < overlayView->numTkr(); row++)
     {
-        Event::TkrOverlay* tkrOverlay = *overIter;
-        int                overId     = (*tkrOverlay);
+        idents::TowerId towerId(overlayView->tkrTowerX[row], overlayView->tkrTowerY[row]);
+        int             bilayer = overlayView->tkrBilayer[row];
+        int             view    = overlayView->tkrView[row];
 
-        std::map<int,Event::TkrDigi*>::iterator tkrIter = idToDigiMap.find(overId);
+        if (!validPlane(towerId.id(), bilayer, view))
+        {
+            log << MSG::WARNING << "Overlay Tkr row with tower " << towerId.id() << ", bilayer " << bilayer 
+                << ", view " << view << " out of range, skipped" << endreq;
+            continue;
+        }
+
+        int             plane   = planeIndex(towerId.id(), bilayer, view);
+
+        Event::TkrDigi* tkrDigi = m_digiSlots[plane];
 
         // If this digi is not already in the TkrDigiCol then no merging needed, just add it
-        if (tkrIter == idToDigiMap.end())
+        if (!tkrDigi)
         {
-            Event::TkrDigi* digi = copyTkrOverlay(tkrOverlay);
+            Event::TkrDigi* digi = copyTkrOverlay(*overlayView, row);
 
             tkrDigiCol->push_back(digi);
         }
         // Otherwise, we need to merge the digi
         else
         {
-            // Pointer to the TDS digi
-            Event::TkrDigi* tkrDigi = tkrIter->second;
+            mergeStrips(tkrDigi, *overlayView, row, m_splitPoints[plane]);
+        }
+    }
+
+    // Both the simulated digis and those added are normally already sorted by volume id, in which case 
+    // merging them is enough, otherwise sort the lot
+    Event::TkrDigiCol::iterator simEnd = tkrDigiCol->begin() + numSimDigis;
+
+    if (std::adjacent_find(tkrDigiCol->begin(), simEnd,            digiGreater()) == simEnd &&
+        std::adjacent_find(simEnd,              tkrDigiCol->end(), digiGreater()) == tkrDigiCol->end())
+    {
+        std::inplace_merge(tkrDigiCol->begin(), simEnd, tkrDigiCol->end(), Event::TkrDigi::digiLess());
+    }
+    else std::sort(tkrDigiCol->begin(), tkrDigiCol->end(), Event::TkrDigi::digiLess());
+
+    return sc;
+}
+
+void TkrOverlayMergeAlg::mergeStrips(Event::TkrDigi* tkrDigi, const OverlayEventView& overlayView, unsigned int row, int breakPoint)
+{
+    int lastStrip0 = tkrDigi->getLastController0Strip();
+
+    // Recover the ToT (note that "addHit" will take care of ToT for us)
+    int tot0 = tkrDigi->getToT(0) > overlayView.tkrToT0[row] ? tkrDigi->getToT(0) : overlayView.tkrToT0[row];
+    int tot1 = tkrDigi->getToT(1) > overlayView.tkrToT1[row] ? tkrDigi->getToT(1) : overlayView.tkrToT1[row];
+
+    std::vector<unsigned short>::const_iterator overBegin = overlayView.tkrStrips.begin() + overlayView.tkrStripOffset[row];
+    std::vector<unsigned short>::const_iterator overEnd   = overlayView.tkrStrips.begin() + overlayView.tkrStripOffset[row+1];
+
+    bool merged = false;
+
+    // Busy plane: mark both sets of strips in bitmaps, the union and the controller 0 split are then word wide operations
+    if (tkrDigi->size() + (overEnd - overBegin) >= MinBitmapStrips)
+    {
+        TkrStripBitmap simStrips;
+        TkrStripBitmap overStrips;
+
+        if (simStrips.set(tkrDigi->begin(), tkrDigi->end()) && overStrips.set(overBegin, overEnd))
+        {
+            // Check the last strip stuff, the highest overlay strip below the break point
+            int overLastStrip0 = overStrips.highestBelow(breakPoint);
 
-            // Retrieve tower, bilayer and view information
-            idents::TowerId         towerId = tkrOverlay->getTower();
-            int                     biLayer = tkrOverlay->getBilayer();
-            idents::GlastAxis::axis view    = tkrOverlay->getView();
+            if (overLastStrip0 > lastStrip0) lastStrip0 = overLastStrip0;
 
-            // Get the break point for this tower, bi-layer and view
-            int breakPoint = m_tspSvc->getSplitPoint(towerId.id(), biLayer, view);
-            int lastStrip0 = tkrDigi->getLastController0Strip();
+            // The merged strips, in order and each once
+            simStrips |= overStrips;
 
-            // Recover the ToT (note that "addHit" will take care of ToT for us)
-            int tot0 = tkrDigi->getToT(0) > tkrOverlay->getToT(0) ? tkrDigi->getToT(0) : tkrOverlay->getToT(0);
-            int tot1 = tkrDigi->getToT(1) > tkrOverlay->getToT(1) ? tkrDigi->getToT(1) : tkrOverlay->getToT(1);
+            tkrDigi->resize(simStrips.count());
+            simStrips.strips(tkrDigi->begin());
 
-            // Merge hit strips, loop over hits in the overlay digi
-            for(std::vector<int>::const_iterator overStripIter = tkrOverlay->begin(); overStripIter != tkrOverlay->end(); overStripIter++)
-            {
-                int overStripId = *overStripIter;
+            merged = true;
+        }
+    }
+
+    // Quiet plane (or a strip number outside the plane), merge the two lists instead
+    if (!merged)
+    {
+        // Append the overlay strips after the simulated ones
+        std::vector<int>::difference_type numSimStrips = tkrDigi->size();
 
-                // Check the last strip stuff
-                if (overStripId < breakPoint && overStripId > lastStrip0) lastStrip0 = overStripId;
+        for(std::vector<unsigned short>::const_iterator overIter = overBegin; overIter != overEnd; overIter++)
+        {
+            int overStripId = *overIter;
 
-                // Go through following contortions to find correct slot to insert strip id
-                bool notFound = true;
-                for(std::vector<int>::iterator stripIter = tkrDigi->begin(); stripIter != tkrDigi->end(); stripIter++)
-                {
-                    if (overStripId >  *stripIter) continue;
-                    
-                    notFound = false;
+            // Check the last strip stuff
+            if (overStripId < breakPoint && overStripId > lastStrip0) lastStrip0 = overStripId;
 
-                    if (overStripId == *stripIter) break;
-                    tkrDigi->insert(stripIter, overStripId);
-                    break;
-                }
+            tkrDigi->push_back(overStripId);
+        }
 
-                if (notFound) tkrDigi->push_back(overStripId);
-            }
+        // Both sets of strips are normally in order, so one pass merges them, then drop the strips hit in both
+        std::vector<int>::iterator simEnd = tkrDigi->begin() + numSimStrips;
 
-            // Update the ToT and lastStrip info
-            tkrDigi->setToT(0,tot0);
-            tkrDigi->setToT(1,tot1);
-            tkrDigi->setLastController0Strip(lastStrip0);
-            tkrDigi->addToStatus(Event::TkrDigi::DIGI_OVERLAY);
+        if (std::adjacent_find(tkrDigi->begin(), simEnd,         std::greater<int>()) == simEnd &&
+            std::adjacent_find(simEnd,           tkrDigi->end(), std::greater<int>()) == tkrDigi->end())
+        {
+            std::inplace_merge(tkrDigi->begin(), simEnd, tkrDigi->end());
         }
+        else std::sort(tkrDigi->begin(), tkrDigi->end());
+
+        tkrDigi->erase(std::unique(tkrDigi->begin(), tkrDigi->end()), tkrDigi->end());
     }
 
-    // sort by volume id
-    std::sort(tkrDigiCol->begin(), tkrDigiCol->end(), Event::TkrDigi::digiLess());
+    // Update the ToT and lastStrip info
+    tkrDigi->setToT(0,tot0);
+    tkrDigi->setToT(1,tot1);
+    tkrDigi->setLastController0Strip(lastStrip0);
+    tkrDigi->addToStatus(Event::TkrDigi::DIGI_OVERLAY);
 
-    return sc;
+    return;
 }
 
-Event::TkrDigi* TkrOverlayMergeAlg::copyTkrOverlay(Event::TkrOverlay* TkrOverlay)
+Event::TkrDigi* TkrOverlayMergeAlg::copyTkrOverlay(const OverlayEventView& overlayView, unsigned int row)
 {
     // This method will create a new TkrDigi object using the information from the 
-    // input TkrOverlay object. 
+    // input TkrOverlay row. 
 
     // Recover ToT information into local array
-    int totTds[2] = { TkrOverlay->getToT(0), TkrOverlay->getToT(1)};
+    int totTds[2] = {overlayView.tkrToT0[row], overlayView.tkrToT1[row]};
+
+    idents::TowerId         towerId(overlayView.tkrTowerX[row], overlayView.tkrTowerY[row]);
+    idents::GlastAxis::axis view = overlayView.tkrView[row] == 0 ? idents::GlastAxis::X : idents::GlastAxis::Y;
 
     // Get new TkrOverlay object
-    Event::TkrDigi* tkrDigi = new Event::TkrDigi(TkrOverlay->getBilayer(),
-                                                 TkrOverlay->getView(), 
-                                                 TkrOverlay->getTower(), 
+    Event::TkrDigi* tkrDigi = new Event::TkrDigi(overlayView.tkrBilayer[row],
+                                                 view, 
+                                                 towerId, 
                                                  totTds, 
                                                  Event::TkrDigi::DIGI_OVERLAY);
 
     // Fill in the hit information
-    int          lastController0Strip = TkrOverlay->getLastController0Strip();
-    unsigned int numStrips            = TkrOverlay->getNumHits();
+    int lastController0Strip = overlayView.tkrLastC0Strip[row];
 
     // Loop over hits and add them
-    for (unsigned int iHit = 0; iHit < numStrips; iHit++) 
+    for (unsigned int idx = overlayView.tkrStripOffset[row]; idx < overlayView.tkrStripOffset[row+1]; idx++) 
     {
-        int strip = TkrOverlay->getHit(iHit);
+        int strip = overlayView.tkrStrips[idx];
 
         if (strip <= lastController0Strip) 
         {
@@ -324,6 +485,42 @@ Event::TkrDigi* TkrOverlayMergeAlg::copyTkrOverlay(Event::TkrOverlay* TkrOverlay
     return tkrDigi;
 }
 
+void TkrOverlayMergeAlg::fillSplitPoints()
+{
+    for(int tower = 0; tower < NumTowers; tower++)
+    {
+        for(int bilayer = 0; bilayer < NumBilayers; bilayer++)
+        {
+            for(int view = 0; view < NumViews; view++)
+            {
+                idents::GlastAxis::axis axis = view == 0 ? idents::GlastAxis::X : idents::GlastAxis::Y;
+
+                m_splitPoints[planeIndex(tower, bilayer, view)] = m_tspSvc->getSplitPoint(tower, bilayer, axis);
+            }
+        }
+    }
+
+    m_splitsLoaded = true;
+
+    return;
+}
+
+bool TkrOverlayMergeAlg::splitsChanged()
+{
+    if (!m_calibDataSvc) return false;
+
+    // TkrCalibAlg, which runs before us, has handed the calibration for this event to TkrSplitsSvc
+    std::string splitsPath = CalibData::TKR_Splits + "/" + m_splitsFlavor;
+
+    SmartDataPtr<CalibData::TkrSplitsCalib> splits(m_calibDataSvc, splitsPath);
+
+    if (!splits || splits->getSerNo() == m_splitsSerNo) return false;
+
+    m_splitsSerNo = splits->getSerNo();
+
+    return true;
+}
+
 StatusCode TkrOverlayMergeAlg::finalize() 
 {
     MsgStream log(msgSvc(), name());
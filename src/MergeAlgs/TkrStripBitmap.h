@@ -0,0 +1,101 @@
+/** @file TkrStripBitmap.h
+
+    @brief declaration and implementation of the TkrStripBitmap class
+
+$Header$
+
+*/
+
+#ifndef TkrStripBitmap_h
+#define TkrStripBitmap_h
+
+#include <cstring>
+
+/** @class TkrStripBitmap
+    @brief The hit strips of one tracker plane as a bitmap of its 1536 strips
+
+    Used to take the union of the simulated and overlay strips of a plane: each set is marked in a
+    bitmap, the bitmaps are OR'ed a word at a time and the merged, ordered hit list is read back by
+    scanning for set bits. The cost is linear in the number of hits plus a fixed 24 words per plane.
+*/
+class TkrStripBitmap
+{
+public:
+    enum {NumStrips = 1536, NumWords = NumStrips / 64};
+
+    TkrStripBitmap() {clear();}
+    ~TkrStripBitmap() {}
+
+    void clear() {std::memset(m_words, 0, sizeof(m_words));}
+
+    /// Mark the strips in [first, last), returns false if one is not a valid strip number
+    template <class Iterator> bool set(Iterator first, Iterator last)
+    {
+        for( ; first != last; ++first)
+        {
+            unsigned int strip = *first;
+
+            if (strip >= NumStrips) return false;
+
+            m_words[strip >> 6] |= 1ULL << (strip & 63);
+        }
+
+        return true;
+    }
+
+    /// Add the strips of another bitmap
+    TkrStripBitmap& operator|=(const TkrStripBitmap& other)
+    {
+        for(int word = 0; word < NumWords; word++) m_words[word] |= other.m_words[word];
+
+        return *this;
+    }
+
+    /// Number of strips set
+    int count() const
+    {
+        int numStrips = 0;
+
+        for(int word = 0; word < NumWords; word++) numStrips += __builtin_popcountll(m_words[word]);
+
+        return numStrips;
+    }
+
+    /// Highest strip set below limit, -1 if there is none
+    int highestBelow(int limit) const
+    {
+        if (limit > NumStrips) limit = NumStrips;
+        if (limit <= 0)        return -1;
+
+        int                word = (limit - 1) >> 6;
+        unsigned long long bits = m_words[word] & (~0ULL >> (63 - ((limit - 1) & 63)));
+
+        while(!bits)
+        {
+            if (--word < 0) return -1;
+
+            bits = m_words[word];
+        }
+
+        return word * 64 + 63 - __builtin_clzll(bits);
+    }
+
+    /// Write the strips set, in increasing order, returns the end of the output
+    template <class Iterator> Iterator strips(Iterator out) const
+    {
+        for(int word = 0; word < NumWords; word++)
+        {
+            for(unsigned long long bits = m_words[word]; bits; bits &= bits - 1)
+            {
+                *out++ = word * 64 + __builtin_ctzll(bits);
+            }
+        }
+
+        return out;
+    }
+
+private:
+    unsigned long long m_words[NumWords];
+};
+
+#endif
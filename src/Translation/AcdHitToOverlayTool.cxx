@@ -22,6 +22,8 @@
 #include "OverlayEvent/OverlayEventModel.h"
 #include "OverlayEvent/AcdOverlay.h"
 
+#include "../DataServices/OverlayTdsHandle.h"
+
 #include "AcdUtil/IAcdCalibSvc.h"
 #include "AcdUtil/AcdRibbonDim.h"
 #include "AcdUtil/AcdTileDim.h"
@@ -30,6 +32,8 @@
 
 #include "AcdUtil/AcdCalibFuncs.h"
 
+#include "../DataServices/OverlayArena.h"
+
 #include "CalibData/Acd/AcdPed.h"
 #include "CalibData/Acd/AcdGain.h"
 #include "CalibData/Acd/AcdHighRange.h"
@@ -69,6 +73,7 @@ public:
 private:
   
     /// Internal methods stolen from AcdUtil's AcdPha2MipTool
+    /// (the AcdHit is made in the event arena and must be destroyed with ~AcdHit, not deleted)
     Event::AcdHit* makeAcdHit ( const Event::AcdDigi* digi);
     bool getCalibratedValues(const Event::AcdDigi* digi, double& mipsPmtA, double& mipsPmtB, bool& acceptDigi) const;
     bool getValues_lowRange(const idents::AcdId& id, Event::AcdDigi::PmtId pmt, unsigned short pha, 
@@ -102,8 +107,8 @@ private:
     /// Pointer to the event data service (aka "eventSvc")
     IDataProviderSvc*      m_edSvc;
 
-    /// Pointer to the Overlay data service
-    DataSvc*          m_dataSvc;
+    /// Handle to the AcdOverlayCol in the Overlay data service
+    OverlayTdsHandle<Event::AcdOverlayCol> m_acdOverlayCol;
 
     /// Pointer to the Acd geometry svc
     IAcdGeometrySvc*       m_acdGeoSvc;
@@ -165,7 +170,11 @@ StatusCode AcdHitToOverlayTool::initialize()
         log << MSG::ERROR << "could not find EventDataSvc !" << endreq;
         return sc;
     }
-    m_dataSvc = dynamic_cast<DataSvc*>(iService);
+    sc = m_acdOverlayCol.initialize(iService, OverlayEventModel::Overlay::AcdOverlayCol);
+    if ( sc.isFailure() ) {
+        log << MSG::ERROR << "OverlayOutputSvc is not an overlay data service !" << endreq;
+        return sc;
+    }
 
     sc = serviceLocator()->service("AcdGeometrySvc", iService, true);
     if (sc.isSuccess() ) 
@@ -223,12 +232,12 @@ StatusCode AcdHitToOverlayTool::translate()
     SmartDataPtr<Event::AcdDigiCol> acdDigiCol(m_edSvc, EventModel::Digi::AcdDigiCol);
 
     // Create a collection of AcdOverlays and register in the TDS
-    SmartDataPtr<Event::AcdOverlayCol> overlayCol(m_dataSvc, m_dataSvc->rootName() + OverlayEventModel::Overlay::AcdOverlayCol);
+    Event::AcdOverlayCol* overlayCol = m_acdOverlayCol.get();
     if(!overlayCol)
     {
         overlayCol = new Event::AcdOverlayCol();
 
-        status = m_dataSvc->registerObject(m_dataSvc->rootName() + OverlayEventModel::Overlay::AcdOverlayCol, overlayCol);
+        status = m_acdOverlayCol.put(overlayCol);
         if( status.isFailure() ) 
         {
             log << MSG::ERROR << "could not register OverlayEventModel::Overlay::AcdOverlayCol" << endreq;
@@ -296,8 +305,8 @@ StatusCode AcdHitToOverlayTool::translate()
 
         acdOverlay->setStatus(statusBits);
 
-        // Dump the AcdHit we made
-        delete acdHit;
+        // Dump the AcdHit we made, its memory goes back with the event arena
+        acdHit->~AcdHit();
 
         // Add the finished product to our collection
         overlayCol->push_back(acdOverlay);
@@ -343,7 +352,8 @@ Event::AcdHit* AcdHitToOverlayTool::makeAcdHit ( const Event::AcdDigi* digi)
 
     if ( acceptDigi ) 
     {
-        hit = new Event::AcdHit(*digi,mipsPmtA,mipsPmtB);
+        void* hitMem = OverlayArena::eventArena().allocate(sizeof(Event::AcdHit), __alignof__(Event::AcdHit));
+        hit = ::new(hitMem) Event::AcdHit(*digi,mipsPmtA,mipsPmtB);
 	// Correct for the fact that the Accept Mask bits are always set.
 	hit->correctAcceptMapBits( (mipsPmtA > 1e-6), (mipsPmtB > 1e-6) );
     }
@@ -19,6 +19,8 @@
 #include "OverlayEvent/OverlayEventModel.h"
 #include "OverlayEvent/CalOverlay.h"
 
+#include "../DataServices/OverlayTdsHandle.h"
+
 /** @class BackgroundSelection
     @brief manage the selection of background events to merge with signal events
     @author Dan Flath
@@ -53,8 +55,8 @@ private:
     /// Pointer to the event data service (aka "eventSvc")
     IDataProviderSvc*   m_edSvc;
 
-    /// Pointer to the Overlay data service
-    DataSvc*          m_dataSvc;
+    /// Handle to the CalOverlayCol in the Overlay data service
+    OverlayTdsHandle<Event::CalOverlayCol> m_calOverlayCol;
 };
 
 //static ToolFactory<CalXtalToOverlayTool> s_factory;
@@ -97,7 +99,11 @@ StatusCode CalXtalToOverlayTool::initialize()
         log << MSG::ERROR << "could not find EventDataSvc !" << endreq;
         return sc;
     }
-    m_dataSvc = dynamic_cast<DataSvc*>(iService);
+    sc = m_calOverlayCol.initialize(iService, OverlayEventModel::Overlay::CalOverlayCol);
+    if ( sc.isFailure() ) {
+        log << MSG::ERROR << "OverlayOutputSvc is not an overlay data service !" << endreq;
+        return sc;
+    }
 
     return sc;
 }
@@ -119,12 +125,12 @@ StatusCode CalXtalToOverlayTool::translate()
     SmartDataPtr<Event::CalXtalRecCol> calXtalRecCol(m_edSvc, EventModel::CalRecon::CalXtalRecCol);
 
     // Create a collection of TkrOverlays and register in the TDS
-    SmartDataPtr<Event::CalOverlayCol> overlayCol(m_dataSvc, m_dataSvc->rootName() + OverlayEventModel::Overlay::CalOverlayCol);
+    Event::CalOverlayCol* overlayCol = m_calOverlayCol.get();
     if(!overlayCol)
     {
         overlayCol = new Event::CalOverlayCol();
 
-        status = m_dataSvc->registerObject(m_dataSvc->rootName() + OverlayEventModel::Overlay::CalOverlayCol, overlayCol);
+        status = m_calOverlayCol.put(overlayCol);
         if( status.isFailure() ) 
         {
             log << MSG::ERROR << "could not register OverlayEventModel::Overlay::CalOverlayCol" << endreq;
@@ -18,6 +18,8 @@
 #include "OverlayEvent/OverlayEventModel.h"
 #include "OverlayEvent/DiagDataOverlay.h"
 
+#include "../DataServices/OverlayTdsHandle.h"
+
 /** @class BackgroundSelection
     @brief manage the selection of background events to merge with signal events
     @author Dan Flath
@@ -52,8 +54,8 @@ private:
     /// Pointer to the event data service (aka "eventSvc")
     IDataProviderSvc*      m_edSvc;
 
-    /// Pointer to the Overlay data service
-    DataSvc*          m_dataSvc;
+    /// Handle to the DiagDataOverlay in the Overlay data service
+    OverlayTdsHandle<Event::DiagDataOverlay> m_diagDataOverlay;
 };
 
 //static ToolFactory<DiagnosticDataToOverlayTool> s_factory;
@@ -98,7 +100,11 @@ StatusCode DiagnosticDataToOverlayTool::initialize()
         log << MSG::ERROR << "could not find EventDataSvc !" << endreq;
         return sc;
     }
-    m_dataSvc = dynamic_cast<DataSvc*>(iService);
+    sc = m_diagDataOverlay.initialize(iService, OverlayEventModel::Overlay::DiagDataOverlay);
+    if ( sc.isFailure() ) {
+        log << MSG::ERROR << "OverlayOutputSvc is not an overlay data service !" << endreq;
+        return sc;
+    }
 
     return sc;
 }
@@ -120,13 +126,13 @@ StatusCode DiagnosticDataToOverlayTool::translate()
     SmartDataPtr<LdfEvent::DiagnosticData> diagnosticData(m_edSvc, "/Event/Diagnostic");
 
     // Create a collection of AcdOverlays and register in the TDS
-    SmartDataPtr<Event::DiagDataOverlay> diagDataOverlay(m_dataSvc, m_dataSvc->rootName() + OverlayEventModel::Overlay::DiagDataOverlay);
+    Event::DiagDataOverlay* diagDataOverlay = m_diagDataOverlay.get();
 
     if(!diagDataOverlay)
     {
         diagDataOverlay = new Event::DiagDataOverlay();
 
-        status = m_dataSvc->registerObject(m_dataSvc->rootName() + OverlayEventModel::Overlay::DiagDataOverlay, diagDataOverlay);
+        status = m_diagDataOverlay.put(diagDataOverlay);
         if( status.isFailure() ) 
         {
             log << MSG::ERROR << "could not register OverlayEventModel::Overlay::DiagDataOverlay" << endreq;
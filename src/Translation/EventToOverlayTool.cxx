@@ -19,6 +19,9 @@
 
 #include "OverlayEvent/OverlayEventModel.h"
 #include "OverlayEvent/EventOverlay.h"
+#include "Overlay/IOverlayDataSvc.h"
+
+#include "../DataServices/OverlayTdsHandle.h"
 
 /** @class BackgroundSelection
     @brief manage the selection of background events to merge with signal events
@@ -56,6 +59,9 @@ private:
 
     /// Pointer to the Overlay data service
     DataSvc*          m_dataSvc;
+
+    /// Handle to the EventOverlay at the root of the Overlay section, used when the section is reused
+    OverlayTdsHandle<Event::EventOverlay> m_overlayHeader;
 };
 
 //static ToolFactory<EventToOverlayTool> s_factory;
@@ -100,6 +106,12 @@ StatusCode EventToOverlayTool::initialize()
     }
     m_dataSvc = dynamic_cast<DataSvc*>(iService);
 
+    sc = m_overlayHeader.initialize(iService, "");
+    if ( sc.isFailure() ) {
+        log << MSG::ERROR << "OverlayOutputSvc is not an overlay data service !" << endreq;
+        return sc;
+    }
+
     return sc;
 }
 
@@ -123,15 +135,26 @@ StatusCode EventToOverlayTool::translate()
     // TDS. Therefore, we MUST create a new one each event and be sure to call the 
     // "setRoot" method of the data service to properly clear and initialize each 
     // event, otherwise stale information will be left lying about. 
-    Event::EventOverlay* overlay = new Event::EventOverlay();
+    // The exception is when the data service reuses the section (ReuseOverlayTree), it has 
+    // then emptied everything below the root and we refill the header we already have.
+    Event::EventOverlay* overlay = 0;
+
+    IOverlayDataSvc* overlaySvc = dynamic_cast<IOverlayDataSvc*>(m_dataSvc);
 
-    // Set it as the root of the Overlay section in the TDS
-    status = m_dataSvc->setRoot(m_dataSvc->rootName(), overlay);
+    if (overlaySvc && overlaySvc->refillOverlayTree().isSuccess()) overlay = m_overlayHeader.get();
 
-    if( status.isFailure() ) 
+    if (!overlay)
     {
-        log << MSG::ERROR << "could not set root for OverlayEventModel::Overlay::EventOverlay" << endreq;
-        return status;
+        overlay = new Event::EventOverlay();
+
+        // Set it as the root of the Overlay section in the TDS
+        status = m_dataSvc->setRoot(m_dataSvc->rootName(), overlay);
+
+        if( status.isFailure() ) 
+        {
+            log << MSG::ERROR << "could not set root for OverlayEventModel::Overlay::EventOverlay" << endreq;
+            return status;
+        }
     }
 
     // Check to see if the event and run ids have already been set.
@@ -18,6 +18,8 @@
 #include "OverlayEvent/OverlayEventModel.h"
 #include "OverlayEvent/GemOverlay.h"
 
+#include "../DataServices/OverlayTdsHandle.h"
+
 /** @class BackgroundSelection
     @brief manage the selection of background events to merge with signal events
     @author Dan Flath
@@ -52,8 +54,8 @@ private:
     /// Pointer to the event data service (aka "eventSvc")
     IDataProviderSvc*      m_edSvc;
 
-    /// Pointer to the Overlay data service
-    DataSvc*          m_dataSvc;
+    /// Handle to the GemOverlay in the Overlay data service
+    OverlayTdsHandle<Event::GemOverlay> m_gemOverlay;
 };
 
 //static ToolFactory<GemToOverlayTool> s_factory;
@@ -98,7 +100,11 @@ StatusCode GemToOverlayTool::initialize()
         log << MSG::ERROR << "could not find EventDataSvc !" << endreq;
         return sc;
     }
-    m_dataSvc = dynamic_cast<DataSvc*>(iService);
+    sc = m_gemOverlay.initialize(iService, OverlayEventModel::Overlay::GemOverlay);
+    if ( sc.isFailure() ) {
+        log << MSG::ERROR << "OverlayOutputSvc is not an overlay data service !" << endreq;
+        return sc;
+    }
 
     return sc;
 }
@@ -120,12 +126,12 @@ StatusCode GemToOverlayTool::translate()
     SmartDataPtr<LdfEvent::Gem> gem(m_edSvc, "/Event/Gem");
 
     // Create a collection of AcdOverlays and register in the TDS
-    SmartDataPtr<Event::GemOverlay> gemOverlay(m_dataSvc, m_dataSvc->rootName() + OverlayEventModel::Overlay::GemOverlay);
+    Event::GemOverlay* gemOverlay = m_gemOverlay.get();
     if(!gemOverlay)
     {
         gemOverlay = new Event::GemOverlay();
 
-        status = m_dataSvc->registerObject(m_dataSvc->rootName() + OverlayEventModel::Overlay::GemOverlay, gemOverlay);
+        status = m_gemOverlay.put(gemOverlay);
         if( status.isFailure() ) 
         {
             log << MSG::ERROR << "could not register OverlayEventModel::Overlay::GemOverlay" << endreq;
@@ -18,6 +18,8 @@
 #include "OverlayEvent/OverlayEventModel.h"
 #include "OverlayEvent/PtOverlay.h"
 
+#include "../DataServices/OverlayTdsHandle.h"
+
 /** @class BackgroundSelection
     @brief manage the selection of background events to merge with signal events
     @author Tracy Usher
@@ -52,8 +54,8 @@ private:
     /// Pointer to the event data service (aka "eventSvc")
     IDataProviderSvc* m_edSvc;
 
-    /// Pointer to the Overlay data service
-    DataSvc*          m_dataSvc;
+    /// Handle to the PtOverlay in the Overlay data service
+    OverlayTdsHandle<Event::PtOverlay> m_ptOverlay;
 
     /// Access to the ntuple
     INTupleWriterSvc* m_tuple;
@@ -157,7 +159,11 @@ StatusCode PtToOverlayTool::initialize()
         log << MSG::ERROR << "could not find EventDataSvc !" << endreq;
         return sc;
     }
-    m_dataSvc = dynamic_cast<DataSvc*>(iService);
+    sc = m_ptOverlay.initialize(iService, OverlayEventModel::Overlay::PtOverlay);
+    if ( sc.isFailure() ) {
+        log << MSG::ERROR << "OverlayOutputSvc is not an overlay data service !" << endreq;
+        return sc;
+    }
 
     // Retrieve the ntuple service
 
@@ -429,12 +435,12 @@ StatusCode PtToOverlayTool::translate()
     StatusCode status = StatusCode::SUCCESS;
 
     // Create a collection of AcdOverlays and register in the TDS
-    SmartDataPtr<Event::PtOverlay> ptOverlay(m_dataSvc, m_dataSvc->rootName() + OverlayEventModel::Overlay::PtOverlay);
+    Event::PtOverlay* ptOverlay = m_ptOverlay.get();
     if(!ptOverlay)
     {
         ptOverlay = new Event::PtOverlay();
 
-        status = m_dataSvc->registerObject(m_dataSvc->rootName() + OverlayEventModel::Overlay::PtOverlay, ptOverlay);
+        status = m_ptOverlay.put(ptOverlay);
         if( status.isFailure() ) 
         {
             log << MSG::ERROR << "could not register OverlayEventModel::Overlay::PtOverlay" << endreq;
@@ -19,6 +19,8 @@
 #include "OverlayEvent/OverlayEventModel.h"
 #include "OverlayEvent/TkrOverlay.h"
 
+#include "../DataServices/OverlayTdsHandle.h"
+
 /** @class BackgroundSelection
     @brief manage the selection of background events to merge with signal events
     @author Dan Flath
@@ -53,8 +55,8 @@ private:
     /// Pointer to the event data service
     IDataProviderSvc* m_edSvc;
 
-    /// Pointer to the Overlay data service
-    DataSvc*          m_dataSvc;
+    /// Handle to the TkrOverlayCol in the Overlay data service
+    OverlayTdsHandle<Event::TkrOverlayCol> m_tkrOverlayCol;
 };
 
 //static ToolFactory<TkrDigiToOverlayTool> s_factory;
@@ -97,7 +99,11 @@ StatusCode TkrDigiToOverlayTool::initialize()
         log << MSG::ERROR << "could not find EventDataSvc !" << endreq;
         return sc;
     }
-    m_dataSvc = dynamic_cast<DataSvc*>(iService);
+    sc = m_tkrOverlayCol.initialize(iService, OverlayEventModel::Overlay::TkrOverlayCol);
+    if ( sc.isFailure() ) {
+        log << MSG::ERROR << "OverlayOutputSvc is not an overlay data service !" << endreq;
+        return sc;
+    }
 
     return sc;
 }
@@ -119,12 +125,12 @@ StatusCode TkrDigiToOverlayTool::translate()
     SmartDataPtr<Event::TkrDigiCol> tkrDigiCol(m_edSvc, EventModel::Digi::TkrDigiCol);
 
     // Create a collection of TkrOverlays and register in the TDS
-    SmartDataPtr<Event::TkrOverlayCol> overlayCol(m_dataSvc, m_dataSvc->rootName() + OverlayEventModel::Overlay::TkrOverlayCol);
+    Event::TkrOverlayCol* overlayCol = m_tkrOverlayCol.get();
     if(!overlayCol)
     {
         overlayCol = new Event::TkrOverlayCol();
 
-        status = m_dataSvc->registerObject(m_dataSvc->rootName() + OverlayEventModel::Overlay::TkrOverlayCol, overlayCol);
+        status = m_tkrOverlayCol.put(overlayCol);
         if( status.isFailure() ) 
         {
             log << MSG::ERROR << "could not register OverlayEventModel::Overlay::TkrOverlayCol" << endreq;
@@ -2,222 +2,54 @@
 /**
             @file  CalOverlayCnv.cxx
 
-   Implementation file for Root calibration converter base class
+   Converter traits for the CalOverlay collection
 */
-#include "Overlay/IOverlayDataSvc.h"
-
-#include "GaudiKernel/Converter.h"
-#include "GaudiKernel/SvcFactory.h"
-#include "GaudiKernel/CnvFactory.h"
-#include "GaudiKernel/SmartIF.h"
-#include "GaudiKernel/DataObject.h"
-#include "GaudiKernel/MsgStream.h"
-
-#include "GaudiKernel/IOpaqueAddress.h"
-#include "GaudiKernel/IRegistry.h"
-#include "GaudiKernel/IAddressCreator.h"
-#include "GaudiKernel/IDataProviderSvc.h"
-#include "GaudiKernel/IConversionSvc.h"
-#include "GaudiKernel/IDataManagerSvc.h"
-
-#include "GlastSvc/EventSelector/IGlastCnv.h"
+#include "OverlayCnv.h"
+#include "OverlayTdsFill.h"
 
 #include "OverlayEvent/OverlayEventModel.h"
 #include "OverlayEvent/CalOverlay.h"
 
 #include "overlayRootData/EventOverlay.h"
 
-class  CalOverlayCnv : virtual public IGlastCnv, public Converter 
-{
-public:
-
-    /**
-        Constructor for this converter
-        @param svc a ISvcLocator interface to find services
-        @param clid the type of object the converter is able to convert
-    */
-    CalOverlayCnv(ISvcLocator* svc);
-
-    virtual ~CalOverlayCnv();
-
-    /// Query interfaces of Interface
-    //virtual StatusCode queryInterface(const InterfaceID& riid, void** ppvInterface);
-    static const CLID&         classID()     {return ObjectVector<Event::CalOverlay>::classID();}
-    static const unsigned char storageType() {return EXCEL_StorageType;}
-
-    /// Initialize the converter
-    virtual StatusCode initialize();
-
-    /// Initialize the converter
-    virtual StatusCode finalize();
-
-    /// Retrieve the class type of objects the converter produces. 
-    virtual const CLID& objType() const {return classID();}
-
-    /// Retrieve the class type of the data store the converter uses.
-    // MSF: Masked to generate compiler error due to interface change
-    virtual long repSvcType() const {return Converter::i_repSvcType();}
-
-    /** Create the transient representation of an object.
-        The transient representation is created by loading the 
-        persistent object using the source information
-        contained in the address.
-        @return    Status code indicating success or failure
-        @param     pAddress   Opaque address information to retrieve the 
-                              requested object from the store in order to 
-                              produce the transient object.
-        @param     refpObject Reference to location of pointer of the 
-                              created object.
-     */
-    virtual StatusCode createObj(IOpaqueAddress* pAddress,DataObject*& refpObject);
-
-    /** Convert the transient object to the requested representation.
-        e.g. conversion to persistent objects.
-        @return    Status code indicating success or failure
-        @param     pObject     Pointer to location of the object 
-        @param     refpAddress Reference to location of pointer with the 
-                               object address.
-     */
-    virtual StatusCode createRep(DataObject* pObject, IOpaqueAddress*& refpAddress);
-
-    /// Methods to set and return the path in TDS for output of this converter
-    virtual void setPath(const std::string& path) {m_path = path;}
-    virtual const std::string& getPath() const    {return m_path;}
-
-private:
-    std::string      m_path;
-
-    IOverlayDataSvc* m_overlayOutputSvc;
-};
-
-
- //static CnvFactory<CalOverlayCnv> s_factory;
- //const ICnvFactory& CalOverlayCnvFactory = s_factory;
-DECLARE_CONVERTER_FACTORY(CalOverlayCnv);
-
- CalOverlayCnv::CalOverlayCnv( ISvcLocator* svc) : Converter (EXCEL_StorageType, ObjectVector<Event::CalOverlay>::classID(), svc) 
-{
-    m_path = OverlayEventModel::Overlay::CalOverlayCol;
-
-    return;
-}
-
-CalOverlayCnv::~CalOverlayCnv() 
+/** @class CalOverlayCnvTraits
+    @brief Describes the CalOverlay collection to the OverlayCnv converter template
+*/
+struct CalOverlayCnvTraits
 {
-    return;
-}
+    typedef Event::CalOverlayCol TdsType;
 
-StatusCode CalOverlayCnv::initialize() 
-{
-    MsgStream log(msgSvc(), "CalOverlayCnv");
-    StatusCode status = Converter::initialize();
+    enum {registerOutput = true};
 
-    //SmartIF<IDataManagerSvc> iaddrReg(IID_IDataManagerSvc, dataProvider());
+    static const CLID& classID() {return ObjectVector<Event::CalOverlay>::classID();}
+    static std::string path()    {return OverlayEventModel::Overlay::CalOverlayCol;}
+    static const char* name()    {return "CalOverlayCnv";}
 
-    // We're going rogue here, look up the OverlayDataSvc and use this as 
-    // our data provider insteand of EventCnvSvc
-    IDataProviderSvc* tmpService = 0;
-    if (serviceLocator()->service("OverlayOutputSvc", tmpService, false).isFailure())
+    static DataObject* createObj(EventOverlay& overlayRoot, const OverlayColumns* columns, const OverlaySnapshot* snapshot, const OverlayReadCuts& cuts)
     {
-        log << MSG::INFO << "No OverlayOutputSvc available, no output conversion will be performed" << endreq;
-        m_overlayOutputSvc = 0;
+        return OverlayTdsFill::createCalOverlayCol(overlayRoot, columns, snapshot, cuts);
     }
-    else 
-    {
-        // Need to up convert to point to the OverlayDataSvc
-        m_overlayOutputSvc = SmartIF<IOverlayDataSvc>(tmpService);
-    }
-
-    if (m_overlayOutputSvc) m_overlayOutputSvc->registerOutputPath(m_path);
-
-    return status;
-}
-
-StatusCode CalOverlayCnv::finalize() 
-{
-    return Converter::finalize();
-}
-
-// (To TDS) Conversion stuff
-StatusCode CalOverlayCnv::createObj(IOpaqueAddress* pOpaque, DataObject*& refpObject) 
-{
-    StatusCode status = StatusCode::SUCCESS;
 
-    // If no opaque address then there is nothing to do
-    if (!pOpaque) return StatusCode::FAILURE;
-
-    // Recover the pointer to the registry
-    IRegistry* pRegistry = pOpaque->registry();
-
-    if (!pRegistry) return StatusCode::FAILURE;
-
-    // Recover pointer to the data provider service
-    IDataProviderSvc* pDataSvc = pRegistry->dataSvc();
-
-    if (!pDataSvc) return StatusCode::FAILURE;
-
-    IOverlayDataSvc* inputDataSvc = SmartIF<IOverlayDataSvc>(pDataSvc);
-
-    // Retrieve the pointer to the digi
-    EventOverlay* overlayRoot = inputDataSvc->getRootEventOverlay();
-
-    // Check that we have a TkrDigi collection in the input root data
-    const TObjArray *calOverlayRootCol = overlayRoot->getCalOverlayCol();
-    if (!calOverlayRootCol) return status;
-
-    // Make a TIter object for traversing the collection
-    TIter CalOverlayIter(calOverlayRootCol);
-
-    // Create the new TkrDigi event to put in the TDS
-    Event::CalOverlayCol* calOverlayTdsCol = new Event::CalOverlayCol;
-
-    CalOverlay *calOverlayRoot = 0;
-    while ((calOverlayRoot = (CalOverlay*)CalOverlayIter.Next())!=0) 
-    {
-        CalXtalId idRoot = calOverlayRoot->getPackedId();
-        idents::CalXtalId idTds(idRoot.getTower(), idRoot.getLayer(), idRoot.getColumn());
-
-        const TVector3& posRoot = calOverlayRoot->getPosition();
-        Point posTds(posRoot.X(),posRoot.Y(),posRoot.Z());
-
-        Event::CalOverlay *calOverlayTds = new Event::CalOverlay(idTds, posTds, calOverlayRoot->getEnergy());
-
-        calOverlayTds->setStatus(calOverlayRoot->getStatus());
-
-        calOverlayTds->addToStatus(Event::CalOverlay::DIGI_OVERLAY);
+    static StatusCode createRep(TdsType& calOverlayColTds, EventOverlay& overlayRoot, IDataProviderSvc*);
+};
 
-        calOverlayTdsCol->push_back(calOverlayTds);
-    }
+typedef OverlayCnv<CalOverlayCnvTraits> CalOverlayCnv;
 
-    // Return the pointer to it
-    refpObject = calOverlayTdsCol;
+DECLARE_CONVERTER_FACTORY(CalOverlayCnv);
 
-    return status;
-}
-    
-StatusCode CalOverlayCnv::createRep(DataObject* pObject, IOpaqueAddress*&)
+StatusCode CalOverlayCnvTraits::createRep(TdsType& calOverlayColTds, EventOverlay& overlayRoot, IDataProviderSvc*)
 {
-    StatusCode status = StatusCode::SUCCESS;
-
-    if (!m_overlayOutputSvc) return status;
-
-    // Retrieve the pointer to the digi
-    EventOverlay* overlayRoot = m_overlayOutputSvc->getRootEventOverlay();
-
-    // Cast our object back to a TkrDigiCol object
-    Event::CalOverlayCol* CalOverlayColTds = dynamic_cast<Event::CalOverlayCol*>(pObject);
-
-    // Loop over the collection and creat root versions of TkrDigi objects
-    for (Event::CalOverlayCol::const_iterator calOverlayTds  = CalOverlayColTds->begin(); 
-                                              calOverlayTds != CalOverlayColTds->end(); 
-                                              calOverlayTds++) 
+    // Loop over the collection and creat root versions of CalOverlay objects
+    for (Event::CalOverlayCol::const_iterator calOverlayTds  = calOverlayColTds.begin();
+                                              calOverlayTds != calOverlayColTds.end();
+                                              calOverlayTds++)
     {
         // Convert the volume identifier info
         idents::CalXtalId idTds = (*calOverlayTds)->getCalXtalId();
         CalXtalId idRoot(idTds.getTower(), idTds.getLayer(), idTds.getColumn());
 
         // Position next
-        const Point positionTds = (*calOverlayTds)->getPosition();
+        const Point& positionTds = (*calOverlayTds)->getPosition();
         TVector3 positionRoot(positionTds.x(), positionTds.y(), positionTds.z());
 
         // Energy
@@ -225,13 +57,13 @@ StatusCode CalOverlayCnv::createRep(DataObject* pObject, IOpaqueAddress*&)
 
         // Status bits
         UInt_t status = (*calOverlayTds)->getStatus();
-       
+
         CalOverlay *calOverlayRoot = new CalOverlay();
-        
+
         calOverlayRoot->initialize(idRoot, positionRoot, energy, status);
 
-        overlayRoot->addCalOverlay(calOverlayRoot);
+        overlayRoot.addCalOverlay(calOverlayRoot);
     }
 
-    return status;
+    return StatusCode::SUCCESS;
 }
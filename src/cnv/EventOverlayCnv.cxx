@@ -2,26 +2,12 @@
 /**
             @file  EventOverlayCnv.cxx
 
-   Implementation file for Root calibration converter base class
+   Converter traits for the EventOverlay, the root of the overlay section of the TDS
 */
-#include "Overlay/IOverlayDataSvc.h"
-
-#include "GaudiKernel/Converter.h"
-#include "GaudiKernel/SvcFactory.h"
-#include "GaudiKernel/CnvFactory.h"
-#include "GaudiKernel/SmartIF.h"
-#include "GaudiKernel/DataObject.h"
-#include "GaudiKernel/MsgStream.h"
-#include "GaudiKernel/SmartDataPtr.h"
-
-#include "GaudiKernel/IOpaqueAddress.h"
-#include "GaudiKernel/IRegistry.h"
-#include "GaudiKernel/IAddressCreator.h"
-#include "GaudiKernel/IDataProviderSvc.h"
-#include "GaudiKernel/IConversionSvc.h"
-#include "GaudiKernel/IDataManagerSvc.h"
+#include "OverlayCnv.h"
+#include "OverlayTdsFill.h"
 
-#include "GlastSvc/EventSelector/IGlastCnv.h"
+#include "GaudiKernel/SmartDataPtr.h"
 
 #include "OverlayEvent/OverlayEventModel.h"
 #include "OverlayEvent/EventOverlay.h"
@@ -32,194 +18,46 @@
 
 #include "overlayRootData/EventOverlay.h"
 
-class  EventOverlayCnv : virtual public IGlastCnv, public Converter 
-{
-public:
-
-    /**
-        Constructor for this converter
-        @param svc a ISvcLocator interface to find services
-        @param clid the type of object the converter is able to convert
-    */
-    EventOverlayCnv(ISvcLocator* svc);
-
-    virtual ~EventOverlayCnv();
-
-    /// Query interfaces of Interface
-    //virtual StatusCode queryInterface(const InterfaceID& riid, void** ppvInterface);
-    static const CLID&         classID()     {return Event::EventOverlay::classID();}
-    static const unsigned char storageType() {return EXCEL_StorageType;}
-
-    /// Initialize the converter
-    virtual StatusCode initialize();
-
-    /// Initialize the converter
-    virtual StatusCode finalize();
-
-    /// Retrieve the class type of objects the converter produces. 
-    virtual const CLID& objType() const {return classID();}
-
-    /// Retrieve the class type of the data store the converter uses.
-    // MSF: Masked to generate compiler error due to interface change
-    virtual long repSvcType() const {return Converter::i_repSvcType();}
-
-    /** Create the transient representation of an object.
-        The transient representation is created by loading the 
-        persistent object using the source information
-        contained in the address.
-        @return    Status code indicating success or failure
-        @param     pAddress   Opaque address information to retrieve the 
-                              requested object from the store in order to 
-                              produce the transient object.
-        @param     refpObject Reference to location of pointer of the 
-                              created object.
-     */
-    virtual StatusCode createObj(IOpaqueAddress* pAddress,DataObject*& refpObject);
-
-    /** Convert the transient object to the requested representation.
-        e.g. conversion to persistent objects.
-        @return    Status code indicating success or failure
-        @param     pObject     Pointer to location of the object 
-        @param     refpAddress Reference to location of pointer with the 
-                               object address.
-     */
-    virtual StatusCode createRep(DataObject* pObject, IOpaqueAddress*& refpAddress);
-
-    /// Methods to set and return the path in TDS for output of this converter
-    virtual void setPath(const std::string& path) {m_path = path;}
-    virtual const std::string& getPath() const    {return m_path;}
-
-private:
-    std::string      m_path;
-
-    IOverlayDataSvc* m_overlayOutputSvc;
-};
-
-
- //static CnvFactory<EventOverlayCnv> s_factory;
- //const ICnvFactory& EventOverlayCnvFactory = s_factory;
-DECLARE_CONVERTER_FACTORY(EventOverlayCnv);
-
- EventOverlayCnv::EventOverlayCnv( ISvcLocator* svc) : Converter (EXCEL_StorageType, Event::EventOverlay::classID(), svc) 
-{
-    m_path = OverlayEventModel::Overlay::EventOverlay;
-
-    return;
-}
-
-EventOverlayCnv::~EventOverlayCnv() 
+/** @class EventOverlayCnvTraits
+    @brief Describes the EventOverlay to the OverlayCnv converter template
+*/
+struct EventOverlayCnvTraits
 {
-    return;
-}
+    typedef Event::EventOverlay TdsType;
 
-StatusCode EventOverlayCnv::initialize() 
-{
-    MsgStream log(msgSvc(), "EventOverlayCnv");
-    StatusCode status = Converter::initialize();
+    enum {registerOutput = true};
 
-    //SmartIF<IDataManagerSvc> iaddrReg(IID_IDataManagerSvc, dataProvider());
+    static const CLID& classID() {return Event::EventOverlay::classID();}
+    static std::string path()    {return OverlayEventModel::Overlay::EventOverlay;}
+    static const char* name()    {return "EventOverlayCnv";}
 
-    // We're going rogue here, look up the OverlayDataSvc and use this as 
-    // our data provider insteand of EventCnvSvc
-    IDataProviderSvc* tmpService = 0;
-    if (serviceLocator()->service("OverlayOutputSvc", tmpService, false).isFailure())
-    {
-        log << MSG::INFO << "No OverlayOutputSvc available, no output conversion will be performed" << endreq;
-        m_overlayOutputSvc = 0;
-    }
-    else 
+    static DataObject* createObj(EventOverlay& overlayRoot, const OverlayColumns*, const OverlaySnapshot*, const OverlayReadCuts&)
     {
-        // Need to up convert to point to the OverlayDataSvc
-        m_overlayOutputSvc = SmartIF<IOverlayDataSvc>(tmpService);
+        return OverlayTdsFill::createEventOverlay(overlayRoot);
     }
 
-    if (m_overlayOutputSvc) m_overlayOutputSvc->registerOutputPath(m_path);
-
-    return status;
-}
-
-StatusCode EventOverlayCnv::finalize() 
-{
-    return Converter::finalize();
-}
-
-// (To TDS) Conversion stuff
-StatusCode EventOverlayCnv::createObj(IOpaqueAddress* pOpaque, DataObject*& refpObject) 
-{
-    StatusCode status = StatusCode::SUCCESS;
-
-    // If no opaque address then there is nothing to do
-    if (!pOpaque) return StatusCode::FAILURE;
-
-    // Recover the pointer to the registry
-    IRegistry* pRegistry = pOpaque->registry();
-
-    if (!pRegistry) return StatusCode::FAILURE;
-
-    // Recover pointer to the data provider service
-    IDataProviderSvc* pDataSvc = pRegistry->dataSvc();
-
-    if (!pDataSvc) return StatusCode::FAILURE;
-
-    IOverlayDataSvc* inputDataSvc = SmartIF<IOverlayDataSvc>(pDataSvc);
-
-    // Create the new DigiOverlay event to put in the TDS
-    Event::EventOverlay* eventTds = new Event::EventOverlay();
-
-    // Retrieve the pointer to the digi
-    EventOverlay* overlayRoot = inputDataSvc->getRootEventOverlay();
-
-    // Initialize the overlay object
-
-    unsigned int eventIdRoot = overlayRoot->getEventId();
-    unsigned int runIdRoot   = overlayRoot->getRunId();
-
-    // Check to see if the event and run ids have already been set.
-    eventTds->setEvent(eventIdRoot);
-    eventTds->setRun(runIdRoot);
-
-    TimeStamp timeObj(overlayRoot->getTimeStamp());
-    eventTds->setTime(timeObj);
-
-    eventTds->setLivetime(overlayRoot->getLiveTime());
+    static StatusCode createRep(TdsType& evtTds, EventOverlay& overlayRoot, IDataProviderSvc* dataProvider);
+};
 
-//    eventTds->setTrigger(overlayRoot->getL1T().getTriggerWord());
-//    eventTds->setTriggerWordTwo(overlayRoot->getL1T().getTriggerWordTwo());
-//    eventTds->setGemPrescale(overlayRoot->getL1T().getGemPrescale());
-//    eventTds->setGltPrescale(overlayRoot->getL1T().getGltPrescale());
-//    eventTds->setPrescaleExpired(overlayRoot->getL1T().getPrescaleExpired());
+typedef OverlayCnv<EventOverlayCnvTraits> EventOverlayCnv;
 
-    // Return the pointer to it
-    refpObject = eventTds;
+DECLARE_CONVERTER_FACTORY(EventOverlayCnv);
 
-    return status;
-}
-    
-StatusCode EventOverlayCnv::createRep(DataObject* pObject, IOpaqueAddress*&)
+StatusCode EventOverlayCnvTraits::createRep(TdsType& evtTds, EventOverlay& overlayRoot, IDataProviderSvc* dataProvider)
 {
-    StatusCode status = StatusCode::SUCCESS;
-
-    if (!m_overlayOutputSvc) return status;
+    UInt_t    evtId    = evtTds.event();
+    UInt_t    runId    = evtTds.run();
+    TimeStamp timeObj  = evtTds.time();
+    Double_t  liveTime = evtTds.livetime();
 
-    // Retrieve the pointer to the digi
-    EventOverlay* overlayRoot = m_overlayOutputSvc->getRootEventOverlay();
-
-    // Cast back to our TDS object
-    Event::EventOverlay* evtTds = dynamic_cast<Event::EventOverlay*>(pObject);
-
-    UInt_t    evtId    = evtTds->event();
-    UInt_t    runId    = evtTds->run();
-    TimeStamp timeObj  = evtTds->time();
-    Double_t  liveTime = evtTds->livetime();
-
-    SmartDataPtr<Event::SrcOverlay> srcTds(dataProvider(), OverlayEventModel::Overlay::SrcOverlay);
+    SmartDataPtr<Event::SrcOverlay> srcTds(dataProvider, OverlayEventModel::Overlay::SrcOverlay);
     Bool_t fromMc = (srcTds) ? srcTds->fromMc() : true;
 
-//    SmartDataPtr<TriRowBitsTds::TriRowBits> triRowBitsTds(dataProvider(), "/Event/TriRowBits");
+//    SmartDataPtr<TriRowBitsTds::TriRowBits> triRowBitsTds(dataProvider, "/Event/TriRowBits");
 //    UInt_t digiRowBits[16]={0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
 //    UInt_t trgReqRowBits[16]={0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
 //
-//    if (triRowBitsTds) 
+//    if (triRowBitsTds)
 //    {
 //        unsigned int iTower;
 //        for(iTower = 0; iTower < 16; iTower++)
@@ -229,19 +67,19 @@ StatusCode EventOverlayCnv::createRep(DataObject* pObject, IOpaqueAddress*&)
 //        }
 //    }
 //
-//    L1T levelOne(evtTds->trigger(), digiRowBits, trgReqRowBits);
-//    levelOne.setTriggerWordTwo(evtTds->triggerWordTwo());
-//    levelOne.setPrescale(evtTds->gemPrescale(), evtTds->gltPrescale(), evtTds->prescaleExpired());
-
-    overlayRoot->initialize(evtId, runId, timeObj.time(), liveTime, fromMc);
-    
-//    SmartDataPtr<LdfEvent::LdfTime> timeTds(dataProvider(), "/Event/Time");
-//    if (timeTds) 
+//    L1T levelOne(evtTds.trigger(), digiRowBits, trgReqRowBits);
+//    levelOne.setTriggerWordTwo(evtTds.triggerWordTwo());
+//    levelOne.setPrescale(evtTds.gemPrescale(), evtTds.gltPrescale(), evtTds.prescaleExpired());
+
+    overlayRoot.initialize(evtId, runId, timeObj.time(), liveTime, fromMc);
+
+//    SmartDataPtr<LdfEvent::LdfTime> timeTds(dataProvider, "/Event/Time");
+//    if (timeTds)
 //    {
-//        overlayRoot->setEbfTime(timeTds->timeSec(), timeTds->timeNanoSec(),
-//                             timeTds->upperPpcTimeBaseWord(), 
+//        overlayRoot.setEbfTime(timeTds->timeSec(), timeTds->timeNanoSec(),
+//                             timeTds->upperPpcTimeBaseWord(),
 //                             timeTds->lowerPpcTimeBaseWord());
 //    }
 
-    return status;
+    return StatusCode::SUCCESS;
 }
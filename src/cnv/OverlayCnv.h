@@ -0,0 +1,162 @@
+/** @file OverlayCnv.h
+
+    @brief declaration and implementation of the OverlayCnv converter template
+
+$Header$
+
+*/
+
+#ifndef OverlayCnv_h
+#define OverlayCnv_h
+
+#include "Overlay/IOverlayDataSvc.h"
+#include "Overlay/OverlayReadCuts.h"
+
+#include "GaudiKernel/Converter.h"
+#include "GaudiKernel/SvcFactory.h"
+#include "GaudiKernel/CnvFactory.h"
+#include "GaudiKernel/SmartIF.h"
+#include "GaudiKernel/DataObject.h"
+#include "GaudiKernel/MsgStream.h"
+
+#include "GaudiKernel/IOpaqueAddress.h"
+#include "GaudiKernel/IRegistry.h"
+#include "GaudiKernel/IDataProviderSvc.h"
+
+#include "GlastSvc/EventSelector/IGlastCnv.h"
+
+#include <string>
+
+class EventOverlay;
+
+/** @class OverlayCnv
+    @brief Converter between an overlay TDS object and its part of the EventOverlay, for the type
+           described by the Traits class
+
+    The Traits class provides
+    - typedef TdsType, the TDS class converted
+    - static const CLID& classID(), its class id
+    - static std::string path(), its path below the overlay root
+    - static const char* name(), the name used for messages
+    - enum {registerOutput = true/false}, whether the path is written to the output file
+    - static DataObject* createObj(EventOverlay&, const OverlayColumns*, const OverlaySnapshot*, const OverlayReadCuts&),
+      builds the TDS object from the input, leaving out what the declared cuts reject
+    - static StatusCode createRep(TdsType&, EventOverlay&, IDataProviderSvc*), copies it to the output
+
+    Everything else (the registry walk to the input data service, looking up the output service, the
+    output path registration) is common to all overlay types and lives here. The type specific
+    transfers are resolved at compile time.
+*/
+template <class Traits> class OverlayCnv : virtual public IGlastCnv, public Converter
+{
+public:
+    typedef typename Traits::TdsType TdsType;
+
+    /**
+        Constructor for this converter
+        @param svc a ISvcLocator interface to find services
+    */
+    OverlayCnv(ISvcLocator* svc) : Converter(EXCEL_StorageType, Traits::classID(), svc),
+                                   m_path(Traits::path()), m_overlayOutputSvc(0) {}
+
+    virtual ~OverlayCnv() {}
+
+    static const CLID&         classID()     {return Traits::classID();}
+    static const unsigned char storageType() {return EXCEL_StorageType;}
+
+    /// Initialize the converter
+    virtual StatusCode initialize();
+
+    /// Finalize the converter
+    virtual StatusCode finalize() {return Converter::finalize();}
+
+    /// Retrieve the class type of objects the converter produces.
+    virtual const CLID& objType() const {return classID();}
+
+    /// Retrieve the class type of the data store the converter uses.
+    virtual long repSvcType() const {return Converter::i_repSvcType();}
+
+    /// Create the TDS object from the EventOverlay of the input data service owning the address
+    virtual StatusCode createObj(IOpaqueAddress* pAddress, DataObject*& refpObject);
+
+    /// Copy the TDS object to the EventOverlay of the output service
+    virtual StatusCode createRep(DataObject* pObject, IOpaqueAddress*& refpAddress);
+
+    /// Methods to set and return the path in TDS for output of this converter
+    virtual void setPath(const std::string& path) {m_path = path;}
+    virtual const std::string& getPath() const    {return m_path;}
+
+private:
+    std::string      m_path;
+
+    IOverlayDataSvc* m_overlayOutputSvc;
+};
+
+template <class Traits> StatusCode OverlayCnv<Traits>::initialize()
+{
+    MsgStream log(msgSvc(), Traits::name());
+    StatusCode status = Converter::initialize();
+
+    // We're going rogue here, look up the OverlayDataSvc and use this as
+    // our data provider instead of EventCnvSvc
+    IDataProviderSvc* tmpService = 0;
+    if (serviceLocator()->service("OverlayOutputSvc", tmpService, false).isFailure())
+    {
+        log << MSG::INFO << "No OverlayOutputSvc available, no output conversion will be performed" << endreq;
+        m_overlayOutputSvc = 0;
+    }
+    else
+    {
+        // Need to up convert to point to the OverlayDataSvc
+        m_overlayOutputSvc = SmartIF<IOverlayDataSvc>(tmpService);
+    }
+
+    if (m_overlayOutputSvc && Traits::registerOutput) m_overlayOutputSvc->registerOutputPath(m_path);
+
+    return status;
+}
+
+// (To TDS) Conversion stuff
+template <class Traits> StatusCode OverlayCnv<Traits>::createObj(IOpaqueAddress* pOpaque, DataObject*& refpObject)
+{
+    // If no opaque address then there is nothing to do
+    if (!pOpaque) return StatusCode::FAILURE;
+
+    // Recover the pointer to the registry
+    IRegistry* pRegistry = pOpaque->registry();
+
+    if (!pRegistry) return StatusCode::FAILURE;
+
+    // Recover pointer to the data provider service
+    IDataProviderSvc* pDataSvc = pRegistry->dataSvc();
+
+    if (!pDataSvc) return StatusCode::FAILURE;
+
+    IOverlayDataSvc* inputDataSvc = SmartIF<IOverlayDataSvc>(pDataSvc);
+
+    if (!inputDataSvc) return StatusCode::FAILURE;
+
+    // Retrieve the pointer to the digi
+    EventOverlay* overlayRoot = inputDataSvc->getRootEventOverlay();
+
+    // If no overlayRoot then we are not inputting from a file
+    refpObject = overlayRoot ? Traits::createObj(*overlayRoot, 
+                                                 inputDataSvc->getOverlayColumns(), 
+                                                 inputDataSvc->getOverlaySnapshot(), 
+                                                 inputDataSvc->getReadCuts()) : 0;
+
+    return StatusCode::SUCCESS;
+}
+
+template <class Traits> StatusCode OverlayCnv<Traits>::createRep(DataObject* pObject, IOpaqueAddress*&)
+{
+    if (!m_overlayOutputSvc || !pObject) return StatusCode::SUCCESS;
+
+    // Retrieve the pointer to the digi
+    EventOverlay* overlayRoot = m_overlayOutputSvc->getRootEventOverlay();
+
+    // The conversion service picks the converter by class id so the object is known to be ours
+    return Traits::createRep(*static_cast<TdsType*>(pObject), *overlayRoot, dataProvider());
+}
+
+#endif
@@ -0,0 +1,824 @@
+/**  @file OverlayTdsFill.cxx
+@brief implementation of the OverlayTdsFill functions
+
+$Header$
+*/
+
+#include "OverlayTdsFill.h"
+
+#include "OverlayEvent/EventOverlay.h"
+#include "OverlayEvent/AcdOverlay.h"
+#include "OverlayEvent/CalOverlay.h"
+#include "OverlayEvent/DiagDataOverlay.h"
+#include "OverlayEvent/GemOverlay.h"
+#include "OverlayEvent/PtOverlay.h"
+#include "OverlayEvent/SrcOverlay.h"
+#include "OverlayEvent/TkrOverlay.h"
+
+#include "overlayRootData/EventOverlay.h"
+#include "Overlay/OverlayColumns.h"
+#include "Overlay/OverlayEventView.h"
+#include "Overlay/OverlaySnapshot.h"
+#include "Overlay/OverlayReadCuts.h"
+
+#include "RootConvert/Utilities/Toolkit.h"
+
+// The fill functions below fill an empty (or just cleared) TDS object from the input, they are
+// shared by the create functions and by refill. The collection fills return false if the input
+// has no such collection.
+
+static bool fillTkrOverlayCol(Event::TkrOverlayCol& tkrOverlayTdsCol, EventOverlay& overlayRoot, const OverlayColumns* columns, const OverlaySnapshot* snapshot, const OverlayReadCuts& cuts)
+{
+    // Nobody merges the tracker, don't build anything
+    if (!cuts.needs(OverlayReadCuts::Tkr)) return true;
+
+    // A columnar input has the tracker data in its columns rather than the EventOverlay
+    if (columns)
+    {
+        tkrOverlayTdsCol.reserve(columns->numTkr());
+
+        for(unsigned int row = 0; row < columns->numTkr(); row++)
+        {
+            idents::TowerId         towerTds(columns->tkrTowerX[row], columns->tkrTowerY[row]);
+            idents::GlastAxis::axis axisTds = columns->tkrView[row] == 0 ? idents::GlastAxis::X : idents::GlastAxis::Y;
+            int                     totTds[2] = {columns->tkrToT0[row], columns->tkrToT1[row]};
+
+            Event::TkrOverlay *tkrDigiTds = new Event::TkrOverlay(columns->tkrBilayer[row],
+                                                                  axisTds,
+                                                                  towerTds,
+                                                                  totTds,
+                                                                  Event::TkrOverlay::DIGI_OVERLAY);
+            int lastController0Strip = columns->tkrLastC0Strip[row];
+
+            for(unsigned int idx = columns->tkrStripOffset[row]; idx < columns->tkrStripOffset[row+1]; idx++)
+            {
+                int strip = columns->tkrStrips[idx];
+
+                if (strip <= lastController0Strip) tkrDigiTds->addC0Hit(strip);
+                else                               tkrDigiTds->addC1Hit(strip);
+            }
+
+            tkrOverlayTdsCol.push_back(tkrDigiTds);
+        }
+
+        return true;
+    }
+
+    // A snapshot input has records holding the TDS values
+    if (snapshot)
+    {
+        const unsigned short* strips = snapshot->strips();
+
+        tkrOverlayTdsCol.reserve(snapshot->numTkr());
+
+        for(unsigned int row = 0; row < snapshot->numTkr(); row++)
+        {
+            const OverlaySnapshot::TkrRecord& record = snapshot->tkr(row);
+
+            idents::TowerId         towerTds(record.towerX, record.towerY);
+            idents::GlastAxis::axis axisTds = record.view == 0 ? idents::GlastAxis::X : idents::GlastAxis::Y;
+            int                     totTds[2] = {record.tot[0], record.tot[1]};
+
+            Event::TkrOverlay *tkrDigiTds = new Event::TkrOverlay(record.bilayer,
+                                                                  axisTds,
+                                                                  towerTds,
+                                                                  totTds,
+                                                                  Event::TkrOverlay::DIGI_OVERLAY);
+
+            for(const unsigned short* stripEnd = strips + record.numStrips; strips != stripEnd; strips++)
+            {
+                if (*strips <= record.lastC0Strip) tkrDigiTds->addC0Hit(*strips);
+                else                               tkrDigiTds->addC1Hit(*strips);
+            }
+
+            tkrOverlayTdsCol.push_back(tkrDigiTds);
+        }
+
+        return true;
+    }
+
+    // Check that we have a TkrDigi collection in the input root data
+    const TObjArray *tkrOverlayRootCol = overlayRoot.getTkrOverlayCol();
+    if (!tkrOverlayRootCol) return false;
+
+    // Make a TIter object for traversing the collection
+    TIter tkrOverlayIter(tkrOverlayRootCol);
+
+    tkrOverlayTdsCol.reserve(tkrOverlayRootCol->GetEntriesFast());
+
+    // Loop through input digis and make TDS object
+    TkrOverlay *tkrOverlayRoot = 0;
+    while ((tkrOverlayRoot = (TkrOverlay*)tkrOverlayIter.Next())!=0)
+    {
+        TowerId towerRoot = tkrOverlayRoot->getTower();
+        idents::TowerId towerTds(towerRoot.ix(), towerRoot.iy());
+        GlastAxis::axis axisRoot = tkrOverlayRoot->getView();
+        idents::GlastAxis::axis axisTds =
+            (axisRoot == GlastAxis::X) ? idents::GlastAxis::X : idents::GlastAxis::Y;
+        int totTds[2] = { tkrOverlayRoot->getToT(0), tkrOverlayRoot->getToT(1)};
+        Event::TkrOverlay *tkrDigiTds = new Event::TkrOverlay(tkrOverlayRoot->getBilayer(),
+                                                              axisTds,
+                                                              towerTds,
+                                                              totTds,
+                                                              Event::TkrOverlay::DIGI_OVERLAY);
+        int lastController0Strip = tkrOverlayRoot->getLastController0Strip();
+        unsigned int numStrips = tkrOverlayRoot->getNumHits();
+        unsigned int iHit;
+        for (iHit = 0; iHit < numStrips; iHit++)
+        {
+            int strip = tkrOverlayRoot->getHit(iHit);
+            if (strip <= lastController0Strip)
+            {
+                tkrDigiTds->addC0Hit(strip);
+            }
+            else
+            {
+                tkrDigiTds->addC1Hit(strip);
+            }
+        }
+
+        tkrOverlayTdsCol.push_back(tkrDigiTds);
+    }
+
+    return true;
+}
+
+static bool fillCalOverlayCol(Event::CalOverlayCol& calOverlayTdsCol, EventOverlay& overlayRoot, const OverlayColumns* columns, const OverlaySnapshot* snapshot, const OverlayReadCuts& cuts)
+{
+    // Nobody merges the calorimeter, don't build anything
+    if (!cuts.needs(OverlayReadCuts::Cal)) return true;
+
+    // A columnar input has the calorimeter data in its columns rather than the EventOverlay
+    if (columns)
+    {
+        calOverlayTdsCol.reserve(columns->numCal());
+
+        for(unsigned int row = 0; row < columns->numCal(); row++)
+        {
+            if (!cuts.acceptCal(columns->calEnergy[row])) continue;
+
+            idents::CalXtalId idTds(columns->calTower[row], columns->calLayer[row], columns->calColumn[row]);
+            Point             posTds(columns->calPosX[row], columns->calPosY[row], columns->calPosZ[row]);
+
+            Event::CalOverlay *calOverlayTds = new Event::CalOverlay(idTds, posTds, columns->calEnergy[row]);
+
+            calOverlayTds->setStatus(columns->calStatus[row]);
+
+            calOverlayTds->addToStatus(Event::CalOverlay::DIGI_OVERLAY);
+
+            calOverlayTdsCol.push_back(calOverlayTds);
+        }
+
+        return true;
+    }
+
+    // A snapshot input has records holding the TDS values
+    if (snapshot)
+    {
+        calOverlayTdsCol.reserve(snapshot->numCal());
+
+        for(unsigned int row = 0; row < snapshot->numCal(); row++)
+        {
+            const OverlaySnapshot::CalRecord& record = snapshot->cal(row);
+
+            if (!cuts.acceptCal(record.energy)) continue;
+
+            idents::CalXtalId idTds(record.tower, record.layer, record.column);
+            Point             posTds(record.position[0], record.position[1], record.position[2]);
+
+            Event::CalOverlay *calOverlayTds = new Event::CalOverlay(idTds, posTds, record.energy);
+
+            calOverlayTds->setStatus(record.status);
+
+            calOverlayTds->addToStatus(Event::CalOverlay::DIGI_OVERLAY);
+
+            calOverlayTdsCol.push_back(calOverlayTds);
+        }
+
+        return true;
+    }
+
+    // Check that we have a TkrDigi collection in the input root data
+    const TObjArray *calOverlayRootCol = overlayRoot.getCalOverlayCol();
+    if (!calOverlayRootCol) return false;
+
+    // Make a TIter object for traversing the collection
+    TIter CalOverlayIter(calOverlayRootCol);
+
+    calOverlayTdsCol.reserve(calOverlayRootCol->GetEntriesFast());
+
+    CalOverlay *calOverlayRoot = 0;
+    while ((calOverlayRoot = (CalOverlay*)CalOverlayIter.Next())!=0)
+    {
+        if (!cuts.acceptCal(calOverlayRoot->getEnergy())) continue;
+
+        CalXtalId idRoot = calOverlayRoot->getPackedId();
+        idents::CalXtalId idTds(idRoot.getTower(), idRoot.getLayer(), idRoot.getColumn());
+
+        const TVector3& posRoot = calOverlayRoot->getPosition();
+        Point posTds(posRoot.X(),posRoot.Y(),posRoot.Z());
+
+        Event::CalOverlay *calOverlayTds = new Event::CalOverlay(idTds, posTds, calOverlayRoot->getEnergy());
+
+        calOverlayTds->setStatus(calOverlayRoot->getStatus());
+
+        calOverlayTds->addToStatus(Event::CalOverlay::DIGI_OVERLAY);
+
+        calOverlayTdsCol.push_back(calOverlayTds);
+    }
+
+    return true;
+}
+
+static bool fillAcdOverlayCol(Event::AcdOverlayCol& acdOverlayTdsCol, EventOverlay& overlayRoot, const OverlayColumns* columns, const OverlaySnapshot* snapshot, const OverlayReadCuts& cuts)
+{
+    // Nobody merges the ACD, don't build anything
+    if (!cuts.needs(OverlayReadCuts::Acd)) return true;
+
+    // A columnar input has the ACD data in its columns rather than the EventOverlay
+    if (columns)
+    {
+        acdOverlayTdsCol.reserve(columns->numAcd());
+
+        for(unsigned int row = 0; row < columns->numAcd(); row++)
+        {
+            idents::VolumeIdentifier volIdTds;
+            volIdTds.init(columns->acdVolId[row], columns->acdVolIdSize[row]);
+
+            idents::AcdId acdIdTds(volIdTds);
+
+            if (!cuts.acceptAcd(acdIdTds.tile(), columns->acdEnergy[row])) continue;
+
+            HepPoint3D    positionTds(columns->acdPosX[row], columns->acdPosY[row], columns->acdPosZ[row]);
+
+            Event::AcdOverlay* acdOverlayTds = new Event::AcdOverlay(volIdTds, acdIdTds, columns->acdEnergy[row], positionTds);
+
+            acdOverlayTds->setStatus(columns->acdStatus[row]);
+
+            acdOverlayTdsCol.push_back(acdOverlayTds);
+        }
+
+        return true;
+    }
+
+    // A snapshot input has records holding the TDS values, including the AcdId
+    if (snapshot)
+    {
+        acdOverlayTdsCol.reserve(snapshot->numAcd());
+
+        for(unsigned int row = 0; row < snapshot->numAcd(); row++)
+        {
+            const OverlaySnapshot::AcdRecord& record = snapshot->acd(row);
+
+            idents::AcdId acdIdTds(record.layer, record.face, record.row, record.column);
+
+            if (!cuts.acceptAcd(acdIdTds.tile(), record.energy)) continue;
+
+            idents::VolumeIdentifier volIdTds;
+            volIdTds.init(record.volId, record.volIdSize);
+
+            HepPoint3D positionTds(record.position[0], record.position[1], record.position[2]);
+
+            Event::AcdOverlay* acdOverlayTds = new Event::AcdOverlay(volIdTds, acdIdTds, record.energy, positionTds);
+
+            acdOverlayTds->setStatus(record.status);
+
+            acdOverlayTdsCol.push_back(acdOverlayTds);
+        }
+
+        return true;
+    }
+
+    // Check that we have a AcdOverlay collection in the input root data
+    const TObjArray *acdOverlayRootCol = overlayRoot.getAcdOverlayCol();
+    if (!acdOverlayRootCol) return false;
+
+    // Make a TIter object for traversing the collection
+    TIter acdOverlayIter(acdOverlayRootCol);
+
+    acdOverlayTdsCol.reserve(acdOverlayRootCol->GetEntriesFast());
+
+    AcdOverlay *acdOverlayRoot = 0;
+    while ((acdOverlayRoot = (AcdOverlay*)acdOverlayIter.Next())!=0)
+    {
+        AcdId         acdIdRoot = acdOverlayRoot->getAcdId();
+        idents::AcdId acdIdTds;
+        acdIdTds = RootPersistence::convert(acdIdRoot) ;
+
+        double energyTds = acdOverlayRoot->getEnergyDep();
+
+        if (!cuts.acceptAcd(acdIdTds.tile(), energyTds)) continue;
+
+        VolumeIdentifier         volIdRoot = acdOverlayRoot->getVolId();
+        idents::VolumeIdentifier volIdTds;
+        volIdTds = RootPersistence::convert(volIdRoot) ;
+
+        TVector3   positionRoot = acdOverlayRoot->getPosition();
+        HepPoint3D positionTds(positionRoot.X(), positionRoot.Y(), positionRoot.Z());
+
+        Event::AcdOverlay* acdOverlayTds = new Event::AcdOverlay(volIdTds, acdIdTds, energyTds, positionTds);
+
+        acdOverlayTds->setStatus(acdOverlayRoot->getStatus());
+
+        acdOverlayTdsCol.push_back(acdOverlayTds);
+    }
+
+    return true;
+}
+
+static void fillEventOverlay(Event::EventOverlay& eventTds, EventOverlay& overlayRoot)
+{
+    // Initialize the overlay object
+    unsigned int eventIdRoot = overlayRoot.getEventId();
+    unsigned int runIdRoot   = overlayRoot.getRunId();
+
+    // Check to see if the event and run ids have already been set.
+    eventTds.setEvent(eventIdRoot);
+    eventTds.setRun(runIdRoot);
+
+    TimeStamp timeObj(overlayRoot.getTimeStamp());
+    eventTds.setTime(timeObj);
+
+    eventTds.setLivetime(overlayRoot.getLiveTime());
+
+    return;
+}
+
+static void fillGemOverlay(Event::GemOverlay& gemTds, EventOverlay& overlayRoot)
+{
+    // Extract GEM information from input digis
+    const GemOverlay &gemRoot = overlayRoot.getGemOverlay();
+
+    GemOverlayTileList tileListRoot = gemRoot.getTileList();
+    Event::GemOverlayTileList tileListTds(tileListRoot.getXzm(),
+                                          tileListRoot.getXzp(),
+                                          tileListRoot.getYzm(),
+                                          tileListRoot.getYzp(),
+                                          tileListRoot.getXy(),
+                                          tileListRoot.getRbn(),
+                                          tileListRoot.getNa());
+
+    gemTds.initTrigger(gemRoot.getTkrVector(), gemRoot.getRoiVector(),
+            gemRoot.getCalLeVector(), gemRoot.getCalHeVector(),
+            gemRoot.getCnoVector(), gemRoot.getConditionSummary(),
+            gemRoot.getMissed(), tileListTds);
+
+    Event::GemOverlayOnePpsTime ppsTimeTds(gemRoot.getOnePpsTime().getTimebase(),
+                            gemRoot.getOnePpsTime().getSeconds());
+    Event::GemOverlayDataCondArrivalTime gemCondTimeTds;
+    gemCondTimeTds.init(gemRoot.getCondArrTime().condArr());
+    gemTds.initSummary(gemRoot.getLiveTime(), gemRoot.getPrescaled(),
+                        gemRoot.getDiscarded(), gemCondTimeTds,
+                        gemRoot.getTriggerTime(), ppsTimeTds,
+                        gemRoot.getDeltaEventTime(),
+                        gemRoot.getDeltaWindowOpenTime());
+
+    return;
+}
+
+static void fillPtOverlay(Event::PtOverlay& ptTds, EventOverlay& overlayRoot)
+{
+    // Extract GEM information from input digis
+    const PtOverlay &ptRoot = overlayRoot.getPtOverlay();
+
+    float sc_position[3];
+
+    sc_position[0] = ptRoot.getSC_Position()[0];
+    sc_position[1] = ptRoot.getSC_Position()[1];
+    sc_position[2] = ptRoot.getSC_Position()[2];
+
+    ptTds.initPtOverlay(ptRoot.getStartTime(),
+                         sc_position,
+                         ptRoot.getLatGeo(),
+                         ptRoot.getLonGeo(),
+                         ptRoot.getLatMag(),
+                         ptRoot.getRadGeo(),
+                         ptRoot.getRaScz(),
+                         ptRoot.getDecScz(),
+                         ptRoot.getRaScx(),
+                         ptRoot.getDecScx(),
+                         ptRoot.getZenithScz(),
+                         ptRoot.getB(),
+                         ptRoot.getL(),
+                         ptRoot.getLambda(),
+                         ptRoot.getR(),
+                         ptRoot.getBEast(),
+                         ptRoot.getBNorth(),
+                         ptRoot.getBUp(),
+                         ptRoot.getLATMode(),
+                         ptRoot.getLATConfig(),
+                         ptRoot.getDataQual(),
+                         ptRoot.getRockAngle(),
+                         ptRoot.getLivetimeFrac()
+                         );
+
+    return;
+}
+
+static void fillSrcOverlay(Event::SrcOverlay& overlayTds, EventOverlay& overlayRoot)
+{
+    // Initialize the overlay object
+    overlayTds.initialize(overlayRoot.getFromMc());
+
+    return;
+}
+
+// The view fills below append the rows of one subsystem to the OverlayEventView, with the same 
+// values and cuts as the collection fills above but without building TDS objects
+
+static void addTkrViewRow(OverlayEventView& view, short towerX, short towerY, short bilayer, short axis, 
+                          short tot0, short tot1, short lastC0Strip)
+{
+    view.tkrTowerX.push_back(towerX);
+    view.tkrTowerY.push_back(towerY);
+    view.tkrBilayer.push_back(bilayer);
+    view.tkrView.push_back(axis);
+    view.tkrToT0.push_back(tot0);
+    view.tkrToT1.push_back(tot1);
+    view.tkrLastC0Strip.push_back(lastC0Strip);
+}
+
+static void addCalViewRow(OverlayEventView& view, const idents::CalXtalId& xtalId, double energy, 
+                          double x, double y, double z, unsigned int status)
+{
+    view.calTower.push_back(xtalId.getTower());
+    view.calLayer.push_back(xtalId.getLayer());
+    view.calColumn.push_back(xtalId.getColumn());
+    view.calEnergy.push_back(energy);
+    view.calPosX.push_back(x);
+    view.calPosY.push_back(y);
+    view.calPosZ.push_back(z);
+    view.calStatus.push_back(status | Event::CalOverlay::DIGI_OVERLAY);
+}
+
+static void addAcdViewRow(OverlayEventView& view, const idents::VolumeIdentifier& volId, const idents::AcdId& acdId, 
+                          double energy, double x, double y, double z, unsigned int status)
+{
+    view.acdVolId.push_back(volId.getValue());
+    view.acdVolIdSize.push_back(volId.size());
+    view.acdLayer.push_back(acdId.layer());
+    view.acdFace.push_back(acdId.face());
+    view.acdRow.push_back(acdId.row());
+    view.acdColumn.push_back(acdId.column());
+    view.acdEnergy.push_back(energy);
+    view.acdPosX.push_back(x);
+    view.acdPosY.push_back(y);
+    view.acdPosZ.push_back(z);
+    view.acdStatus.push_back(status);
+}
+
+static void fillTkrView(OverlayEventView& view, EventOverlay& overlayRoot, const OverlayColumns* columns, const OverlaySnapshot* snapshot, const OverlayReadCuts& cuts)
+{
+    if (!cuts.needs(OverlayReadCuts::Tkr)) return;
+
+    if (columns)
+    {
+        for(unsigned int row = 0; row < columns->numTkr(); row++)
+        {
+            addTkrViewRow(view, columns->tkrTowerX[row], columns->tkrTowerY[row], columns->tkrBilayer[row], columns->tkrView[row],
+                          columns->tkrToT0[row], columns->tkrToT1[row], columns->tkrLastC0Strip[row]);
+
+            view.tkrStrips.insert(view.tkrStrips.end(), columns->tkrStrips.begin() + columns->tkrStripOffset[row],
+                                                        columns->tkrStrips.begin() + columns->tkrStripOffset[row+1]);
+            view.tkrStripOffset.push_back(view.tkrStrips.size());
+        }
+    }
+    else if (snapshot)
+    {
+        const unsigned short* strips = snapshot->strips();
+
+        for(unsigned int row = 0; row < snapshot->numTkr(); row++)
+        {
+            const OverlaySnapshot::TkrRecord& record = snapshot->tkr(row);
+
+            addTkrViewRow(view, record.towerX, record.towerY, record.bilayer, record.view, 
+                          record.tot[0], record.tot[1], record.lastC0Strip);
+
+            view.tkrStrips.insert(view.tkrStrips.end(), strips, strips + record.numStrips);
+            view.tkrStripOffset.push_back(view.tkrStrips.size());
+
+            strips += record.numStrips;
+        }
+    }
+    else if (const TObjArray* tkrOverlayRootCol = overlayRoot.getTkrOverlayCol())
+    {
+        TIter       tkrOverlayIter(tkrOverlayRootCol);
+        TkrOverlay* tkrOverlayRoot = 0;
+
+        while ((tkrOverlayRoot = (TkrOverlay*)tkrOverlayIter.Next())!=0)
+        {
+            TowerId towerRoot = tkrOverlayRoot->getTower();
+
+            addTkrViewRow(view, towerRoot.ix(), towerRoot.iy(), tkrOverlayRoot->getBilayer(), 
+                          tkrOverlayRoot->getView() == GlastAxis::X ? 0 : 1,
+                          tkrOverlayRoot->getToT(0), tkrOverlayRoot->getToT(1), tkrOverlayRoot->getLastController0Strip());
+
+            for(unsigned int iHit = 0; iHit < tkrOverlayRoot->getNumHits(); iHit++)
+            {
+                view.tkrStrips.push_back(tkrOverlayRoot->getHit(iHit));
+            }
+
+            view.tkrStripOffset.push_back(view.tkrStrips.size());
+        }
+    }
+
+    return;
+}
+
+static void fillCalView(OverlayEventView& view, EventOverlay& overlayRoot, const OverlayColumns* columns, const OverlaySnapshot* snapshot, const OverlayReadCuts& cuts)
+{
+    if (!cuts.needs(OverlayReadCuts::Cal)) return;
+
+    if (columns)
+    {
+        for(unsigned int row = 0; row < columns->numCal(); row++)
+        {
+            if (!cuts.acceptCal(columns->calEnergy[row])) continue;
+
+            idents::CalXtalId xtalId(columns->calTower[row], columns->calLayer[row], columns->calColumn[row]);
+
+            addCalViewRow(view, xtalId, columns->calEnergy[row], 
+                          columns->calPosX[row], columns->calPosY[row], columns->calPosZ[row], columns->calStatus[row]);
+        }
+    }
+    else if (snapshot)
+    {
+        for(unsigned int row = 0; row < snapshot->numCal(); row++)
+        {
+            const OverlaySnapshot::CalRecord& record = snapshot->cal(row);
+
+            if (!cuts.acceptCal(record.energy)) continue;
+
+            idents::CalXtalId xtalId(record.tower, record.layer, record.column);
+
+            addCalViewRow(view, xtalId, record.energy, 
+                          record.position[0], record.position[1], record.position[2], record.status);
+        }
+    }
+    else if (const TObjArray* calOverlayRootCol = overlayRoot.getCalOverlayCol())
+    {
+        TIter       calOverlayIter(calOverlayRootCol);
+        CalOverlay* calOverlayRoot = 0;
+
+        while ((calOverlayRoot = (CalOverlay*)calOverlayIter.Next())!=0)
+        {
+            if (!cuts.acceptCal(calOverlayRoot->getEnergy())) continue;
+
+            CalXtalId         idRoot = calOverlayRoot->getPackedId();
+            idents::CalXtalId xtalId(idRoot.getTower(), idRoot.getLayer(), idRoot.getColumn());
+            const TVector3&   posRoot = calOverlayRoot->getPosition();
+
+            addCalViewRow(view, xtalId, calOverlayRoot->getEnergy(), 
+                          posRoot.X(), posRoot.Y(), posRoot.Z(), calOverlayRoot->getStatus());
+        }
+    }
+
+    return;
+}
+
+static void fillAcdView(OverlayEventView& view, EventOverlay& overlayRoot, const OverlayColumns* columns, const OverlaySnapshot* snapshot, const OverlayReadCuts& cuts)
+{
+    if (!cuts.needs(OverlayReadCuts::Acd)) return;
+
+    if (columns)
+    {
+        for(unsigned int row = 0; row < columns->numAcd(); row++)
+        {
+            idents::VolumeIdentifier volId;
+            volId.init(columns->acdVolId[row], columns->acdVolIdSize[row]);
+
+            idents::AcdId acdId(volId);
+
+            if (!cuts.acceptAcd(acdId.tile(), columns->acdEnergy[row])) continue;
+
+            addAcdViewRow(view, volId, acdId, columns->acdEnergy[row], 
+                          columns->acdPosX[row], columns->acdPosY[row], columns->acdPosZ[row], columns->acdStatus[row]);
+        }
+    }
+    else if (snapshot)
+    {
+        for(unsigned int row = 0; row < snapshot->numAcd(); row++)
+        {
+            const OverlaySnapshot::AcdRecord& record = snapshot->acd(row);
+
+            idents::AcdId acdId(record.layer, record.face, record.row, record.column);
+
+            if (!cuts.acceptAcd(acdId.tile(), record.energy)) continue;
+
+            idents::VolumeIdentifier volId;
+            volId.init(record.volId, record.volIdSize);
+
+            addAcdViewRow(view, volId, acdId, record.energy, 
+                          record.position[0], record.position[1], record.position[2], record.status);
+        }
+    }
+    else if (const TObjArray* acdOverlayRootCol = overlayRoot.getAcdOverlayCol())
+    {
+        TIter       acdOverlayIter(acdOverlayRootCol);
+        AcdOverlay* acdOverlayRoot = 0;
+
+        while ((acdOverlayRoot = (AcdOverlay*)acdOverlayIter.Next())!=0)
+        {
+            AcdId         acdIdRoot = acdOverlayRoot->getAcdId();
+            idents::AcdId acdId;
+            acdId = RootPersistence::convert(acdIdRoot) ;
+
+            if (!cuts.acceptAcd(acdId.tile(), acdOverlayRoot->getEnergyDep())) continue;
+
+            VolumeIdentifier         volIdRoot = acdOverlayRoot->getVolId();
+            idents::VolumeIdentifier volId;
+            volId = RootPersistence::convert(volIdRoot) ;
+
+            const TVector3& positionRoot = acdOverlayRoot->getPosition();
+
+            addAcdViewRow(view, volId, acdId, acdOverlayRoot->getEnergyDep(), 
+                          positionRoot.X(), positionRoot.Y(), positionRoot.Z(), acdOverlayRoot->getStatus());
+        }
+    }
+
+    return;
+}
+
+void OverlayTdsFill::fillEventView(OverlayEventView& view, EventOverlay& overlayRoot, const OverlayColumns* columns, const OverlaySnapshot* snapshot, const OverlayReadCuts& cuts)
+{
+    view.clear();
+
+    fillTkrView(view, overlayRoot, columns, snapshot, cuts);
+    fillCalView(view, overlayRoot, columns, snapshot, cuts);
+    fillAcdView(view, overlayRoot, columns, snapshot, cuts);
+
+    return;
+}
+
+DataObject* OverlayTdsFill::create(const CLID& clID, EventOverlay& overlayRoot, const OverlayColumns* columns, const OverlaySnapshot* snapshot, const OverlayReadCuts& cuts)
+{
+    if      (clID == ObjectVector<Event::TkrOverlay>::classID()) return createTkrOverlayCol(overlayRoot, columns, snapshot, cuts);
+    else if (clID == ObjectVector<Event::CalOverlay>::classID()) return createCalOverlayCol(overlayRoot, columns, snapshot, cuts);
+    else if (clID == ObjectVector<Event::AcdOverlay>::classID()) return createAcdOverlayCol(overlayRoot, columns, snapshot, cuts);
+    else if (clID == Event::GemOverlay::classID())               return createGemOverlay(overlayRoot);
+    else if (clID == Event::DiagDataOverlay::classID())          return createDiagDataOverlay(overlayRoot);
+    else if (clID == Event::PtOverlay::classID())                return createPtOverlay(overlayRoot);
+    else if (clID == Event::SrcOverlay::classID())               return createSrcOverlay(overlayRoot);
+
+    return 0;
+}
+
+bool OverlayTdsFill::refill(DataObject* object, EventOverlay& overlayRoot, const OverlayColumns* columns, const OverlaySnapshot* snapshot, const OverlayReadCuts& cuts)
+{
+    const CLID& clID = object->clID();
+
+    if (clID == Event::EventOverlay::classID())
+    {
+        fillEventOverlay(*static_cast<Event::EventOverlay*>(object), overlayRoot);
+    }
+    else if (clID == ObjectVector<Event::TkrOverlay>::classID())
+    {
+        Event::TkrOverlayCol* tkrOverlayTdsCol = static_cast<Event::TkrOverlayCol*>(object);
+
+        tkrOverlayTdsCol->clear();
+        fillTkrOverlayCol(*tkrOverlayTdsCol, overlayRoot, columns, snapshot, cuts);
+    }
+    else if (clID == ObjectVector<Event::CalOverlay>::classID())
+    {
+        Event::CalOverlayCol* calOverlayTdsCol = static_cast<Event::CalOverlayCol*>(object);
+
+        calOverlayTdsCol->clear();
+        fillCalOverlayCol(*calOverlayTdsCol, overlayRoot, columns, snapshot, cuts);
+    }
+    else if (clID == ObjectVector<Event::AcdOverlay>::classID())
+    {
+        Event::AcdOverlayCol* acdOverlayTdsCol = static_cast<Event::AcdOverlayCol*>(object);
+
+        acdOverlayTdsCol->clear();
+        fillAcdOverlayCol(*acdOverlayTdsCol, overlayRoot, columns, snapshot, cuts);
+    }
+    else if (clID == Event::GemOverlay::classID()) fillGemOverlay(*static_cast<Event::GemOverlay*>(object), overlayRoot);
+    else if (clID == Event::PtOverlay::classID())  fillPtOverlay(*static_cast<Event::PtOverlay*>(object), overlayRoot);
+    else if (clID == Event::SrcOverlay::classID()) fillSrcOverlay(*static_cast<Event::SrcOverlay*>(object), overlayRoot);
+    // The DiagDataOverlay can only be added to, it has to be replaced
+    else return false;
+
+    return true;
+}
+
+bool OverlayTdsFill::clear(DataObject* object)
+{
+    const CLID& clID = object->clID();
+
+    if      (clID == ObjectVector<Event::TkrOverlay>::classID()) static_cast<Event::TkrOverlayCol*>(object)->clear();
+    else if (clID == ObjectVector<Event::CalOverlay>::classID()) static_cast<Event::CalOverlayCol*>(object)->clear();
+    else if (clID == ObjectVector<Event::AcdOverlay>::classID()) static_cast<Event::AcdOverlayCol*>(object)->clear();
+    else return false;
+
+    return true;
+}
+
+DataObject* OverlayTdsFill::createEventOverlay(EventOverlay& overlayRoot)
+{
+    Event::EventOverlay* eventTds = new Event::EventOverlay();
+
+    fillEventOverlay(*eventTds, overlayRoot);
+
+    return eventTds;
+}
+
+DataObject* OverlayTdsFill::createTkrOverlayCol(EventOverlay& overlayRoot, const OverlayColumns* columns, const OverlaySnapshot* snapshot, const OverlayReadCuts& cuts)
+{
+    Event::TkrOverlayCol* tkrOverlayTdsCol = new Event::TkrOverlayCol;
+
+    if (!fillTkrOverlayCol(*tkrOverlayTdsCol, overlayRoot, columns, snapshot, cuts))
+    {
+        delete tkrOverlayTdsCol;
+        return 0;
+    }
+
+    return tkrOverlayTdsCol;
+}
+
+DataObject* OverlayTdsFill::createCalOverlayCol(EventOverlay& overlayRoot, const OverlayColumns* columns, const OverlaySnapshot* snapshot, const OverlayReadCuts& cuts)
+{
+    Event::CalOverlayCol* calOverlayTdsCol = new Event::CalOverlayCol;
+
+    if (!fillCalOverlayCol(*calOverlayTdsCol, overlayRoot, columns, snapshot, cuts))
+    {
+        delete calOverlayTdsCol;
+        return 0;
+    }
+
+    return calOverlayTdsCol;
+}
+
+DataObject* OverlayTdsFill::createAcdOverlayCol(EventOverlay& overlayRoot, const OverlayColumns* columns, const OverlaySnapshot* snapshot, const OverlayReadCuts& cuts)
+{
+    Event::AcdOverlayCol* acdOverlayTdsCol = new Event::AcdOverlayCol;
+
+    if (!fillAcdOverlayCol(*acdOverlayTdsCol, overlayRoot, columns, snapshot, cuts))
+    {
+        delete acdOverlayTdsCol;
+        return 0;
+    }
+
+    return acdOverlayTdsCol;
+}
+
+DataObject* OverlayTdsFill::createGemOverlay(EventOverlay& overlayRoot)
+{
+    Event::GemOverlay* gemTds = new Event::GemOverlay();
+
+    fillGemOverlay(*gemTds, overlayRoot);
+
+    return gemTds;
+}
+
+DataObject* OverlayTdsFill::createDiagDataOverlay(EventOverlay& overlayRoot)
+{
+    // Extract the Diagnostic Data from our input EventOverlay object
+    const DiagDataOverlay& diagDataRoot = overlayRoot.getDiagDataOverlay();
+
+    // Create the new DiagDataOverlay object to put in the TDS
+    Event::DiagDataOverlay* diagDataTds = new Event::DiagDataOverlay();
+
+    // Copy over Cal diagnostic info first
+    int numCalDiags = diagDataRoot.getNumCalDiagnostic();
+
+    for(int idx = 0; idx < numCalDiags; idx++)
+    {
+        const CalDiagDataOverlay& calDiagDataRoot = diagDataRoot.getCalDiagnosticByIndex(idx);
+
+        Event::CalDiagDataOverlay cal(calDiagDataRoot.dataWord(), calDiagDataRoot.tower(), calDiagDataRoot.layer());
+
+        diagDataTds->addCalDiagnostic(cal);
+    }
+
+    // Now come back and copy the Tkr diagnostic info
+    int numTkrDiags = diagDataRoot.getNumTkrDiagnostic();
+
+    for(int idx = 0; idx < numTkrDiags; idx++)
+    {
+        const TkrDiagDataOverlay& tkrDiagDataRoot = diagDataRoot.getTkrDiagnosticByIndex(idx);
+
+        Event::TkrDiagDataOverlay tkr(tkrDiagDataRoot.dataWord(), tkrDiagDataRoot.tower(), tkrDiagDataRoot.gtcc());
+
+        diagDataTds->addTkrDiagnostic(tkr);
+    }
+
+    return diagDataTds;
+}
+
+DataObject* OverlayTdsFill::createPtOverlay(EventOverlay& overlayRoot)
+{
+    Event::PtOverlay* ptTds = new Event::PtOverlay();
+
+    fillPtOverlay(*ptTds, overlayRoot);
+
+    return ptTds;
+}
+
+DataObject* OverlayTdsFill::createSrcOverlay(EventOverlay& overlayRoot)
+{
+    Event::SrcOverlay* overlayTds = new Event::SrcOverlay();
+
+    fillSrcOverlay(*overlayTds, overlayRoot);
+
+    return overlayTds;
+}
@@ -0,0 +1,61 @@
+/** @file OverlayTdsFill.h
+
+    @brief declaration of the functions which build the TDS overlay objects from an input EventOverlay
+
+$Header$
+
+*/
+
+#ifndef OverlayTdsFill_h
+#define OverlayTdsFill_h
+
+#include "GaudiKernel/ClassID.h"
+
+class DataObject;
+class EventOverlay;
+class OverlayColumns;
+class OverlayEventView;
+class OverlaySnapshot;
+class OverlayReadCuts;
+
+/** @namespace OverlayTdsFill
+    @brief Builds the TDS overlay objects from the input EventOverlay (and the columns of a columnar input
+           or the records of a snapshot input)
+
+    These are shared by the individual converters, which call them when their path is first accessed,
+    and by OverlayCnvSvc which, with BulkConvert set, builds all of an input's collections in one go
+    when its EventOverlay header is loaded. With ReuseOverlayTree set OverlayDataSvc keeps the TDS 
+    objects from one event to the next and uses refill and clear on them. fillEventView serves the
+    data service's OverlayEventView.
+*/
+namespace OverlayTdsFill
+{
+    /// Build the TDS object of the given class id, returns zero if the class id is not an overlay daughter
+    DataObject* create(const CLID& clID, EventOverlay& overlayRoot, const OverlayColumns* columns, const OverlaySnapshot* snapshot, const OverlayReadCuts& cuts);
+
+    /// Refill an existing TDS object (header or daughter) from the input, returns false if objects of
+    /// its type cannot be emptied, they must be replaced by a new object instead
+    bool refill(DataObject* object, EventOverlay& overlayRoot, const OverlayColumns* columns, const OverlaySnapshot* snapshot, const OverlayReadCuts& cuts);
+
+    /// Empty a collection in place, returns false if the object is not one of the collections
+    bool clear(DataObject* object);
+
+    /// Fill the structure of arrays view of the Tkr, Cal and Acd data from the input, with the 
+    /// same cuts and values as the collections but without building them
+    void fillEventView(OverlayEventView& view, EventOverlay& overlayRoot, const OverlayColumns* columns, const OverlaySnapshot* snapshot, const OverlayReadCuts& cuts);
+
+    /// Build the EventOverlay header object
+    DataObject* createEventOverlay(EventOverlay& overlayRoot);
+
+    /// Build the subsystem collections, objects rejected by the cuts are skipped and a subsystem
+    /// no consumer needs gives an empty collection
+    DataObject* createTkrOverlayCol(EventOverlay& overlayRoot, const OverlayColumns* columns, const OverlaySnapshot* snapshot, const OverlayReadCuts& cuts);
+    DataObject* createCalOverlayCol(EventOverlay& overlayRoot, const OverlayColumns* columns, const OverlaySnapshot* snapshot, const OverlayReadCuts& cuts);
+    DataObject* createAcdOverlayCol(EventOverlay& overlayRoot, const OverlayColumns* columns, const OverlaySnapshot* snapshot, const OverlayReadCuts& cuts);
+    DataObject* createGemOverlay(EventOverlay& overlayRoot);
+    DataObject* createDiagDataOverlay(EventOverlay& overlayRoot);
+    DataObject* createPtOverlay(EventOverlay& overlayRoot);
+    DataObject* createSrcOverlay(EventOverlay& overlayRoot);
+}
+
+#endif
@@ -0,0 +1,236 @@
+/**  @file CalDiodeLightCheck.cxx
+@brief Standalone check and timing of CalDiodeLightKernel against the code it replaced
+
+Computes the light seen by the diodes for random hits with the per hit Hep3Vector code
+CalOverlayMergeAlg used before CalDiodeLightKernel (the few Hep3Vector operations it needs are
+reproduced below as CLHEP implements them, so no CLHEP is needed), then with the kernel's scalar
+and, if the processor has it, AVX2 versions. Every total and direct energy must be identical.
+Some hits are placed exactly on a diode centre to exercise the zero length line. Needs no Gaudi,
+build and run from the package root with
+
+    g++ -O2 -I src/MergeAlgs src/test/standalone/CalDiodeLightCheck.cxx src/MergeAlgs/CalDiodeLightKernel.cxx -o CalDiodeLightCheck
+    ./CalDiodeLightCheck
+
+The exit status is non zero if any value differs.
+
+$Header$
+*/
+
+#include "CalDiodeLightKernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+namespace
+{
+    enum {NumHits = 200000, NumXtals = 64, NumDiodes = CalDiodeLightKernel::NumDiodes};
+
+    /// The Hep3Vector operations used by the original code, as CLHEP does them
+    struct Vector3
+    {
+        Vector3(double x = 0., double y = 0., double z = 0.) : m_x(x), m_y(y), m_z(z) {}
+
+        double mag2() const {return m_x*m_x + m_y*m_y + m_z*m_z;}
+        double mag()  const {return std::sqrt(mag2());}
+        double dot(const Vector3& other) const {return m_x*other.m_x + m_y*other.m_y + m_z*other.m_z;}
+
+        Vector3 unit() const
+        {
+            double  tot = mag2();
+            Vector3 p(m_x, m_y, m_z);
+
+            if (tot > 0.0)
+            {
+                double s = 1.0 / std::sqrt(tot);
+
+                p.m_x *= s;
+                p.m_y *= s;
+                p.m_z *= s;
+            }
+
+            return p;
+        }
+
+        Vector3 operator-(const Vector3& other) const {return Vector3(m_x - other.m_x, m_y - other.m_y, m_z - other.m_z);}
+
+        double m_x;
+        double m_y;
+        double m_z;
+    };
+
+    /// The diode loop of CalOverlayMergeAlg before the kernel, for one hit
+    void originalDiodeLight(const Vector3& globalHit, const Vector3& localHit, double energy,
+                            const CalDiodeLightKernel::Diodes& diodes, const std::vector<double>& diodeHeights,
+                            double diodeWidth, double* totalDepE, double* directDepE)
+    {
+        for(int diode = 0; diode < NumDiodes; diode++)
+        {
+            Vector3 diodeTrans(diodes.x[diode], diodes.y[diode], diodes.z[diode]);
+            Vector3 diodeNrml(diodes.nrmlX[diode], diodes.nrmlY[diode], diodes.nrmlZ[diode]);
+
+            double diodeFaceAlpha = 2. * diodeHeights[diode];
+            double diodeFaceBeta  = 2. * diodeWidth;
+
+            Vector3 lineToCenter = globalHit - diodeTrans;
+            double  distToCenter = lineToCenter.mag();
+            double  cosTheta     = lineToCenter.unit().dot(diodeNrml);
+
+            if (cosTheta < 0.) cosTheta *= -1.;
+
+            double diodeFaceBetaPr = diodeFaceBeta * cosTheta;
+            double radical         = (4.*distToCenter*distToCenter + diodeFaceAlpha*diodeFaceAlpha)
+                                   * (4.*distToCenter*distToCenter + diodeFaceBetaPr*diodeFaceBetaPr);
+            double aSinArg         = diodeFaceAlpha * diodeFaceBetaPr / sqrt(radical);
+            double fracAngle       = asin(aSinArg) / M_PI;
+            double directFrac      = 0.;
+            double totalDep        = 0.;
+
+            if (distToCenter < 30.)
+            {
+                double dist2Side = std::max(0., 13.5 -fabs(localHit.m_y));
+                double dist2End  = std::max(0., 165.-fabs(localHit.m_x));
+
+                directFrac += fracAngle;
+
+                if(dist2End < 30)
+                {
+                    double attenFactor = ((30. - dist2End) * (std::max(0., 13.5-dist2Side)))/ (30.*13.5);
+                    totalDep += 1. - .33*attenFactor * attenFactor;
+                }
+                else
+                {
+                    totalDep   += 1.;
+                    directFrac += fracAngle;
+                }
+            }
+            else
+            {
+                directFrac += fracAngle;
+                totalDep   += 1.;
+            }
+
+            directDepE[diode] = energy * directFrac;
+            totalDepE[diode]  = energy * totalDep;
+        }
+    }
+
+    double uniform(double low, double high)
+    {
+        return low + (high - low) * rand() / (double)RAND_MAX;
+    }
+
+    /// Equal, or both not a number
+    bool same(double first, double second)
+    {
+        return first == second || (first != first && second != second);
+    }
+}
+
+int main()
+{
+    srand(1);
+
+    // Random diodes at the crystal ends, normals along x into the crystal
+    std::vector<CalDiodeLightKernel::Diodes> xtals(NumXtals);
+
+    for(int xtal = 0; xtal < NumXtals; xtal++)
+    {
+        for(int diode = 0; diode < NumDiodes; diode++)
+        {
+            xtals[xtal].x[diode]     = uniform(-180., 180.);
+            xtals[xtal].y[diode]     = uniform(-20., 20.);
+            xtals[xtal].z[diode]     = uniform(-5., 5.);
+            xtals[xtal].nrmlX[diode] = (diode & 1) ? 1. : -1.;
+            xtals[xtal].nrmlY[diode] = 0.;
+            xtals[xtal].nrmlZ[diode] = 0.;
+        }
+    }
+
+    std::vector<double> diodeHeights(NumDiodes);
+
+    diodeHeights[0] = diodeHeights[1] = 2.5;
+    diodeHeights[2] = diodeHeights[3] = 5.;
+
+    double diodeWidth = 3.;
+
+    std::vector<Vector3> globalHits(NumHits);
+    std::vector<Vector3> localHits(NumHits);
+    std::vector<double>  energies(NumHits);
+
+    for(int hit = 0; hit < NumHits; hit++)
+    {
+        const CalDiodeLightKernel::Diodes& diodes = xtals[hit % NumXtals];
+
+        globalHits[hit] = Vector3(uniform(-190., 190.), uniform(-25., 25.), uniform(-10., 10.));
+
+        if (hit % 97 == 0) globalHits[hit] = Vector3(diodes.x[0], diodes.y[0], diodes.z[0]);
+
+        localHits[hit] = Vector3(uniform(-170., 170.), uniform(-14., 14.), uniform(-10., 10.));
+        energies[hit]  = uniform(0., 100.);
+    }
+
+    // The original code
+    std::vector<double> totalDepE(NumHits * NumDiodes);
+    std::vector<double> directDepE(NumHits * NumDiodes);
+
+    clock_t start = clock();
+
+    for(int hit = 0; hit < NumHits; hit++)
+    {
+        originalDiodeLight(globalHits[hit], localHits[hit], energies[hit], xtals[hit % NumXtals], diodeHeights, diodeWidth,
+                           &totalDepE[hit * NumDiodes], &directDepE[hit * NumDiodes]);
+    }
+
+    printf("original: %.2f ms\n", 1.e3 * (clock() - start) / CLOCKS_PER_SEC);
+
+    // And the kernel, both versions
+    CalDiodeLightKernel kernel;
+
+    kernel.setDiodeFaces(diodeHeights, diodeWidth);
+
+    bool hasAvx2 = kernel.usingAvx2();
+    int  numDiffering = 0;
+
+    if (!hasAvx2) printf("no AVX2 on this processor (or compiler), checking the scalar version only\n");
+
+    for(int version = 0; version < (hasAvx2 ? 2 : 1); version++)
+    {
+        kernel.useAvx2(version == 1);
+        kernel.clear();
+
+        for(int hit = 0; hit < NumHits; hit++)
+        {
+            kernel.addHit(globalHits[hit].m_x, globalHits[hit].m_y, globalHits[hit].m_z, localHits[hit].m_x, localHits[hit].m_y,
+                          energies[hit], &xtals[hit % NumXtals]);
+        }
+
+        // The first run sizes the result arrays, time the second
+        kernel.run();
+
+        start = clock();
+
+        kernel.run();
+
+        double milliSecs = 1.e3 * (clock() - start) / CLOCKS_PER_SEC;
+        int    numDiffer = 0;
+
+        for(int hit = 0; hit < NumHits; hit++)
+        {
+            for(int diode = 0; diode < NumDiodes; diode++)
+            {
+                if (!same(kernel.totalDepE(hit, diode),  totalDepE[hit * NumDiodes + diode]))  numDiffer++;
+                if (!same(kernel.directDepE(hit, diode), directDepE[hit * NumDiodes + diode])) numDiffer++;
+            }
+        }
+
+        printf("%s: %.2f ms, differing values %d\n", version == 1 ? "AVX2" : "scalar", milliSecs, numDiffer);
+
+        numDiffering += numDiffer;
+    }
+
+    return numDiffering > 0 ? 1 : 0;
+}
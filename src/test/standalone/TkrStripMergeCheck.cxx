@@ -0,0 +1,188 @@
+/**  @file TkrStripMergeCheck.cxx
+@brief Standalone check and timing of the tracker strip merge of TkrOverlayMergeAlg
+
+Merges random simulated and overlay strip sets with the original per strip search and insert,
+the sorted list merge and the TkrStripBitmap union (with its fall back to the list merge on quiet
+planes), as TkrOverlayMergeAlg::mergeStrips does them. Checks that all three give the same strips
+and the same last controller 0 strip for every plane and prints the time per plane at a few
+occupancies. Needs no Gaudi, build and run from the package root with
+
+    g++ -O2 -I src/MergeAlgs src/test/standalone/TkrStripMergeCheck.cxx -o TkrStripMergeCheck
+    ./TkrStripMergeCheck
+
+The exit status is non zero if any plane differs.
+
+$Header$
+*/
+
+#include "TkrStripBitmap.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <vector>
+
+namespace
+{
+    typedef std::vector<int>            StripList;
+    typedef std::vector<unsigned short> OverlayStrips;
+
+    /// As in TkrOverlayMergeAlg
+    enum {MinBitmapStrips = 64, BreakPoint = 768, NumPlanes = 20000};
+
+    /// The original merge, each overlay strip searched for and inserted
+    void insertMerge(StripList& strips, const OverlayStrips& overStrips, int& lastStrip0)
+    {
+        for(OverlayStrips::const_iterator overIter = overStrips.begin(); overIter != overStrips.end(); overIter++)
+        {
+            int overStripId = *overIter;
+
+            if (overStripId < BreakPoint && overStripId > lastStrip0) lastStrip0 = overStripId;
+
+            StripList::iterator stripIter = strips.begin();
+
+            while(stripIter != strips.end() && *stripIter < overStripId) stripIter++;
+
+            if (stripIter == strips.end() || *stripIter != overStripId) strips.insert(stripIter, overStripId);
+        }
+    }
+
+    /// Append, merge the two ordered runs and drop duplicates
+    void listMerge(StripList& strips, const OverlayStrips& overStrips, int& lastStrip0)
+    {
+        StripList::difference_type numSimStrips = strips.size();
+
+        for(OverlayStrips::const_iterator overIter = overStrips.begin(); overIter != overStrips.end(); overIter++)
+        {
+            int overStripId = *overIter;
+
+            if (overStripId < BreakPoint && overStripId > lastStrip0) lastStrip0 = overStripId;
+
+            strips.push_back(overStripId);
+        }
+
+        StripList::iterator simEnd = strips.begin() + numSimStrips;
+
+        if (std::adjacent_find(strips.begin(), simEnd,       std::greater<int>()) == simEnd &&
+            std::adjacent_find(simEnd,         strips.end(), std::greater<int>()) == strips.end())
+        {
+            std::inplace_merge(strips.begin(), simEnd, strips.end());
+        }
+        else std::sort(strips.begin(), strips.end());
+
+        strips.erase(std::unique(strips.begin(), strips.end()), strips.end());
+    }
+
+    /// The bitmap union on busy planes, the list merge otherwise
+    void bitmapMerge(StripList& strips, const OverlayStrips& overStrips, int& lastStrip0)
+    {
+        if (strips.size() + overStrips.size() >= MinBitmapStrips)
+        {
+            TkrStripBitmap simBits;
+            TkrStripBitmap overBits;
+
+            if (simBits.set(strips.begin(), strips.end()) && overBits.set(overStrips.begin(), overStrips.end()))
+            {
+                int overLastStrip0 = overBits.highestBelow(BreakPoint);
+
+                if (overLastStrip0 > lastStrip0) lastStrip0 = overLastStrip0;
+
+                simBits |= overBits;
+
+                strips.resize(simBits.count());
+                simBits.strips(strips.begin());
+
+                return;
+            }
+        }
+
+        listMerge(strips, overStrips, lastStrip0);
+    }
+
+    /// About numHits distinct random strips, in order
+    void randomPlane(StripList& strips, int numHits)
+    {
+        std::vector<char> hit(TkrStripBitmap::NumStrips, 0);
+
+        for(int idx = 0; idx < numHits; idx++) hit[rand() % TkrStripBitmap::NumStrips] = 1;
+
+        strips.clear();
+
+        for(int strip = 0; strip < TkrStripBitmap::NumStrips; strip++) if (hit[strip]) strips.push_back(strip);
+    }
+
+    typedef void (*MergeFunction)(StripList&, const OverlayStrips&, int&);
+}
+
+int main()
+{
+    const int     occupancies[] = {8, 64, 256, 768};
+    MergeFunction merges[]      = {insertMerge, listMerge, bitmapMerge};
+    const char*   names[]       = {"insert", "list merge", "bitmap"};
+
+    int numDiffering = 0;
+
+    srand(1);
+
+    for(int occIdx = 0; occIdx < 4; occIdx++)
+    {
+        std::vector<StripList>     simPlanes(NumPlanes);
+        std::vector<OverlayStrips> overPlanes(NumPlanes);
+
+        for(int plane = 0; plane < NumPlanes; plane++)
+        {
+            StripList overStrips;
+
+            randomPlane(simPlanes[plane], occupancies[occIdx]);
+            randomPlane(overStrips,       occupancies[occIdx]);
+
+            overPlanes[plane].assign(overStrips.begin(), overStrips.end());
+        }
+
+        std::vector<StripList> results[3];
+        std::vector<int>       lastStrips[3];
+
+        printf("occupancy %4d:", occupancies[occIdx]);
+
+        for(int mergeIdx = 0; mergeIdx < 3; mergeIdx++)
+        {
+            results[mergeIdx]    = simPlanes;
+            lastStrips[mergeIdx].assign(NumPlanes, 0);
+
+            for(int plane = 0; plane < NumPlanes; plane++)
+            {
+                lastStrips[mergeIdx][plane] = simPlanes[plane].empty() ? -1 : 700;
+            }
+
+            clock_t start = clock();
+
+            for(int plane = 0; plane < NumPlanes; plane++)
+            {
+                merges[mergeIdx](results[mergeIdx][plane], overPlanes[plane], lastStrips[mergeIdx][plane]);
+            }
+
+            double microSecs = 1.e6 * (clock() - start) / CLOCKS_PER_SEC / NumPlanes;
+
+            printf("  %s %.2f us", names[mergeIdx], microSecs);
+        }
+
+        int numDiffer = 0;
+
+        for(int plane = 0; plane < NumPlanes; plane++)
+        {
+            for(int mergeIdx = 1; mergeIdx < 3; mergeIdx++)
+            {
+                if (results[mergeIdx][plane]    != results[0][plane] ||
+                    lastStrips[mergeIdx][plane] != lastStrips[0][plane]) numDiffer++;
+            }
+        }
+
+        printf("  differing planes %d\n", numDiffer);
+
+        numDiffering += numDiffer;
+    }
+
+    return numDiffering > 0 ? 1 : 0;
+}